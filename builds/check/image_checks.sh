@@ -0,0 +1,232 @@
+#!/bin/bash
+# Trevor SANDY
+# Last Update October 19, 2019
+# Copyright (c) 2019 by Trevor SANDY
+# LPub3D Unix native renderer image checks
+# NOTE: Run with variables as appropriate:
+#       $LPUB3D_EXE = <LPub3D executable>,
+#       $SOURCE_DIR = <lpub3d source folder>,
+#       $XMING = true
+#
+# A check model is rendered with the native renderer once for each entry
+# of LP3D_IMAGE_RENDERS, clearing the image caches every time.  Each check
+# compares every assembly and part image of one render with the image of
+# the same name in another.  The mean difference of all colour channels and
+# the share of pixels with a channel more than 64 levels apart must stay
+# within the limits of the check, in percent.
+#
+#   software   --software-render draws with the software rasterizer
+#              against OpenGL framebuffers
+#   batch      conditional lines tested in one batch per mesh section
+#              against the same lines tested and drawn one by one; the
+#              logged line counts of both renders are printed
+#   size       image_checks.mpd, a baseplate, stud heavy plates and curved
+#              parts, with the mesh detail picked by its size in the image
+#              against the high detail only, at CSI and PLI sizes; the
+#              size render also runs --lod-check and fails on any
+#              primitive whose low detail version does not match its files
+
+# Initialize platform variables
+LP3D_OS_NAME=$(uname)
+
+# Initialize XVFB
+if [[ "${XMING}" != "true" && ("${DOCKER}" = "true" || ("${LP3D_OS_NAME}" != "Darwin")) ]]; then
+    echo && echo "- Using XVFB from working directory: ${PWD}"
+    USE_XVFB="true"
+fi
+
+# Initialize variables
+LP3D_CHECK_DIR="$(realpath ${SOURCE_DIR})/builds/check"
+LP3D_CHECK_CACHE="${LP3D_CHECK_DIR}/LPub3D"
+LP3D_IMAGE_DIR="${LP3D_CHECK_DIR}/image"
+# name|model|options
+LP3D_IMAGE_RENDERS=("reference|build_checks.mpd|" "software|build_checks.mpd|--software-render" \
+                    "line|build_checks.mpd|--conditional-lines line" "batch|build_checks.mpd|--conditional-lines batch" \
+                    "high|image_checks.mpd|--native-lod high" "size|image_checks.mpd|--native-lod size --lod-check")
+# name|reference name|mean difference %|differing pixels %
+LP3D_IMAGE_CHECKS=("software|reference|3.0|6.0" "batch|line|0.0|0.0" "size|high|1.0|2.0")
+LP3D_LOD_FAILED="Primitive LOD check failed"
+LP3D_LOG_FILE="ImageCheck.out"
+let LP3D_CHECK_FAIL=0
+
+echo && echo "------------Image Checks Start--------------" && echo
+
+# The package scripts pass the executable name
+[ -f "${LPUB3D_EXE}" ] || LPUB3D_EXE=$(command -v "${LPUB3D_EXE}")
+if [ ! -f "${LPUB3D_EXE}" ]; then
+    echo "ERROR - LPub3D executable '${LPUB3D_EXE}' not found."
+    exit 1
+fi
+
+rm -rf "${LP3D_IMAGE_DIR}" && mkdir -p "${LP3D_IMAGE_DIR}"
+
+# Run LPub3D once, under XVFB when it is used
+# arguments: LPub3D options
+function run_lpub3d()
+{
+    if [ -n "$USE_XVFB" ]; then
+        xvfb-run --auto-servernum --server-num=1 --server-args="-screen 0 1024x768x24" \
+        ${LPUB3D_EXE} "$@" &> ${LP3D_LOG_FILE}
+    else
+        ${LPUB3D_EXE} "$@" &> ${LP3D_LOG_FILE}
+    fi
+}
+
+# Render a check model and keep its images
+# arguments: image folder name, check model, LPub3D options
+function render_images()
+{
+    local name=$1
+    local model=$2
+    shift 2
+    rm -rf "${LP3D_CHECK_CACHE}/assem" "${LP3D_CHECK_CACHE}/parts"
+    run_lpub3d --no-stdout-log --process-file --clear-cache --liblego --preferred-renderer native "$@" "${LP3D_CHECK_DIR}/${model}"
+    local exit_code=$?
+    mkdir -p "${LP3D_IMAGE_DIR}/${name}"
+    for folder in assem parts; do
+        if [ -d "${LP3D_CHECK_CACHE}/${folder}" ]; then
+            mkdir -p "${LP3D_IMAGE_DIR}/${name}/${folder}"
+            cp -f "${LP3D_CHECK_CACHE}/${folder}/"*.png "${LP3D_IMAGE_DIR}/${name}/${folder}/" 2> /dev/null
+        fi
+    done
+    if [ "${exit_code}" != "0" ] || [ -z "$(find "${LP3D_IMAGE_DIR}/${name}" -name '*.png')" ]; then
+        echo "- ${name}: FAILED - exit code ${exit_code}, no images rendered"
+        echo "- LPub3D Log Trace: ${LP3D_LOG_FILE}"
+        cat "${LP3D_LOG_FILE}"
+        return 1
+    fi
+    mv -f "${LP3D_LOG_FILE}" "${LP3D_IMAGE_DIR}/${name}.log"
+    return 0
+}
+
+# Compare the images of a check with the reference images
+# arguments: check folder name, reference folder name, mean difference %, differing pixels %
+function compare_images()
+{
+    python3 - "${LP3D_IMAGE_DIR}/$2" "${LP3D_IMAGE_DIR}/$1" "$3" "$4" <<'EOF'
+import os, struct, sys, zlib
+
+reference, check, max_mean, max_pixels = sys.argv[1], sys.argv[2], float(sys.argv[3]), float(sys.argv[4])
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    return a if pa <= pb and pa <= pc else (b if pb <= pc else c)
+
+# 8 bit RGB or RGBA PNG to rows of RGBA pixels
+def read_png(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    idat, pos = b"", 8
+    while pos + 8 <= len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        if kind == b"IHDR":
+            width, height, depth, colour = struct.unpack(">IIBB", chunk[:10])
+        elif kind == b"IDAT":
+            idat += chunk
+        pos += length + 12
+    if depth != 8 or colour not in (2, 6):
+        raise ValueError("unsupported PNG format in %s" % path)
+    channels = 4 if colour == 6 else 3
+    stride = width * channels
+    raw = zlib.decompress(idat)
+    rows, previous = [], bytearray(stride)
+    for y in range(height):
+        kind = raw[y * (stride + 1)]
+        line = bytearray(raw[y * (stride + 1) + 1:(y + 1) * (stride + 1)])
+        for x in range(stride):
+            a = line[x - channels] if x >= channels else 0
+            b = previous[x]
+            c = previous[x - channels] if x >= channels else 0
+            if kind == 1:
+                line[x] = (line[x] + a) & 0xff
+            elif kind == 2:
+                line[x] = (line[x] + b) & 0xff
+            elif kind == 3:
+                line[x] = (line[x] + ((a + b) >> 1)) & 0xff
+            elif kind == 4:
+                line[x] = (line[x] + paeth(a, b, c)) & 0xff
+        previous = line
+        if channels == 3:
+            line = bytearray(b"".join(bytes(line[x:x + 3]) + b"\xff" for x in range(0, stride, 3)))
+        rows.append(line)
+    return width, height, rows
+
+failed = 0
+for folder in ("assem", "parts"):
+    path = os.path.join(reference, folder)
+    if not os.path.isdir(path):
+        continue
+    for name in sorted(os.listdir(path)):
+        if not name.lower().endswith(".png"):
+            continue
+        image = os.path.join(check, folder, name)
+        if not os.path.isfile(image):
+            print("    %s/%s: MISSING" % (folder, name))
+            failed += 1
+            continue
+        rw, rh, rrows = read_png(os.path.join(path, name))
+        cw, ch, crows = read_png(image)
+        # bounds are cropped to the drawn pixels, so allow a pixel or two
+        if abs(rw - cw) > 2 or abs(rh - ch) > 2:
+            print("    %s/%s: FAILED - %dx%d against %dx%d" % (folder, name, cw, ch, rw, rh))
+            failed += 1
+            continue
+        width, height = min(rw, cw), min(rh, ch)
+        total, differing = 0, 0
+        for y in range(height):
+            rrow, crow = rrows[y], crows[y]
+            for x in range(width * 4):
+                total += abs(rrow[x] - crow[x])
+            for x in range(0, width * 4, 4):
+                if max(abs(rrow[x + c] - crow[x + c]) for c in range(4)) > 64:
+                    differing += 1
+        mean = total * 100.0 / (255.0 * width * height * 4)
+        share = differing * 100.0 / (width * height)
+        status = "PASSED" if mean <= max_mean and share <= max_pixels else "FAILED"
+        if status == "FAILED":
+            failed += 1
+        print("    %-40s %6.2f%% mean %6.2f%% pixels %s" % ("%s/%s" % (folder, name), mean, share, status))
+
+sys.exit(1 if failed else 0)
+EOF
+}
+
+for LP3D_IMAGE_RENDER in "${LP3D_IMAGE_RENDERS[@]}"; do
+    IFS="|" read -r LP3D_NAME LP3D_MODEL LP3D_OPTIONS <<< "${LP3D_IMAGE_RENDER}"
+    render_images ${LP3D_NAME} ${LP3D_MODEL} ${LP3D_OPTIONS} || let LP3D_CHECK_FAIL++
+    if grep -q "${LP3D_LOD_FAILED}" "${LP3D_IMAGE_DIR}/${LP3D_NAME}.log" 2> /dev/null; then
+        grep "${LP3D_LOD_FAILED}" "${LP3D_IMAGE_DIR}/${LP3D_NAME}.log" | sed "s/^/    /"
+        echo "- ${LP3D_NAME}: FAILED - primitive LOD check"
+        let LP3D_CHECK_FAIL++
+    fi
+    if grep -q "conditional lines" "${LP3D_IMAGE_DIR}/${LP3D_NAME}.log" 2> /dev/null; then
+        grep -o "conditional lines .* ms" "${LP3D_IMAGE_DIR}/${LP3D_NAME}.log" | \
+        sed -E 's/.*: ([0-9]+) of ([0-9]+) drawn, tested in ([0-9.]+) ms/\1 \2 \3/' | \
+        awk -v name="${LP3D_NAME}" '{ drawn += $1; tested += $2; ms += $3; images++ }
+            END { printf "    %s: %d images, %d of %d conditional lines drawn, tested in %.3f ms\n", name, images, drawn, tested, ms }'
+    fi
+done
+
+for LP3D_IMAGE_CHECK in "${LP3D_IMAGE_CHECKS[@]}"; do
+    IFS="|" read -r LP3D_NAME LP3D_REFERENCE LP3D_MAX_MEAN LP3D_MAX_PIXELS <<< "${LP3D_IMAGE_CHECK}"
+    if [ ! -f "${LP3D_IMAGE_DIR}/${LP3D_NAME}.log" ] || [ ! -f "${LP3D_IMAGE_DIR}/${LP3D_REFERENCE}.log" ]; then
+        echo "- ${LP3D_NAME} against ${LP3D_REFERENCE}: SKIPPED - render failed"
+        continue
+    fi
+    if compare_images ${LP3D_NAME} ${LP3D_REFERENCE} ${LP3D_MAX_MEAN} ${LP3D_MAX_PIXELS}; then
+        echo "- ${LP3D_NAME} against ${LP3D_REFERENCE}: PASSED"
+    else
+        echo "- ${LP3D_NAME} against ${LP3D_REFERENCE}: FAILED"
+        let LP3D_CHECK_FAIL++
+    fi
+done
+
+if [ "${LP3D_CHECK_FAIL}" = "0" ]; then
+    echo && echo "----Image Check Completed: PASSED----" && echo
+else
+    echo && echo "----Image Check Completed: FAILED (${LP3D_CHECK_FAIL})----" && echo
+fi
+
+exit $([ "${LP3D_CHECK_FAIL}" = "0" ] && echo 0 || echo 1)
@@ -0,0 +1,79 @@
+#!/bin/bash
+# Trevor SANDY
+# Last Update October 19, 2019
+# Copyright (c) 2019 by Trevor SANDY
+# LPub3D Unix page index checks
+# NOTE: Run with variables as appropriate:
+#       $LPUB3D_EXE = <LPub3D executable>,
+#       $SOURCE_DIR = <lpub3d source folder>,
+#       $XMING = true
+#
+# Each check model is processed with --index-check.  LPub3D then counts
+# the pages from the page index and again with a full findPage walk, and
+# logs whether the page count and the top of every page agree.
+# index_checks.mpd has a step for each meta the page index classifies, so
+# a change to the Meta grammar the index does not follow shows up here.
+
+# Initialize platform variables
+LP3D_OS_NAME=$(uname)
+
+# Initialize XVFB
+if [[ "${XMING}" != "true" && ("${DOCKER}" = "true" || ("${LP3D_OS_NAME}" != "Darwin")) ]]; then
+    echo && echo "- Using XVFB from working directory: ${PWD}"
+    USE_XVFB="true"
+fi
+
+# Initialize variables
+LP3D_CHECK_DIR="$(realpath ${SOURCE_DIR})/builds/check"
+LP3D_CHECK_MODELS=("liblego index_checks.mpd" "liblego build_checks.mpd" \
+                   "libtente TENTE/astromovil.ldr" "libvexiq VEXIQ/spider.mpd")
+LP3D_CHECK_PASSED="Page index check passed"
+LP3D_LOG_FILE="IndexCheck.out"
+let LP3D_CHECK_FAIL=0
+
+echo && echo "------------Page Index Checks Start--------------" && echo
+
+# The package scripts pass the executable name
+[ -f "${LPUB3D_EXE}" ] || LPUB3D_EXE=$(command -v "${LPUB3D_EXE}")
+if [ ! -f "${LPUB3D_EXE}" ]; then
+    echo "ERROR - LPub3D executable '${LPUB3D_EXE}' not found."
+    exit 1
+fi
+
+# Run LPub3D once, under XVFB when it is used
+# arguments: LPub3D options
+function run_lpub3d()
+{
+    if [ -n "$USE_XVFB" ]; then
+        xvfb-run --auto-servernum --server-num=1 --server-args="-screen 0 1024x768x24" \
+        ${LPUB3D_EXE} "$@" &> ${LP3D_LOG_FILE}
+    else
+        ${LPUB3D_EXE} "$@" &> ${LP3D_LOG_FILE}
+    fi
+}
+
+for LP3D_CHECK_MODEL in "${LP3D_CHECK_MODELS[@]}"; do
+    read -r LP3D_LIBRARY LP3D_MODEL <<< "${LP3D_CHECK_MODEL}"
+
+    run_lpub3d --no-stdout-log --index-check --process-file --preferred-renderer native \
+               --${LP3D_LIBRARY} "${LP3D_CHECK_DIR}/${LP3D_MODEL}"
+    LP3D_EXIT=$?
+
+    if [ "${LP3D_EXIT}" = "0" ] && grep -q "${LP3D_CHECK_PASSED}" "${LP3D_LOG_FILE}"; then
+        echo "- ${LP3D_MODEL}: PASSED ($(grep -o "${LP3D_CHECK_PASSED} - [0-9]* pages" "${LP3D_LOG_FILE}" | head -1 | cut -d ' ' -f 6) pages)"
+    else
+        echo "- ${LP3D_MODEL}: FAILED (exit code ${LP3D_EXIT})"
+        echo "- LPub3D Log Trace: ${LP3D_LOG_FILE}"
+        cat "${LP3D_LOG_FILE}"
+        let LP3D_CHECK_FAIL++
+    fi
+    rm -f "${LP3D_LOG_FILE}"
+done
+
+if [ "${LP3D_CHECK_FAIL}" = "0" ]; then
+    echo && echo "----Page Index Check Completed: PASSED----" && echo
+else
+    echo && echo "----Page Index Check Completed: FAILED (${LP3D_CHECK_FAIL})----" && echo
+fi
+
+exit $([ "${LP3D_CHECK_FAIL}" = "0" ] && echo 0 || echo 1)
@@ -0,0 +1,158 @@
+#!/bin/bash
+# Trevor SANDY
+# Last Update October 19, 2019
+# Copyright (c) 2019 by Trevor SANDY
+# LPub3D Unix model loader checks
+# NOTE: Run with variables as appropriate:
+#       $LPUB3D_EXE = <LPub3D executable>,
+#       $SOURCE_DIR = <lpub3d source folder>,
+#       $XMING = true,
+#       $LP3D_LOAD_MODELS = "<submodels>x<steps>x<parts> ..."  [default "10x20x8 200x50x20"]
+#
+# Every model is written four ways - LF, CRLF and lone CR line endings,
+# and CRLF behind a UTF-8 byte order mark - and all of them must load to
+# the same page and part counts.  The models are build_checks.mpd and
+# synthetic MPDs from LP3D_LOAD_MODELS, each entry being the number of
+# submodels x steps per submodel x parts per step, so the load time of
+# LDrawFile::loadFile is reported from a small model to a very large one.
+# The models are processed in one LPub3D run with --batch-manifest and
+# --performance-trace; only page 1 of each is exported.
+
+# Initialize platform variables
+LP3D_OS_NAME=$(uname)
+
+# Initialize XVFB
+if [[ "${XMING}" != "true" && ("${DOCKER}" = "true" || ("${LP3D_OS_NAME}" != "Darwin")) ]]; then
+    echo && echo "- Using XVFB from working directory: ${PWD}"
+    USE_XVFB="true"
+fi
+
+# Initialize variables
+LP3D_LOAD_DIR="$(realpath ${SOURCE_DIR})/builds/check/load"
+LP3D_LOAD_MANIFEST="${LP3D_LOAD_DIR}/load_manifest.txt"
+LP3D_LOAD_REPORT="${LP3D_LOAD_DIR}/load_report.json"
+LP3D_LOAD_MODELS=${LP3D_LOAD_MODELS:-"10x20x8 200x50x20"}
+LP3D_LOG_FILE="LoadCheck.out"
+
+echo && echo "------------Loader Checks Start--------------" && echo
+
+# The package scripts pass the executable name
+[ -f "${LPUB3D_EXE}" ] || LPUB3D_EXE=$(command -v "${LPUB3D_EXE}")
+if [ ! -f "${LPUB3D_EXE}" ]; then
+    echo "ERROR - LPub3D executable '${LPUB3D_EXE}' not found."
+    exit 1
+fi
+
+rm -rf "${LP3D_LOAD_DIR}" && mkdir -p "${LP3D_LOAD_DIR}"
+
+# Write the models, their line ending variants and the batch manifest
+python3 - "$(realpath ${SOURCE_DIR})/builds/check/build_checks.mpd" "${LP3D_LOAD_DIR}" \
+          "${LP3D_LOAD_MANIFEST}" ${LP3D_LOAD_MODELS} <<'EOF'
+import os, sys
+
+check_model, load_dir, manifest = sys.argv[1:4]
+parts   = ["3001.dat", "3003.dat", "3004.dat", "3010.dat", "3020.dat", "3022.dat", "3023.dat", "3024.dat"]
+colours = [1, 2, 4, 14, 15, 0, 71, 72]
+
+def synthetic(submodels, steps, count):
+    lines = []
+    def header(name):
+        lines.extend(["0 FILE %s" % name, "0 %s" % name[:-4], "0 Name: %s" % name,
+                      "0 Author: LPub3D loader check", "0 !LDRAW_ORG Unofficial_Model", ""])
+    top = "load-%dx%dx%d.ldr" % (submodels, steps, count)
+    header(top)
+    for s in range(submodels):
+        lines.append("1 16 0 %d 0 1 0 0 0 1 0 0 0 1 load-sub-%d.ldr" % (s * -24, s))
+        lines.append("0 STEP")
+    lines.extend(["0 NOFILE", ""])
+    for s in range(submodels):
+        header("load-sub-%d.ldr" % s)
+        for step in range(steps):
+            for p in range(count):
+                lines.append("1 %d %d %d %d 1 0 0 0 1 0 0 0 1 %s" %
+                             (colours[(step + p) % len(colours)], (p % 4) * 40 - 60, step * -24,
+                              (p // 4) * 40, parts[(step * count + p) % len(parts)]))
+            lines.append("0 STEP")
+        lines.extend(["0 NOFILE", ""])
+    return top[:-4], lines
+
+models = []
+with open(check_model) as f:
+    models.append(("build_checks", f.read().splitlines()))
+for entry in sys.argv[4:]:
+    models.append(synthetic(*[int(v) for v in entry.split("x")]))
+
+variants = [("lf", b"", b"\n"), ("crlf", b"", b"\r\n"), ("cr", b"", b"\r"), ("bom", b"\xef\xbb\xbf", b"\r\n")]
+
+with open(manifest, "w") as out:
+    out.write("# LPub3D loader check manifest\n")
+    for name, lines in models:
+        for variant, bom, eol in variants:
+            path = os.path.join(load_dir, "%s-%s.mpd" % (name, variant))
+            with open(path, "wb") as f:
+                f.write(bom + eol.join(line.encode("ascii") for line in lines) + eol)
+            out.write("\"%s\"\n" % path)
+        print("- Generated %s: %d lines, %.1f KB" % (name, len(lines), os.path.getsize(path) / 1024.0))
+EOF
+
+# Process every model in one LPub3D run
+LP3D_LOAD_OPTIONS="--no-stdout-log --liblego --preferred-renderer native --performance-trace"
+LP3D_LOAD_OPTIONS="${LP3D_LOAD_OPTIONS} --process-export --export-option png --range 1 -d ${LP3D_LOAD_DIR}"
+LP3D_LOAD_OPTIONS="${LP3D_LOAD_OPTIONS} --batch-manifest ${LP3D_LOAD_MANIFEST} --batch-report ${LP3D_LOAD_REPORT}"
+
+if [ -n "$USE_XVFB" ]; then
+    xvfb-run --auto-servernum --server-num=1 --server-args="-screen 0 1024x768x24" \
+    ${LPUB3D_EXE} ${LP3D_LOAD_OPTIONS} &> ${LP3D_LOG_FILE}
+else
+    ${LPUB3D_EXE} ${LP3D_LOAD_OPTIONS} &> ${LP3D_LOG_FILE}
+fi
+LP3D_EXIT=$?
+
+if [ ! -f "${LP3D_LOAD_REPORT}" ]; then
+    echo "ERROR - ${LP3D_LOAD_REPORT} not found (exit code ${LP3D_EXIT})."
+    echo "- LPub3D Log Trace: ${LP3D_LOG_FILE}"
+    cat "${LP3D_LOG_FILE}"
+    exit 1
+fi
+rm -rf "${LP3D_LOG_FILE}"
+
+# Compare the variants of each model and report the load times
+python3 - "${LP3D_LOAD_REPORT}" <<'EOF'
+import json, os, sys
+
+with open(sys.argv[1]) as f:
+    report = json.load(f)
+
+groups = {}
+for model in report.get("models", []):
+    name, variant = os.path.basename(model["file"])[:-4].rsplit("-", 1)
+    groups.setdefault(name, []).append((variant, model))
+
+failed = 0
+for name, variants in groups.items():
+    reference = variants[0][1]
+    for variant, model in variants:
+        load = model.get("stages", {}).get("LDrawFile::loadFile", {"ms": 0.0})
+        size = os.path.getsize(model["file"]) / 1048576.0
+        line = "- %-24s %-5s %5d pages %7d parts %10.1f ms load %8.1f MB/s" % \
+               (name, variant, model["pages"], model["parts"], load["ms"],
+                size * 1000.0 / load["ms"] if load["ms"] else 0.0)
+        if model["status"] != "ok":
+            line += " FAILED"
+            failed += 1
+        elif (model["pages"], model["parts"]) != (reference["pages"], reference["parts"]):
+            line += " DIFFERS FROM %s" % variants[0][0].upper()
+            failed += 1
+        print(line)
+
+sys.exit(1 if failed else 0)
+EOF
+LP3D_LOAD_RESULT=$?
+
+if [ "${LP3D_LOAD_RESULT}" = "0" ]; then
+    echo && echo "----Loader Check Completed: PASSED----" && echo
+else
+    echo && echo "----Loader Check Completed: FAILED----" && echo
+fi
+
+exit ${LP3D_LOAD_RESULT}
@@ -0,0 +1,249 @@
+#!/bin/bash
+# Trevor SANDY
+# Last Update October 19, 2019
+# Copyright (c) 2019 by Trevor SANDY
+# LPub3D Unix performance checks
+# NOTE: Run with variables as appropriate:
+#       $LPUB3D_EXE = <LPub3D executable>,
+#       $SOURCE_DIR = <lpub3d source folder>,
+#       $XMING = true,
+#       $LP3D_PERF_BASELINE = <baseline report>                 [default builds/check/perf_baseline.json]
+#       $LP3D_PERF_UPDATE_BASELINE = true                       save this run as the baseline
+#       $LP3D_PERF_TOLERANCE = <percent>                        [default 25]
+#       $LP3D_PERF_MODELS = "<depth>x<steps>x<parts>[cbfhe] ..." [default "1x10x4e 2x20x8c 3x40x8b 3x40x8fh 1x1x5000 1x1000x2"]
+#
+# Synthetic MPD models are generated from LP3D_PERF_MODELS.  Each entry
+# is submodel depth x steps per submodel x parts per step, followed by
+# any of c (callout each submodel), b (BUFEXCHG store and retrieve each
+# step), f (fade previous steps), h (highlight current step) and e (a bill
+# of materials page with the LEGO element of each part).
+# The models use only common LDraw parts so the checks run offline
+# against the installed LDraw library.  They are processed in a single
+# LPub3D run with --batch-manifest and --performance-trace, and the time
+# per call of each traced stage (findPage, drawPage, writeToTmp,
+# Step::createCsi, Render::rotateParts, Pli::sortParts, renderCsi,
+# LDrawFile::loadFile, lcPiecesLibrary::LoadPieceData,
+# lcZipFile::ExtractFile...) is compared with the baseline report.
+# The archive extraction time is also given as a share of the part
+# loading time.  The 1x1x5000 model is a single 5000 part
+# step, for which the parts per millisecond of the batched transform in
+# Render::rotateParts(parts) is also reported.  For fade models the
+# lines and bytes of the faded previous step lines kept by
+# Gui::configureModelStep, which hold one step per submodel, are listed
+# with its time per step.  Each model also lists the memory of its 3DViewer
+# step contents against the same contents kept in full for every step,
+# the 1x1000x2 model giving the figures for a 1000 step model.  For e
+# models the annotation tables are timed as they load, split into
+# mapping a compiled table and compiling one from its text file, and per
+# element lookup.
+
+# Initialize platform variables
+LP3D_OS_NAME=$(uname)
+
+# Initialize XVFB
+if [[ "${XMING}" != "true" && ("${DOCKER}" = "true" || ("${LP3D_OS_NAME}" != "Darwin")) ]]; then
+    echo && echo "- Using XVFB from working directory: ${PWD}"
+    USE_XVFB="true"
+fi
+
+# Initialize variables
+LP3D_PERF_DIR="$(realpath ${SOURCE_DIR})/builds/check/perf"
+LP3D_PERF_MANIFEST="${LP3D_PERF_DIR}/perf_manifest.txt"
+LP3D_PERF_REPORT="${LP3D_PERF_DIR}/perf_report.json"
+LP3D_PERF_BASELINE=${LP3D_PERF_BASELINE:-$(realpath ${SOURCE_DIR})/builds/check/perf_baseline.json}
+LP3D_PERF_TOLERANCE=${LP3D_PERF_TOLERANCE:-25}
+LP3D_PERF_MODELS=${LP3D_PERF_MODELS:-"1x10x4e 2x20x8c 3x40x8b 3x40x8fh 1x1x5000 1x1000x2"}
+LP3D_PERF_PARTS=(3001.dat 3003.dat 3004.dat 3010.dat 3020.dat 3022.dat 3023.dat 3024.dat 3039.dat 3062b.dat)
+LP3D_PERF_COLORS=(1 2 4 14 15 0 71 72)
+LP3D_LOG_FILE="PerfCheck.out"
+
+echo && echo "------------Performance Checks Start--------------" && echo
+
+# The package scripts pass the executable name
+[ -f "${LPUB3D_EXE}" ] || LPUB3D_EXE=$(command -v "${LPUB3D_EXE}")
+if [ ! -f "${LPUB3D_EXE}" ]; then
+    echo "ERROR - LPub3D executable '${LPUB3D_EXE}' not found."
+    exit 1
+fi
+
+rm -rf "${LP3D_PERF_DIR}" && mkdir -p "${LP3D_PERF_DIR}"
+
+# Write one submodel, and the submodels it uses, to the MPD file
+# arguments: file, name, depth, steps, parts, flags
+function write_submodel()
+{
+    local file=$1 name=$2 depth=$3 steps=$4 parts=$5 flags=$6
+    local child="${name%.ldr}-${depth}.ldr"
+    local step part x z colour
+
+    echo "0 FILE ${name}" >> ${file}
+    echo "0 ${name%.ldr}" >> ${file}
+    echo "0 Name: ${name}" >> ${file}
+    echo "0 Author: LPub3D performance check" >> ${file}
+    echo "0 !LDRAW_ORG Unofficial_Model" >> ${file}
+    echo "" >> ${file}
+
+    for ((step = 0; step < steps; step++)); do
+        [[ "${flags}" == *b* ]] && echo "0 BUFEXCHG A STORE" >> ${file}
+        for ((part = 0; part < parts; part++)); do
+            x=$(( (part % 4) * 40 - 60 ))
+            z=$(( (part / 4) * 40 ))
+            colour=${LP3D_PERF_COLORS[$(( (step + part) % ${#LP3D_PERF_COLORS[@]} ))]}
+            echo "1 ${colour} ${x} $(( step * -24 )) ${z} 1 0 0 0 1 0 0 0 1 ${LP3D_PERF_PARTS[$(( (step * parts + part) % ${#LP3D_PERF_PARTS[@]} ))]}" >> ${file}
+        done
+        [[ "${flags}" == *b* ]] && echo "0 BUFEXCHG A RETRIEVE" >> ${file}
+        # use the next submodel once, half way up
+        if [[ ${depth} -gt 1 && ${step} -eq $(( steps / 2 )) ]]; then
+            [[ "${flags}" == *c* ]] && echo "0 !LPUB CALLOUT BEGIN" >> ${file}
+            echo "1 16 0 $(( step * -24 )) 0 1 0 0 0 1 0 0 0 1 ${child}" >> ${file}
+            [[ "${flags}" == *c* ]] && echo "0 !LPUB CALLOUT END" >> ${file}
+        fi
+        echo "0 STEP" >> ${file}
+    done
+    # the bill of materials looks up the element of every part
+    if [[ "${flags}" == *e* ]]; then
+        echo "0 !LPUB BOM ANNOTATION DISPLAY TRUE" >> ${file}
+        echo "0 !LPUB BOM PART_ELEMENTS DISPLAY TRUE" >> ${file}
+        echo "0 !LPUB BOM PART_ELEMENTS LOCAL_LEGO_ELEMENTS_FILE TRUE" >> ${file}
+        echo "0 !LPUB INSERT PAGE" >> ${file}
+        echo "0 !LPUB INSERT BOM" >> ${file}
+        echo "0 STEP" >> ${file}
+    fi
+    echo "0 NOFILE" >> ${file}
+    echo "" >> ${file}
+
+    if [[ ${depth} -gt 1 ]]; then
+        write_submodel ${file} ${child} $(( depth - 1 )) ${steps} ${parts} "${flags//e/}"
+    fi
+}
+
+# Generate the models and the batch manifest
+echo "# LPub3D performance check manifest" > ${LP3D_PERF_MANIFEST}
+for LP3D_PERF_MODEL in ${LP3D_PERF_MODELS}; do
+    IFS=x read -r LP3D_DEPTH LP3D_STEPS LP3D_PARTS <<< "${LP3D_PERF_MODEL}"
+    LP3D_FLAGS="${LP3D_PARTS//[0-9]/}"
+    LP3D_PARTS="${LP3D_PARTS//[^0-9]/}"
+    LP3D_MODEL_FILE="${LP3D_PERF_DIR}/perf-${LP3D_PERF_MODEL}.mpd"
+    : > ${LP3D_MODEL_FILE}
+    write_submodel ${LP3D_MODEL_FILE} "perf-${LP3D_PERF_MODEL}.ldr" ${LP3D_DEPTH} ${LP3D_STEPS} ${LP3D_PARTS} "${LP3D_FLAGS}"
+    LP3D_MODEL_OPTIONS=
+    [[ "${LP3D_FLAGS}" == *f* ]] && LP3D_MODEL_OPTIONS="${LP3D_MODEL_OPTIONS} --fade-steps"
+    [[ "${LP3D_FLAGS}" == *h* ]] && LP3D_MODEL_OPTIONS="${LP3D_MODEL_OPTIONS} --highlight-step"
+    echo "\"${LP3D_MODEL_FILE}\"${LP3D_MODEL_OPTIONS}" >> ${LP3D_PERF_MANIFEST}
+    echo "- Generated ${LP3D_PERF_MODEL}: $(grep -c '^1 ' ${LP3D_MODEL_FILE}) parts, $(grep -c '^0 STEP' ${LP3D_MODEL_FILE}) steps"
+done
+
+# Process every model in one LPub3D run
+LP3D_PERF_OPTIONS="--no-stdout-log --process-file --clear-cache --preferred-renderer native --performance-trace"
+LP3D_PERF_OPTIONS="${LP3D_PERF_OPTIONS} --batch-manifest ${LP3D_PERF_MANIFEST} --batch-report ${LP3D_PERF_REPORT}"
+
+if [ -n "$USE_XVFB" ]; then
+    xvfb-run --auto-servernum --server-num=1 --server-args="-screen 0 1024x768x24" \
+    ${LPUB3D_EXE} ${LP3D_PERF_OPTIONS} &> ${LP3D_LOG_FILE}
+else
+    ${LPUB3D_EXE} ${LP3D_PERF_OPTIONS} &> ${LP3D_LOG_FILE}
+fi
+LP3D_EXIT=$?
+
+if [ "${LP3D_EXIT}" != "0" ] || [ ! -f "${LP3D_PERF_REPORT}" ]; then
+    echo "ERROR - LPub3D failed (exit code ${LP3D_EXIT}) or ${LP3D_PERF_REPORT} not found."
+    echo "- LPub3D Log Trace: ${LP3D_LOG_FILE}"
+    cat "${LP3D_LOG_FILE}"
+    exit 1
+fi
+rm -rf "${LP3D_LOG_FILE}"
+
+# Report the time per call of each stage and compare it with the baseline
+python3 - "${LP3D_PERF_REPORT}" "${LP3D_PERF_BASELINE}" "${LP3D_PERF_TOLERANCE}" <<'EOF'
+import json, os, sys
+
+report_file, baseline_file, tolerance = sys.argv[1], sys.argv[2], float(sys.argv[3])
+
+def stages(path):
+    with open(path) as f:
+        report = json.load(f)
+    result = {}
+    for model in report.get("models", []):
+        name = os.path.basename(model["file"])
+        result[name] = (model["status"], model.get("stages", {}), model.get("libraryCache"), model.get("fadeStepLines"),
+                        model.get("viewerSteps"))
+    return result
+
+current  = stages(report_file)
+baseline = stages(baseline_file) if os.path.isfile(baseline_file) else {}
+failed   = 0
+
+for name, (status, model_stages, cache, fade, viewer) in sorted(current.items()):
+    print("- %s: %s" % (name, status.upper()))
+    if status != "ok":
+        failed += 1
+    if cache:
+        print("    %-34s %6d hits %10d misses %7.1f%% hit rate %8.1f KB inflation saved" %
+              ("library file cache", cache["hits"], cache["misses"], cache["hitRate"] * 100.0, cache["inflatedBytesSaved"] / 1024.0))
+    for stage, data in sorted(model_stages.items()):
+        per_call = data["ms"] / max(data["count"], 1)
+        line = "    %-34s %6d calls %10.1f ms %8.3f ms/call" % (stage, data["count"], data["ms"], per_call)
+        base = baseline.get(name, (None, {}, None, None, None))[1].get(stage)
+        if base and base["count"]:
+            base_per_call = base["ms"] / base["count"]
+            change = (per_call - base_per_call) * 100.0 / base_per_call if base_per_call else 0.0
+            line += " %+7.1f%%" % change
+            # ignore stages too short to time reliably
+            if change > tolerance and data["ms"] >= 10.0:
+                line += " REGRESSION"
+                failed += 1
+        print(line)
+    extract = model_stages.get("lcZipFile::ExtractFile")
+    if extract and extract["count"]:
+        load = model_stages.get("lcPiecesLibrary::LoadPieceData", {"ms": 0.0})
+        print("    %-34s %6d files %10.1f ms %8.3f ms/file %5.1f%% of part loading" %
+              ("archive extraction", extract["count"], extract["ms"], extract["ms"] / extract["count"],
+               extract["ms"] * 100.0 / load["ms"] if load["ms"] else 0.0))
+    loads = [(stage[len("Annotations::load"):], data) for stage, data in sorted(model_stages.items())
+             if stage.startswith("Annotations::load")]
+    if loads:
+        mapped   = model_stages.get("AnnotationTable::open", {"count": 0, "ms": 0.0})
+        compiled = model_stages.get("AnnotationTable::write", {"count": 0, "ms": 0.0})
+        print("    %-34s %6d tables %10.1f ms %8.1f ms mapping %8.1f ms compiling" %
+              ("annotation table startup", len(loads), sum(data["ms"] for _, data in loads),
+               mapped["ms"], compiled["ms"]))
+        for stage, data in sorted(model_stages.items()):
+            if stage.startswith("Annotations::get") and data["count"]:
+                print("    %-34s %6d lookups %9.1f ms %8.2f us/lookup" %
+                      ("annotation " + stage[len("Annotations::get"):], data["count"], data["ms"],
+                       data["ms"] * 1000.0 / data["count"]))
+    if viewer and viewer["steps"]:
+        print("    %-34s %6d steps %10.1f KB %8.1f KB in full %5.1f%%" %
+              ("viewer step contents", viewer["steps"], viewer["bytes"] / 1024.0, viewer["fullBytes"] / 1024.0,
+               viewer["bytes"] * 100.0 / viewer["fullBytes"] if viewer["fullBytes"] else 0.0))
+    # the faded lines kept are those of the last step of each model
+    if fade and fade["lines"]:
+        configure = model_stages.get("Gui::configureModelStep", {"count": 0, "ms": 0.0})
+        print("    %-34s %6d lines %10.1f KB %8.3f ms/step" %
+              ("fade step lines", fade["lines"], fade["bytes"] / 1024.0,
+               configure["ms"] / max(configure["count"], 1)))
+    # parts per step are the last number of perf-<depth>x<steps>x<parts>
+    rotate = model_stages.get("Render::rotateParts(parts)")
+    if rotate and rotate["maxMs"]:
+        parts = int("".join(c for c in name[:-4].split("x")[-1] if c.isdigit()))
+        print("    %-34s %6d parts/step %7.3f ms longest %8.0f parts/ms" %
+              ("rotateParts throughput", parts, rotate["maxMs"], parts / rotate["maxMs"]))
+
+if not baseline:
+    print("- No baseline at %s" % baseline_file)
+sys.exit(1 if failed else 0)
+EOF
+LP3D_PERF_RESULT=$?
+
+if [ "${LP3D_PERF_UPDATE_BASELINE}" = "true" ]; then
+    cp -f "${LP3D_PERF_REPORT}" "${LP3D_PERF_BASELINE}" && \
+    echo "- Baseline updated: ${LP3D_PERF_BASELINE}"
+fi
+
+if [ "${LP3D_PERF_RESULT}" = "0" ]; then
+    echo && echo "----Performance Check Completed: PASSED----" && echo
+else
+    echo && echo "----Performance Check Completed: FAILED----" && echo
+fi
+
+exit ${LP3D_PERF_RESULT}
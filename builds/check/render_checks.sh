@@ -0,0 +1,137 @@
+#!/bin/bash
+# Trevor SANDY
+# Last Update October 19, 2019
+# Copyright (c) 2019 by Trevor SANDY
+# LPub3D Unix render scratch file stress checks
+# NOTE: Run with variables as appropriate:
+#       $LPUB3D_EXE = <LPub3D executable>,
+#       $SOURCE_DIR = <lpub3d source folder>,
+#       $XMING = true,
+#       $LP3D_RENDER_RUNS = <runs per renderer>               [default 3]
+#       $LP3D_RENDERERS = "<renderer> ..."                      [default "povray native ldglite"]
+#
+# The check model is processed LP3D_RENDER_RUNS times with each renderer,
+# clearing the image caches every time.  Every render writes its own
+# scratch files, so a render that picked up another render's scene or CSI
+# file would change its image.  The first POV-Ray run renders one image at
+# a time (--render-jobs 1) and the later runs render the part images of
+# each PLI in parallel, so they stress concurrent renders against a serial
+# reference.  The decompressed pixel bytes of every assembly and part
+# image must match the first run byte for byte.  PNG metadata, such as a
+# creation time, is not compared.
+
+# Initialize platform variables
+LP3D_OS_NAME=$(uname)
+
+# Initialize XVFB
+if [[ "${XMING}" != "true" && ("${DOCKER}" = "true" || ("${LP3D_OS_NAME}" != "Darwin")) ]]; then
+    echo && echo "- Using XVFB from working directory: ${PWD}"
+    USE_XVFB="true"
+fi
+
+# Initialize variables
+LP3D_CHECK_FILE="$(realpath ${SOURCE_DIR})/builds/check/build_checks.mpd"
+LP3D_CHECK_CACHE="$(dirname ${LP3D_CHECK_FILE})/LPub3D"
+LP3D_RENDER_DIR="$(realpath ${SOURCE_DIR})/builds/check/render"
+LP3D_RENDER_RUNS=${LP3D_RENDER_RUNS:-3}
+LP3D_RENDERERS=${LP3D_RENDERERS:-"povray native ldglite"}
+LP3D_LOG_FILE="RenderCheck.out"
+let LP3D_CHECK_FAIL=0
+
+echo && echo "------------Render Checks Start--------------" && echo
+
+# The package scripts pass the executable name
+[ -f "${LPUB3D_EXE}" ] || LPUB3D_EXE=$(command -v "${LPUB3D_EXE}")
+if [ ! -f "${LPUB3D_EXE}" ]; then
+    echo "ERROR - LPub3D executable '${LPUB3D_EXE}' not found."
+    exit 1
+fi
+
+rm -rf "${LP3D_RENDER_DIR}" && mkdir -p "${LP3D_RENDER_DIR}"
+
+# Run LPub3D once, under XVFB when it is used
+# arguments: LPub3D options
+function run_lpub3d()
+{
+    if [ -n "$USE_XVFB" ]; then
+        xvfb-run --auto-servernum --server-num=1 --server-args="-screen 0 1024x768x24" \
+        ${LPUB3D_EXE} "$@" &> ${LP3D_LOG_FILE}
+    else
+        ${LPUB3D_EXE} "$@" &> ${LP3D_LOG_FILE}
+    fi
+}
+
+# Write the pixel data of each assembly and part image to a digest list
+# arguments: digest file
+function image_digests()
+{
+    python3 - "${LP3D_CHECK_CACHE}" "$1" <<'EOF'
+import hashlib, os, struct, sys, zlib
+
+cache, digest_file = sys.argv[1], sys.argv[2]
+
+def pixels(path):
+    with open(path, "rb") as f:
+        data = f.read()
+    header, idat, pos = b"", b"", 8
+    while pos + 8 <= len(data):
+        length, kind = struct.unpack(">I4s", data[pos:pos + 8])
+        chunk = data[pos + 8:pos + 8 + length]
+        if kind == b"IHDR":
+            header = chunk
+        elif kind == b"IDAT":
+            idat += chunk
+        pos += length + 12
+    return hashlib.md5(header + zlib.decompress(idat)).hexdigest()
+
+with open(digest_file, "w") as out:
+    for folder in ("assem", "parts"):
+        path = os.path.join(cache, folder)
+        if not os.path.isdir(path):
+            continue
+        for name in sorted(os.listdir(path)):
+            if name.lower().endswith(".png"):
+                out.write("%s/%s %s\n" % (folder, name, pixels(os.path.join(path, name))))
+EOF
+}
+
+for LP3D_RENDERER in ${LP3D_RENDERERS}; do
+    LP3D_CHECK_OPTIONS="--no-stdout-log --process-file --clear-cache --liblego --preferred-renderer ${LP3D_RENDERER}"
+    LP3D_REFERENCE="${LP3D_RENDER_DIR}/${LP3D_RENDERER}-1.txt"
+    for ((LP3D_RUN = 1; LP3D_RUN <= LP3D_RENDER_RUNS; LP3D_RUN++)); do
+        LP3D_DIGESTS="${LP3D_RENDER_DIR}/${LP3D_RENDERER}-${LP3D_RUN}.txt"
+        LP3D_RUN_OPTIONS=
+        [[ "${LP3D_RENDERER}" == povray* && "${LP3D_RUN}" = "1" ]] && LP3D_RUN_OPTIONS="--render-jobs 1"
+        rm -rf "${LP3D_CHECK_CACHE}/assem" "${LP3D_CHECK_CACHE}/parts"
+
+        run_lpub3d ${LP3D_CHECK_OPTIONS} ${LP3D_RUN_OPTIONS} ${LP3D_CHECK_FILE}
+        LP3D_EXIT=$?
+
+        image_digests "${LP3D_DIGESTS}"
+
+        if [ "${LP3D_EXIT}" != "0" ] || [ ! -s "${LP3D_DIGESTS}" ]; then
+            echo "- ${LP3D_RENDERER} run ${LP3D_RUN} of ${LP3D_RENDER_RUNS}: FAILED - exit code ${LP3D_EXIT}, $(cat ${LP3D_DIGESTS} 2>/dev/null | wc -l) images"
+            echo "- LPub3D Log Trace: ${LP3D_LOG_FILE}"
+            cat "${LP3D_LOG_FILE}"
+            let LP3D_CHECK_FAIL++
+            break
+        fi
+
+        if [ "${LP3D_RUN}" = "1" ] || diff -q "${LP3D_REFERENCE}" "${LP3D_DIGESTS}" > /dev/null; then
+            echo "- ${LP3D_RENDERER} run ${LP3D_RUN} of ${LP3D_RENDER_RUNS}: PASSED ($(wc -l < ${LP3D_DIGESTS}) images)"
+        else
+            echo "- ${LP3D_RENDERER} run ${LP3D_RUN} of ${LP3D_RENDER_RUNS}: FAILED - images differ from run 1"
+            diff "${LP3D_REFERENCE}" "${LP3D_DIGESTS}"
+            let LP3D_CHECK_FAIL++
+        fi
+        rm -rf "${LP3D_LOG_FILE}"
+    done
+done
+
+if [ "${LP3D_CHECK_FAIL}" = "0" ]; then
+    echo && echo "----Render Check Completed: PASSED----" && echo
+else
+    echo && echo "----Render Check Completed: FAILED (${LP3D_CHECK_FAIL})----" && echo
+fi
+
+exit $([ "${LP3D_CHECK_FAIL}" = "0" ] && echo 0 || echo 1)
@@ -159,6 +159,11 @@ then
     if [ -f "/usr/bin/${LPUB3D_EXE}" ]; then
         # Check commands
         source ${SOURCE_DIR}/builds/check/build_checks.sh
+        # Output checks
+        for LP3D_CHECK_SCRIPT in index_checks load_checks render_checks image_checks perf_checks; do
+            LPUB3D_EXE=${LPUB3D_EXE} SOURCE_DIR=${SOURCE_DIR} XMING=${XMING} DOCKER=${DOCKER} \
+            bash ${SOURCE_DIR}/builds/check/${LP3D_CHECK_SCRIPT}.sh
+        done
         # Cleanup - here we use the package name
         echo "      11-2. Build-check uninstall ${LPUB3D}..."
         sudo dpkg -r ${LPUB3D}
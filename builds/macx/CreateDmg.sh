@@ -268,6 +268,11 @@ if [ -f "${LPUB3D_EXE}" ]; then
     SOURCE_DIR=../..
     echo "- build check SOURCE_DIR is $(realpath ${SOURCE_DIR})..."
     source ${SOURCE_DIR}/builds/check/build_checks.sh
+    # Output checks
+    for LP3D_CHECK_SCRIPT in index_checks load_checks render_checks image_checks perf_checks; do
+        LPUB3D_EXE=${LPUB3D_EXE} SOURCE_DIR=${SOURCE_DIR} XMING=${XMING} DOCKER=${DOCKER} \
+        bash ${SOURCE_DIR}/builds/check/${LP3D_CHECK_SCRIPT}.sh
+    done
 else
     echo "- ERROR - build-check failed. $(realpath ${LPUB3D_EXE}) not found."
 fi
@@ -14,6 +14,7 @@
 #include "application.h"
 #include "name.h"
 #include "threadworkers.h"
+#include "startup.h"
 /*** LPub3D Mod end ***/
 
 lcApplication* gApplication;
@@ -46,6 +47,15 @@ void lcPreferences::LoadDefaults()
     mNativeViewpoint = lcGetProfileInt(LC_PROFILE_NATIVE_VIEWPOINT);
     mNativeProjection = lcGetProfileInt(LC_PROFILE_NATIVE_PROJECTION);
 /*** LPub3D Mod end ***/
+/*** LPub3D Mod - software rasterizer ***/
+    mNativeSoftwareRender = lcGetProfileInt(LC_PROFILE_NATIVE_SOFTWARE_RENDER);
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - batched conditional lines ***/
+    mConditionalLines = static_cast<lcConditionalLines>(lcGetProfileInt(LC_PROFILE_CONDITIONAL_LINES));
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - screen space LOD ***/
+    mNativeLod = static_cast<lcNativeLod>(lcGetProfileInt(LC_PROFILE_NATIVE_LOD));
+/*** LPub3D Mod end ***/
 
 /*** LPub3D Mod - Timeline part icons ***/
     mViewPieceIcons = lcGetProfileInt(LC_PROFILE_VIEW_PIECE_ICONS);
@@ -77,6 +87,15 @@ void lcPreferences::SaveDefaults()
     lcSetProfileInt(LC_PROFILE_NATIVE_VIEWPOINT, mNativeViewpoint);
     lcSetProfileInt(LC_PROFILE_NATIVE_PROJECTION, mNativeProjection);
 /*** LPub3D Mod end ***/
+/*** LPub3D Mod - software rasterizer ***/
+    lcSetProfileInt(LC_PROFILE_NATIVE_SOFTWARE_RENDER, mNativeSoftwareRender);
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - batched conditional lines ***/
+    lcSetProfileInt(LC_PROFILE_CONDITIONAL_LINES, static_cast<int>(mConditionalLines));
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - screen space LOD ***/
+    lcSetProfileInt(LC_PROFILE_NATIVE_LOD, static_cast<int>(mNativeLod));
+/*** LPub3D Mod end ***/
 
 /*** LPub3D Mod - Timeline part icons ***/
     lcSetProfileInt(LC_PROFILE_VIEW_PIECE_ICONS, mViewPieceIcons);
@@ -101,6 +120,9 @@ lcApplication::lcApplication()
     gApplication = this;
     mProject = nullptr;
     mLibrary = nullptr;
+/*** LPub3D Mod - project generation ***/
+    mProjectGeneration = 0;
+/*** LPub3D Mod end ***/
 
 /*** LPub3D Mod - initialize set 3DViewer profile defaults ***/
   lcSetProfileInt(LC_PROFILE_DRAW_AXES, 1);
@@ -173,6 +195,9 @@ void lcApplication::SetProject(Project* Project)
 
 	delete mProject;
 	mProject = Project;
+/*** LPub3D Mod - project generation ***/
+	mProjectGeneration++;
+/*** LPub3D Mod end ***/
 
 	Project->SetActiveModel(0);
 	lcGetPiecesLibrary()->RemoveTemporaryPieces();
@@ -210,10 +235,14 @@ bool lcApplication::LoadPartsLibrary(const QList<QPair<QString, bool>>& LibraryP
     PartWorker partWorker;
 
     // load search directories
+    StartupTrace::begin("LDraw search directories");
     partWorker.ldsearchDirPreferences();
+    StartupTrace::end();
 
     // process search directories to update library archive
+    StartupTrace::begin("Search directory parts");
     partWorker.processLDSearchDirParts();
+    StartupTrace::end();
 
     emit Application::instance()->splashMsgSig("80% - Archive libraries loading...");
 /*** LPub3D Mod end ***/
@@ -294,6 +323,16 @@ int lcApplication::Process3DViewerCommandLine()
 		  if (Param.isEmpty())
 			  continue;
 
+/*** LPub3D Mod - batch manifest ***/
+          if ((Param == QLatin1String("-bm") || Param == QLatin1String("--batch-manifest") ||
+               Param == QLatin1String("-br") || Param == QLatin1String("--batch-report")) &&
+              ArgIdx < NumArguments - 1)
+          {
+              ArgIdx++;
+              continue;
+          }
+/*** LPub3D Mod end ***/
+
           if (Param[0] != '-')
           {
               ProjectName = Param;
@@ -652,7 +691,13 @@ bool lcApplication::Initialize(QList<QPair<QString, bool>>& LibraryPaths, QMainW
 //    ShowWindow = Application::instance()->modeGUI() && !SaveImage && !SaveWavefront && !Save3DS && !SaveCOLLADA && !SaveHTML;
 /*** LPub3D Mod end ***/
 
-    if (!LoadPartsLibrary(LibraryPaths, OnlyUseLibraryPaths, ShowWindow))
+/*** LPub3D Mod - startup trace ***/
+    StartupTrace::begin("Parts library");
+    bool LibraryLoaded = LoadPartsLibrary(LibraryPaths, OnlyUseLibraryPaths, ShowWindow);
+    StartupTrace::end();
+
+    if (!LibraryLoaded)
+/*** LPub3D Mod end ***/
     {
         QString Message;
 
@@ -674,7 +719,11 @@ bool lcApplication::Initialize(QList<QPair<QString, bool>>& LibraryPaths, QMainW
             fprintf(stderr, "%s", Message.toLatin1().constData());
     }
 
+/*** LPub3D Mod - startup trace ***/
+    StartupTrace::begin("3D Viewer widgets");
     gMainWindow->CreateWidgets();
+    StartupTrace::end();
+/*** LPub3D Mod end ***/
 /*** LPub3D Mod - coord format ***/
     gMainWindow->SetRotateStepCoordType(gMainWindow->GetRotateStepCoordType());
 /*** LPub3D Mod end ***/
@@ -17,6 +17,24 @@ enum lcShadingMode
 	LC_NUM_SHADING_MODES
 };
 
+/*** LPub3D Mod - batched conditional lines ***/
+enum class lcConditionalLines
+{
+	OFF,      // conditional lines are not drawn
+	PER_LINE, // each line is tested and drawn on its own
+	BATCHED   // the lines of a mesh section are tested in one pass and drawn with one call
+};
+/*** LPub3D Mod end ***/
+
+/*** LPub3D Mod - screen space LOD ***/
+enum class lcNativeLod
+{
+	DISTANCE,   // by camera distance, as the interactive viewer does
+	IMAGE_SIZE, // by the size of the mesh in the image
+	HIGH        // always the high detail
+};
+/*** LPub3D Mod end ***/
+
 enum class lcViewSphereLocation
 {
 	TOP_LEFT,
@@ -53,6 +71,15 @@ public:
     int mNativeViewpoint;
     int mNativeProjection;
 /*** LPub3D Mod end ***/
+/*** LPub3D Mod - software rasterizer ***/
+    bool mNativeSoftwareRender; // draw native renders without OpenGL
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - batched conditional lines ***/
+    lcConditionalLines mConditionalLines;
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - screen space LOD ***/
+    lcNativeLod mNativeLod; // how native render images pick the mesh detail
+/*** LPub3D Mod end ***/
 
 /*** LPub3D Mod - Timeline part icons ***/
     bool mViewPieceIcons;
@@ -95,6 +122,9 @@ public:
 /*** LPub3D Mod end ***/
 
 	Project* mProject;
+/*** LPub3D Mod - project generation ***/
+	int mProjectGeneration; // bumped each time SetProject replaces the project
+/*** LPub3D Mod end ***/
 	lcPiecesLibrary* mLibrary;
 	lcPreferences mPreferences;
 	QByteArray mClipboard;
@@ -549,6 +549,13 @@ public:
 		return mFile.open(Flags);
 	}
 
+/*** LPub3D Mod - mapped archive ***/
+	const uchar* Map()
+	{
+		return mFile.map(0, mFile.size());
+	}
+/*** LPub3D Mod end ***/
+
 protected:
 	QFile mFile;
 };
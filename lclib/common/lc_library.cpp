@@ -20,6 +20,7 @@
 /*** LPub3D Mod - Includes ***/
 #include "lpub.h"
 #include "version.h"
+#include "perftrace.h"
 /*** LPub3D Mod end ***/
 
 #if MAX_MEM_LEVEL >= 8
@@ -28,7 +29,9 @@
 #  define DEF_MEM_LEVEL  MAX_MEM_LEVEL
 #endif
 
-#define LC_LIBRARY_CACHE_VERSION   0x0106
+/*** LPub3D Mod - parallel description index ***/
+#define LC_LIBRARY_CACHE_VERSION   0x0107
+/*** LPub3D Mod end ***/
 #define LC_LIBRARY_CACHE_ARCHIVE   0x0001
 #define LC_LIBRARY_CACHE_DIRECTORY 0x0002
 /*** LPub3D Mod - part types ***/
@@ -92,6 +95,9 @@ static lcVector2 lcCalculateTexCoord(const lcVector3& Position, const lcLibraryT
 
 lcPiecesLibrary::lcPiecesLibrary()
 	: mLoadMutex(QMutex::Recursive)
+/*** LPub3D Mod - library file cache ***/
+	, mFileCache(LC_LIBRARY_FILE_CACHE_SIZE)
+/*** LPub3D Mod end ***/
 {
 /*** LPub3D Mod - portable cache ***/
 		if (QDir(Preferences::lpub3dPath + "/extras").exists()) { // we have a portable distribution
@@ -116,6 +122,9 @@ lcPiecesLibrary::lcPiecesLibrary()
 	mBuffersDirty = false;
 	mHasUnofficial = false;
 	mCancelLoading = false;
+/*** LPub3D Mod - primitive LOD ***/
+	mCheckLod = false;
+/*** LPub3D Mod end ***/
 }
 
 lcPiecesLibrary::~lcPiecesLibrary()
@@ -147,6 +156,9 @@ void lcPiecesLibrary::Unload()
 	mZipFiles[LC_ZIPFILE_OFFICIAL] = nullptr;
 	delete mZipFiles[LC_ZIPFILE_UNOFFICIAL];
 	mZipFiles[LC_ZIPFILE_UNOFFICIAL] = nullptr;
+/*** LPub3D Mod - library file cache ***/
+	mFileCache.Clear();
+/*** LPub3D Mod end ***/
 }
 
 void lcPiecesLibrary::RemoveTemporaryPieces()
@@ -540,39 +552,42 @@ void lcPiecesLibrary::ReadArchiveDescriptions(const QString& OfficialFileName, c
 
 	QString IndexFileName = QFileInfo(QDir(mCachePath), QLatin1String("index")).absoluteFilePath();
 
-	if (!LoadCacheIndex(IndexFileName))
+/*** LPub3D Mod - parallel description index ***/
+	std::vector<PieceInfo*> ChangedPieces;
+
+	if (LoadCacheIndex(IndexFileName, ChangedPieces))
+		return;
+
+	auto ReadDescription = [this](PieceInfo* Info)
 	{
 		lcMemFile PieceFile;
 
-		for (const auto& PieceIt : mPieces)
-		{
-			PieceInfo* Info = PieceIt.second;
-/*** LPub3D Mod - Custom Mutex Segfault fix provided by Leonardo 08-04-2018 Zide ***/
-			if (Info->IsTemporary())
-				continue;
-/*** LPub3D Mod end ***/
-			mZipFiles[Info->mZipFileType]->ExtractFile(Info->mZipFileIndex, PieceFile, 256);
-			PieceFile.Seek(0, SEEK_END);
-			PieceFile.WriteU8(0);
+		mZipFiles[Info->mZipFileType]->ExtractFile(Info->mZipFileIndex, PieceFile, 256);
+		PieceFile.Seek(0, SEEK_END);
+		PieceFile.WriteU8(0);
 
-			char* Src = (char*)PieceFile.mBuffer + 2;
-			char* Dst = Info->m_strDescription;
+		char* Src = (char*)PieceFile.mBuffer + 2;
+		char* Dst = Info->m_strDescription;
 
-			for (;;)
+		for (;;)
+		{
+			if (*Src != '\r' && *Src != '\n' && *Src && Dst - Info->m_strDescription < (int)sizeof(Info->m_strDescription) - 1)
 			{
-				if (*Src != '\r' && *Src != '\n' && *Src && Dst - Info->m_strDescription < (int)sizeof(Info->m_strDescription) - 1)
-				{
-					*Dst++ = *Src++;
-					continue;
-				}
-
-				*Dst = 0;
-				break;
+				*Dst++ = *Src++;
+				continue;
 			}
+
+			*Dst = 0;
+			break;
 		}
+	};
 
-		SaveArchiveCacheIndex(IndexFileName);
-	}
+	// Each worker writes only the description of its own piece, so the index
+	// saved below is the same whatever order the entries were read in.
+	QtConcurrent::blockingMap(ChangedPieces, ReadDescription);
+
+	SaveArchiveCacheIndex(IndexFileName);
+/*** LPub3D Mod end ***/
 }
 
 bool lcPiecesLibrary::OpenDirectory(const QDir& LibraryDir, bool ShowProgress)
@@ -897,7 +912,9 @@ void lcPiecesLibrary::ReadDirectoryDescriptions(const QFileInfoList (&FileLists)
 	}
 }
 
-bool lcPiecesLibrary::ReadArchiveCacheFile(const QString& FileName, lcMemFile& CacheFile)
+/*** LPub3D Mod - parallel description index ***/
+bool lcPiecesLibrary::ReadArchiveCacheFile(const QString& FileName, lcMemFile& CacheFile, bool* CheckSumMatch)
+/*** LPub3D Mod end ***/
 {
 	QFile File(FileName);
 
@@ -914,8 +931,17 @@ bool lcPiecesLibrary::ReadArchiveCacheFile(const QString& FileName, lcMemFile& C
 
 	qint64 CacheCheckSum[4];
 
-	if (File.read((char*)&CacheCheckSum, sizeof(CacheCheckSum)) == -1 || memcmp(CacheCheckSum, mArchiveCheckSum, sizeof(CacheCheckSum)))
+/*** LPub3D Mod - parallel description index ***/
+	if (File.read((char*)&CacheCheckSum, sizeof(CacheCheckSum)) == -1)
+		return false;
+
+	bool Match = !memcmp(CacheCheckSum, mArchiveCheckSum, sizeof(CacheCheckSum));
+
+	if (CheckSumMatch)
+		*CheckSumMatch = Match;
+	else if (!Match)
 		return false;
+/*** LPub3D Mod end ***/
 
 	quint32 UncompressedSize;
 
@@ -1108,40 +1134,83 @@ bool lcPiecesLibrary::WriteDirectoryCacheFile(const QString& FileName, lcMemFile
 	return true;
 }
 
-bool lcPiecesLibrary::LoadCacheIndex(const QString& FileName)
+/*** LPub3D Mod - parallel description index ***/
+/*
+ * The index keeps the name, zip file and CRC of the entry each description
+ * was read from, so after an archive update only the entries that were added
+ * or whose CRC changed are read again. Returns true if nothing was stale.
+ */
+bool lcPiecesLibrary::LoadCacheIndex(const QString& FileName, std::vector<PieceInfo*>& ChangedPieces)
 {
 	lcMemFile IndexFile;
+	bool CheckSumMatch = false;
+	QSet<PieceInfo*> CachedPieces;
 
-	if (!ReadArchiveCacheFile(FileName, IndexFile))
-		return false;
+	if (ReadArchiveCacheFile(FileName, IndexFile, &CheckSumMatch))
+	{
+		quint32 NumFiles = 0;
+		IndexFile.ReadBuffer((char*)&NumFiles, sizeof(NumFiles));
+
+		while (NumFiles--)
+		{
+			char Name[LC_PIECE_NAME_LEN];
+			char Description[sizeof(PieceInfo::m_strDescription)];
+			quint16 NameLength;
+			quint8 Length, ZipFileType;
+			quint32 Flags, Crc;
 
-	quint32 NumFiles;
+			if (IndexFile.ReadBuffer((char*)&NameLength, sizeof(NameLength)) == 0 || NameLength >= sizeof(Name) ||
+			    (NameLength && IndexFile.ReadBuffer(Name, NameLength) == 0))
+				break;
 
-	if (IndexFile.ReadBuffer((char*)&NumFiles, sizeof(NumFiles)) == 0 || NumFiles != mPieces.size())
-		return false;
+			if (IndexFile.ReadBuffer((char*)&Length, sizeof(Length)) == 0 || Length >= sizeof(Description) ||
+			    (Length && IndexFile.ReadBuffer(Description, Length) == 0))
+				break;
+
+			if (IndexFile.ReadBuffer((char*)&Flags, sizeof(Flags)) == 0 || IndexFile.ReadBuffer((char*)&ZipFileType, sizeof(ZipFileType)) == 0 ||
+			    IndexFile.ReadBuffer((char*)&Crc, sizeof(Crc)) == 0)
+				break;
+
+			Name[NameLength] = 0;
+			Description[Length] = 0;
+
+			const auto PieceIt = mPieces.find(Name);
+
+			if (PieceIt == mPieces.end())
+				continue;
+
+			PieceInfo* Info = PieceIt->second;
+
+			if (Info->IsTemporary() || Info->mZipFileType != ZipFileType || !mZipFiles[ZipFileType] ||
+			    Info->mZipFileIndex >= mZipFiles[ZipFileType]->mFiles.GetSize() || mZipFiles[ZipFileType]->mFiles[Info->mZipFileIndex].crc != Crc)
+				continue;
+
+			strcpy(Info->m_strDescription, Description);
+			Info->mFlags = Flags;
+			CachedPieces.insert(Info);
+		}
+	}
 
 	for (const auto& PieceIt : mPieces)
 	{
 		PieceInfo* Info = PieceIt.second;
-		quint8 Length;
 
-		if (IndexFile.ReadBuffer((char*)&Length, sizeof(Length)) == 0 || Length >= sizeof(Info->m_strDescription))
-			return false;
-
-		if (IndexFile.ReadBuffer((char*)Info->m_strDescription, Length) == 0 || IndexFile.ReadBuffer((char*)&Info->mFlags, sizeof(Info->mFlags)) == 0)
-			return false;
-
-		Info->m_strDescription[Length] = 0;
+		if (!Info->IsTemporary() && !CachedPieces.contains(Info))
+			ChangedPieces.push_back(Info);
 	}
 
-	return true;
+	return CheckSumMatch && ChangedPieces.empty();
 }
 
 bool lcPiecesLibrary::SaveArchiveCacheIndex(const QString& FileName)
 {
 	lcMemFile IndexFile;
 
-	quint32 NumFiles = (quint32)mPieces.size();
+	quint32 NumFiles = 0;
+
+	for (const auto& PieceIt : mPieces)
+		if (!PieceIt.second->IsTemporary())
+			NumFiles++;
 
 	if (IndexFile.WriteBuffer((char*)&NumFiles, sizeof(NumFiles)) == 0)
 		return false;
@@ -1149,17 +1218,31 @@ bool lcPiecesLibrary::SaveArchiveCacheIndex(const QString& FileName)
 	for (const auto& PieceIt : mPieces)
 	{
 		PieceInfo* Info = PieceIt.second;
+
+		if (Info->IsTemporary())
+			continue;
+
+		quint16 NameLength = (quint16)PieceIt.first.size();
 		quint8 Length = (quint8)strlen(Info->m_strDescription);
+		quint8 ZipFileType = (quint8)Info->mZipFileType;
+		quint32 Crc = mZipFiles[Info->mZipFileType]->mFiles[Info->mZipFileIndex].crc;
+
+		if (IndexFile.WriteBuffer((char*)&NameLength, sizeof(NameLength)) == 0 || IndexFile.WriteBuffer(PieceIt.first.c_str(), NameLength) == 0)
+			return false;
 
 		if (IndexFile.WriteBuffer((char*)&Length, sizeof(Length)) == 0)
 			return false;
 
 		if (IndexFile.WriteBuffer((char*)Info->m_strDescription, Length) == 0 || IndexFile.WriteBuffer((char*)&Info->mFlags, sizeof(Info->mFlags)) == 0)
 			return false;
+
+		if (IndexFile.WriteBuffer((char*)&ZipFileType, sizeof(ZipFileType)) == 0 || IndexFile.WriteBuffer((char*)&Crc, sizeof(Crc)) == 0)
+			return false;
 	}
 
 	return WriteArchiveCacheFile(FileName, IndexFile);
 }
+/*** LPub3D Mod end ***/
 
 bool lcPiecesLibrary::LoadCachePiece(PieceInfo* Info)
 {
@@ -1338,6 +1421,11 @@ static int LibraryMeshSectionCompare(lcMergeSection const& First, lcMergeSection
 
 bool lcPiecesLibrary::LoadPieceData(PieceInfo* Info)
 {
+/*** LPub3D Mod - performance trace ***/
+	PerfSpan perfSpan("library", "lcPiecesLibrary::LoadPieceData",
+	                  PerfTrace::enabled() ? QString::fromLatin1(Info->mFileName) : QString());
+/*** LPub3D Mod end ***/
+
 	lcLibraryMeshData MeshData;
 	lcArray<lcLibraryTextureMap> TextureStack;
 
@@ -1346,8 +1434,10 @@ bool lcPiecesLibrary::LoadPieceData(PieceInfo* Info)
 
 	if (Info->mZipFileType != LC_NUM_ZIPFILES && mZipFiles[Info->mZipFileType])
 	{
-		if (LoadCachePiece(Info))
+/*** LPub3D Mod - primitive LOD ***/
+		if (!mCheckLod && LoadCachePiece(Info))
 			return true;
+/*** LPub3D Mod end ***/
 
 		lcMemFile PieceFile;
 
@@ -1621,6 +1711,9 @@ lcMesh* lcPiecesLibrary::CreateMesh(PieceInfo* Info, lcLibraryMeshData& MeshData
 	Mesh->mBoundingBox.Max = Max;
 	Mesh->mBoundingBox.Min = Min;
 	Mesh->mRadius = lcLength((Max - Min) / 2.0f);
+/*** LPub3D Mod - primitive LOD ***/
+	Mesh->mLodError = NumSections[LC_MESH_LOD_LOW] ? MeshData.mLodError : 0.0f;
+/*** LPub3D Mod end ***/
 
 	NumIndices = 0;
 
@@ -1950,60 +2043,213 @@ bool lcPiecesLibrary::LoadPrimitive(lcLibraryPrimitive* Primitive)
 
 	mLoadMutex.unlock();
 
-	lcArray<lcLibraryTextureMap> TextureStack;
+/*** LPub3D Mod - primitive LOD ***/
+	lcLibraryPrimitive* LowPrimitive = FindLowPrimitive(Primitive);
+	lcMeshDataType MeshDataType = LowPrimitive ? LC_MESHDATA_HIGH : LC_MESHDATA_SHARED;
 
-	if (mZipFiles[LC_ZIPFILE_OFFICIAL])
+	if (!ReadPrimitiveMeshData(Primitive, Primitive->mMeshData, MeshDataType))
+		return false;
+
+	if (LowPrimitive && !ReadPrimitiveMeshData(LowPrimitive, Primitive->mMeshData, LC_MESHDATA_LOW))
+		return false;
+
+	if (LowPrimitive)
 	{
-		lcLibraryPrimitive* LowPrimitive = nullptr;
+		// The low resolution primitives draw curves with half the segments,
+		// so their chords stray from the curve by at most r * (1 - cos(pi / 8)).
+		float Radius = 0.0f;
 
-		if (Primitive->mStud && strncmp(Primitive->mName, "8/", 2)) // todo: this is currently the only place that uses mName so use mFileName instead. this should also be done for the loose file libraries.
-		{
-			char Name[LC_PIECE_NAME_LEN];
-			strcpy(Name, "8/");
-			strcat(Name, Primitive->mName);
+		for (const lcLibraryMeshVertex& Vertex : Primitive->mMeshData.mVertices[LC_MESHDATA_HIGH])
+			Radius = qMax(Radius, lcLength(Vertex.Position));
 
-			LowPrimitive = FindPrimitive(Name);
-		}
+		Primitive->mMeshData.mLodError = Radius * (1.0f - cosf(LC_PI / 8.0f));
 
-		lcMemFile PrimFile;
+		if (mCheckLod)
+			CheckPrimitiveLod(Primitive, LowPrimitive);
+	}
+/*** LPub3D Mod end ***/
 
-		if (!mZipFiles[Primitive->mZipFileType]->ExtractFile(Primitive->mZipFileIndex, PrimFile))
-			return false;
+	mLoadMutex.lock();
+	Primitive->mState = lcPrimitiveState::LOADED;
+	mLoadMutex.unlock();
 
-		if (!LowPrimitive)
-		{
-			if (!ReadMeshData(PrimFile, lcMatrix44Identity(), 16, false, TextureStack, Primitive->mMeshData, LC_MESHDATA_SHARED, true, nullptr, false))
-				return false;
-		}
-		else
-		{
-			if (!ReadMeshData(PrimFile, lcMatrix44Identity(), 16, false, TextureStack, Primitive->mMeshData, LC_MESHDATA_HIGH, true, nullptr, false))
-				return false;
+	return true;
+}
 
-			if (!mZipFiles[LowPrimitive->mZipFileType]->ExtractFile(LowPrimitive->mZipFileIndex, PrimFile))
-				return false;
+/*** LPub3D Mod - library file cache ***/
+bool lcLibraryFileCache::Find(lcZipFileType ZipFileType, quint32 ZipFileIndex, lcMemFile& File)
+{
+	QMutexLocker Lock(&mMutex);
 
-			TextureStack.RemoveAll();
+	const auto FileIt = mFiles.find(GetKey(ZipFileType, ZipFileIndex));
 
-			if (!ReadMeshData(PrimFile, lcMatrix44Identity(), 16, false, TextureStack, Primitive->mMeshData, LC_MESHDATA_LOW, true, nullptr, false))
-				return false;
-		}
+	if (FileIt == mFiles.end())
+	{
+		mStats.Misses++;
+		return false;
 	}
-	else
+
+	lcCachedFile& Cached = FileIt->second;
+	mUses.splice(mUses.begin(), mUses, Cached.Use);
+
+	File.SetLength(Cached.Data.size());
+	File.Seek(0, SEEK_SET);
+	memcpy(File.mBuffer, Cached.Data.constData(), Cached.Data.size());
+
+	mStats.Hits++;
+	mStats.InflatedBytesSaved += Cached.Data.size();
+
+	return true;
+}
+
+void lcLibraryFileCache::Insert(lcZipFileType ZipFileType, quint32 ZipFileIndex, const lcMemFile& File)
+{
+	const qint64 Size = File.GetLength();
+
+	if (Size > mMaxBytes / 4)
+		return;
+
+	QMutexLocker Lock(&mMutex);
+
+	const quint64 Key = GetKey(ZipFileType, ZipFileIndex);
+
+	if (mFiles.find(Key) != mFiles.end())
+		return;
+
+	while (!mUses.empty() && mStats.Bytes + Size > mMaxBytes)
+	{
+		const auto FileIt = mFiles.find(mUses.back());
+		mStats.Bytes -= FileIt->second.Data.size();
+		mFiles.erase(FileIt);
+		mUses.pop_back();
+	}
+
+	mUses.push_front(Key);
+
+	lcCachedFile& Cached = mFiles[Key];
+	Cached.Data = QByteArray(reinterpret_cast<const char*>(File.mBuffer), (int)Size);
+	Cached.Use = mUses.begin();
+
+	mStats.Bytes += Size;
+	mStats.Entries = (int)mFiles.size();
+}
+
+void lcLibraryFileCache::Clear()
+{
+	QMutexLocker Lock(&mMutex);
+
+	mFiles.clear();
+	mUses.clear();
+	mStats.Bytes = 0;
+	mStats.Entries = 0;
+}
+
+lcLibraryFileCacheStats lcLibraryFileCache::GetStats() const
+{
+	QMutexLocker Lock(&mMutex);
+
+	lcLibraryFileCacheStats Stats = mStats;
+	Stats.Entries = (int)mFiles.size();
+	return Stats;
+}
+
+bool lcPiecesLibrary::ExtractIncludeFile(lcZipFileType ZipFileType, quint32 ZipFileIndex, lcMemFile& File)
+{
+	if (mFileCache.Find(ZipFileType, ZipFileIndex, File))
+		return true;
+
+	if (!mZipFiles[ZipFileType]->ExtractFile(ZipFileIndex, File))
+		return false;
+
+	mFileCache.Insert(ZipFileType, ZipFileIndex, File);
+	File.Seek(0, SEEK_SET);
+
+	return true;
+}
+/*** LPub3D Mod end ***/
+
+/*** LPub3D Mod - primitive LOD ***/
+/*
+ * Find the low resolution version of a primitive in the 8 folder, used in
+ * place of the primitive when a part is drawn too small for the detail.
+ */
+lcLibraryPrimitive* lcPiecesLibrary::FindLowPrimitive(const lcLibraryPrimitive* Primitive) const
+{
+	if (Primitive->mSubFile || !strncmp(Primitive->mName, "8/", 2) || !strncmp(Primitive->mName, "48/", 3))
+		return nullptr;
+
+	char Name[LC_MAXNAME + 2];
+	strcpy(Name, "8/");
+	strcat(Name, Primitive->mName);
+
+	for (char* Ch = Name; *Ch; Ch++)
 	{
-		lcDiskFile PrimFile(Primitive->mFileName);
+		if (*Ch >= 'a' && *Ch <= 'z')
+			*Ch = *Ch + 'A' - 'a';
+		else if (*Ch == '\\')
+			*Ch = '/';
+	}
 
-		if (!PrimFile.Open(QIODevice::ReadOnly) || !ReadMeshData(PrimFile, lcMatrix44Identity(), 16, false, TextureStack, Primitive->mMeshData, LC_MESHDATA_SHARED, true, nullptr, false))
+	return FindPrimitive(Name);
+}
+
+bool lcPiecesLibrary::ReadPrimitiveMeshData(const lcLibraryPrimitive* Primitive, lcLibraryMeshData& MeshData, lcMeshDataType MeshDataType)
+{
+	lcArray<lcLibraryTextureMap> TextureStack;
+
+	if (mZipFiles[LC_ZIPFILE_OFFICIAL])
+	{
+		lcMemFile PrimFile;
+
+		if (!mZipFiles[Primitive->mZipFileType]->ExtractFile(Primitive->mZipFileIndex, PrimFile))
 			return false;
+
+		return ReadMeshData(PrimFile, lcMatrix44Identity(), 16, false, TextureStack, MeshData, MeshDataType, true, nullptr, false);
 	}
 
-	mLoadMutex.lock();
-	Primitive->mState = lcPrimitiveState::LOADED;
-	mLoadMutex.unlock();
+	lcDiskFile PrimFile(Primitive->mFileName);
 
-	return true;
+	return PrimFile.Open(QIODevice::ReadOnly) && ReadMeshData(PrimFile, lcMatrix44Identity(), 16, false, TextureStack, MeshData, MeshDataType, true, nullptr, false);
+}
+
+/*
+ * Each LOD of a primitive must hold the same geometry as the primitive
+ * file read without LOD substitution: everything a read leaves in the
+ * shared and high detail data, as the single mesh did before the LODs.
+ * Only index counts are compared, which is enough to catch geometry that
+ * went missing or was copied into both levels of detail.
+ */
+static void lcCountLodIndices(const lcLibraryMeshData& MeshData, int MeshDataIdx, QMap<int, int>& Counts)
+{
+	for (const lcLibraryMeshSection* Section : MeshData.mSections[MeshDataIdx])
+		Counts[Section->mPrimitiveType] += Section->mIndices.GetSize();
 }
 
+void lcPiecesLibrary::CheckPrimitiveLod(lcLibraryPrimitive* Primitive, lcLibraryPrimitive* LowPrimitive)
+{
+	const lcLibraryPrimitive* Sources[LC_NUM_MESH_LODS] = { Primitive, LowPrimitive };
+	const lcMeshDataType Lods[LC_NUM_MESH_LODS] = { LC_MESHDATA_HIGH, LC_MESHDATA_LOW };
+
+	for (int LodIdx = 0; LodIdx < LC_NUM_MESH_LODS; LodIdx++)
+	{
+		lcLibraryMeshData Reference;
+
+		if (!ReadPrimitiveMeshData(Sources[LodIdx], Reference, LC_MESHDATA_SHARED))
+			continue;
+
+		QMap<int, int> Expected, Actual;
+		lcCountLodIndices(Reference, LC_MESHDATA_SHARED, Expected);
+		lcCountLodIndices(Reference, LC_MESHDATA_HIGH, Expected);
+		lcCountLodIndices(Primitive->mMeshData, LC_MESHDATA_SHARED, Actual);
+		lcCountLodIndices(Primitive->mMeshData, Lods[LodIdx], Actual);
+
+		if (Expected != Actual)
+			logError() << qPrintable(QString("Primitive LOD check failed - %1 LOD %2 does not match %3 read without LOD.")
+									 .arg(Primitive->mName).arg(LodIdx).arg(Sources[LodIdx]->mName));
+	}
+}
+/*** LPub3D Mod end ***/
+
 bool lcPiecesLibrary::ReadMeshData(lcFile& File, const lcMatrix44& CurrentTransform, quint32 CurrentColorCode, bool InvertWinding, lcArray<lcLibraryTextureMap>& TextureStack, lcLibraryMeshData& MeshData, lcMeshDataType MeshDataType, bool Optimize, Project* CurrentProject, bool SearchProjectFolder)
 {
 	char Buffer[1024];
@@ -2329,6 +2575,14 @@ bool lcPiecesLibrary::ReadMeshData(lcFile& File, const lcMatrix44& CurrentTransf
 					if (Primitive->mState != lcPrimitiveState::LOADED && !LoadPrimitive(Primitive))
 						break;
 
+/*** LPub3D Mod - primitive LOD ***/
+					if (Primitive->mMeshData.mLodError > 0.0f && MeshDataType == LC_MESHDATA_SHARED)
+					{
+						float Scale = qMax(qMax(lcLength(lcVector3(IncludeTransform[0])), lcLength(lcVector3(IncludeTransform[1]))), lcLength(lcVector3(IncludeTransform[2])));
+						MeshData.mLodError = qMax(MeshData.mLodError, Primitive->mMeshData.mLodError * Scale);
+					}
+/*** LPub3D Mod end ***/
+
 					if (Primitive->mStud)
 						MeshData.AddMeshDataNoDuplicateCheck(Primitive->mMeshData, IncludeTransform, ColorCode, Mirror ^ InvertNext, InvertNext, TextureMap, MeshDataType);
 					else if (!Primitive->mSubFile)
@@ -2344,7 +2598,9 @@ bool lcPiecesLibrary::ReadMeshData(lcFile& File, const lcMatrix44& CurrentTransf
 						{
 							lcMemFile IncludeFile;
 
-							if (mZipFiles[Primitive->mZipFileType]->ExtractFile(Primitive->mZipFileIndex, IncludeFile))
+/*** LPub3D Mod - library file cache ***/
+							if (ExtractIncludeFile(Primitive->mZipFileType, Primitive->mZipFileIndex, IncludeFile))
+/*** LPub3D Mod end ***/
 								ReadMeshData(IncludeFile, IncludeTransform, ColorCode, Mirror ^ InvertNext, TextureStack, MeshData, MeshDataType, Optimize, CurrentProject, SearchProjectFolder);
 						}
 						else
@@ -2368,7 +2624,9 @@ bool lcPiecesLibrary::ReadMeshData(lcFile& File, const lcMatrix44& CurrentTransf
 						{
 							lcMemFile IncludeFile;
 
-							if (mZipFiles[Info->mZipFileType]->ExtractFile(Info->mZipFileIndex, IncludeFile))
+/*** LPub3D Mod - library file cache ***/
+							if (ExtractIncludeFile(Info->mZipFileType, Info->mZipFileIndex, IncludeFile))
+/*** LPub3D Mod end ***/
 								ReadMeshData(IncludeFile, IncludeTransform, ColorCode, Mirror ^ InvertNext, TextureStack, MeshData, MeshDataType, Optimize, CurrentProject, SearchProjectFolder);
 						}
 						else
@@ -3107,6 +3365,12 @@ void lcLibraryMeshData::AddMeshData(const lcLibraryMeshData& Data, const lcMatri
 {
 	for (int MeshDataIdx = 0; MeshDataIdx < LC_NUM_MESHDATA_TYPES; MeshDataIdx++)
 	{
+/*** LPub3D Mod - primitive LOD ***/
+		// data read for one LOD only takes the nested data of that LOD
+		if (OverrideDestIndex != LC_MESHDATA_SHARED && MeshDataIdx != LC_MESHDATA_SHARED && MeshDataIdx != OverrideDestIndex)
+			continue;
+/*** LPub3D Mod end ***/
+
 		int DestIndex = OverrideDestIndex == LC_MESHDATA_SHARED ? MeshDataIdx : OverrideDestIndex;
 		const lcArray<lcLibraryMeshVertex>& DataVertices = Data.mVertices[MeshDataIdx];
 		lcArray<lcLibraryMeshVertex>& Vertices = mVertices[DestIndex];
@@ -3247,6 +3511,11 @@ void lcLibraryMeshData::AddMeshDataNoDuplicateCheck(const lcLibraryMeshData& Dat
 {
 	for (int MeshDataIdx = 0; MeshDataIdx < LC_NUM_MESHDATA_TYPES; MeshDataIdx++)
 	{
+/*** LPub3D Mod - primitive LOD ***/
+		if (OverrideDestIndex != LC_MESHDATA_SHARED && MeshDataIdx != LC_MESHDATA_SHARED && MeshDataIdx != OverrideDestIndex)
+			continue;
+/*** LPub3D Mod end ***/
+
 		int DestIndex = OverrideDestIndex == LC_MESHDATA_SHARED ? MeshDataIdx : OverrideDestIndex;
 		const lcArray<lcLibraryMeshVertex>& DataVertices = Data.mVertices[MeshDataIdx];
 		lcArray<lcLibraryMeshVertex>& Vertices = mVertices[DestIndex];
@@ -3531,6 +3800,7 @@ bool lcPiecesLibrary::ReloadUnoffLib()
 	//unload unofficial library content
 	delete mZipFiles[LC_ZIPFILE_UNOFFICIAL];
 	mZipFiles[LC_ZIPFILE_UNOFFICIAL] = NULL;
+	mFileCache.Clear();
 
 	//load unofficial library content
 	if (mUnofficialFileName.isEmpty())
@@ -3551,6 +3821,7 @@ void lcPiecesLibrary::UnloadUnofficialLib() {
 	//unload unofficial library content
 	delete mZipFiles[LC_ZIPFILE_UNOFFICIAL];
 	mZipFiles[LC_ZIPFILE_UNOFFICIAL] = nullptr;
+	mFileCache.Clear();
 }
 /*** LPub3D Mod end ***/
 
@@ -3559,5 +3830,6 @@ void lcPiecesLibrary::UnloadOfficialLib() {
 	mNumOfficialPieces = 0;
 	delete mZipFiles[LC_ZIPFILE_OFFICIAL];
 	mZipFiles[LC_ZIPFILE_OFFICIAL] = nullptr;
+	mFileCache.Clear();
 }
 /*** LPub3D Mod end ***/
@@ -4,6 +4,10 @@
 #include "lc_mesh.h"
 #include "lc_math.h"
 #include "lc_array.h"
+/*** LPub3D Mod - library file cache ***/
+#include <list>
+#include <unordered_map>
+/*** LPub3D Mod end ***/
 
 class PieceInfo;
 class lcZipFile;
@@ -122,6 +126,9 @@ public:
 	lcLibraryMeshData()
 	{
 		mHasTextures = false;
+/*** LPub3D Mod - primitive LOD ***/
+		mLodError = 0.0f;
+/*** LPub3D Mod end ***/
 
 		for (int MeshDataIdx = 0; MeshDataIdx < LC_NUM_MESHDATA_TYPES; MeshDataIdx++)
 			mVertices[MeshDataIdx].SetGrow(1024);
@@ -159,8 +166,62 @@ public:
 	lcArray<lcLibraryMeshSection*> mSections[LC_NUM_MESHDATA_TYPES];
 	lcArray<lcLibraryMeshVertex> mVertices[LC_NUM_MESHDATA_TYPES];
 	bool mHasTextures;
+/*** LPub3D Mod - primitive LOD ***/
+	float mLodError; // largest distance between the low and high detail geometry, in LDU
+/*** LPub3D Mod end ***/
+};
+
+/*** LPub3D Mod - library file cache ***/
+#define LC_LIBRARY_FILE_CACHE_SIZE (32 * 1024 * 1024)
+
+struct lcLibraryFileCacheStats
+{
+	quint64 Hits;
+	quint64 Misses;
+	quint64 InflatedBytesSaved; // bytes served from the cache instead of inflated again
+	qint64 Bytes;
+	int Entries;
 };
 
+// Bounded, least recently used cache of the decompressed subfiles and
+// parts that ReadMeshData includes inline, so a subpart used by many
+// pieces is only inflated once. It outlives UnloadUnusedParts and is
+// cleared whenever an archive is closed, since the keys are archive
+// indices.
+class lcLibraryFileCache
+{
+public:
+	explicit lcLibraryFileCache(qint64 MaxBytes)
+		: mMaxBytes(MaxBytes)
+	{
+		memset(&mStats, 0, sizeof(mStats));
+	}
+
+	bool Find(lcZipFileType ZipFileType, quint32 ZipFileIndex, lcMemFile& File);
+	void Insert(lcZipFileType ZipFileType, quint32 ZipFileIndex, const lcMemFile& File);
+	void Clear();
+	lcLibraryFileCacheStats GetStats() const;
+
+protected:
+	struct lcCachedFile
+	{
+		QByteArray Data;
+		std::list<quint64>::iterator Use;
+	};
+
+	static quint64 GetKey(lcZipFileType ZipFileType, quint32 ZipFileIndex)
+	{
+		return ((quint64)ZipFileType << 32) | ZipFileIndex;
+	}
+
+	mutable QMutex mMutex;
+	std::unordered_map<quint64, lcCachedFile> mFiles;
+	std::list<quint64> mUses; // most recently used first
+	qint64 mMaxBytes;
+	lcLibraryFileCacheStats mStats;
+};
+/*** LPub3D Mod end ***/
+
 class lcLibraryPrimitive
 {
 public:
@@ -256,6 +317,13 @@ public:
 	void UpdateBuffers(lcContext* Context);
 	void UnloadUnusedParts();
 
+/*** LPub3D Mod - library file cache ***/
+	lcLibraryFileCacheStats GetFileCacheStats() const
+	{
+		return mFileCache.GetStats();
+	}
+/*** LPub3D Mod end ***/
+
 	std::map<std::string, PieceInfo*> mPieces;
 	std::map<std::string, lcLibraryPrimitive*> mPrimitives;
 	int mNumOfficialPieces;
@@ -267,6 +335,9 @@ public:
 	bool mBuffersDirty;
 	lcVertexBuffer mVertexBuffer;
 	lcIndexBuffer mIndexBuffer;
+/*** LPub3D Mod - primitive LOD ***/
+	bool mCheckLod; // compare primitive LODs with their files as they load, not using the mesh cache
+/*** LPub3D Mod end ***/
 
 signals:
 	void PartLoaded(PieceInfo* Info);
@@ -278,9 +349,11 @@ protected:
 	void ReadArchiveDescriptions(const QString& OfficialFileName, const QString& UnofficialFileName);
 	void ReadDirectoryDescriptions(const QFileInfoList (&FileLists)[LC_NUM_FOLDERTYPES], bool ShowProgress);
 
-	bool ReadArchiveCacheFile(const QString& FileName, lcMemFile& CacheFile);
+/*** LPub3D Mod - parallel description index ***/
+	bool ReadArchiveCacheFile(const QString& FileName, lcMemFile& CacheFile, bool* CheckSumMatch = nullptr);
 	bool WriteArchiveCacheFile(const QString& FileName, lcMemFile& CacheFile);
-	bool LoadCacheIndex(const QString& FileName);
+	bool LoadCacheIndex(const QString& FileName, std::vector<PieceInfo*>& ChangedPieces);
+/*** LPub3D Mod end ***/
 	bool SaveArchiveCacheIndex(const QString& FileName);
 	bool LoadCachePiece(PieceInfo* Info);
 	bool SaveCachePiece(PieceInfo* Info);
@@ -294,6 +367,16 @@ protected:
 	}
 
 	bool LoadPrimitive(lcLibraryPrimitive* Primitive);
+/*** LPub3D Mod - primitive LOD ***/
+	lcLibraryPrimitive* FindLowPrimitive(const lcLibraryPrimitive* Primitive) const;
+	bool ReadPrimitiveMeshData(const lcLibraryPrimitive* Primitive, lcLibraryMeshData& MeshData, lcMeshDataType MeshDataType);
+	void CheckPrimitiveLod(lcLibraryPrimitive* Primitive, lcLibraryPrimitive* LowPrimitive);
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - library file cache ***/
+	bool ExtractIncludeFile(lcZipFileType ZipFileType, quint32 ZipFileIndex, lcMemFile& File);
+
+	lcLibraryFileCache mFileCache;
+/*** LPub3D Mod end ***/
 
 	QMutex mLoadMutex;
 	QList<QFuture<void>> mLoadFutures;
@@ -26,6 +26,9 @@ lcMesh::lcMesh()
 	mIndexDataSize = 0;
 	mVertexCacheOffset = -1;
 	mIndexCacheOffset = -1;
+/*** LPub3D Mod - screen space LOD ***/
+	mLodError = 0.0f;
+/*** LPub3D Mod end ***/
 }
 
 lcMesh::~lcMesh()
@@ -368,6 +371,9 @@ bool lcMesh::FileLoad(lcMemFile& File)
 	mBoundingBox.Min = File.ReadVector3();
 	mBoundingBox.Max = File.ReadVector3();
 	mRadius = File.ReadFloat();
+/*** LPub3D Mod - screen space LOD ***/
+	mLodError = File.ReadFloat();
+/*** LPub3D Mod end ***/
 
 	quint32 NumVertices, NumTexturedVertices, NumIndices;
 	quint16 NumLods, NumSections[LC_NUM_MESH_LODS];
@@ -434,6 +440,9 @@ bool lcMesh::FileSave(lcMemFile& File)
 	File.WriteVector3(mBoundingBox.Min);
 	File.WriteVector3(mBoundingBox.Max);
 	File.WriteFloat(mRadius);
+/*** LPub3D Mod - screen space LOD ***/
+	File.WriteFloat(mLodError);
+/*** LPub3D Mod end ***/
 
 	File.WriteU32(mNumVertices);
 	File.WriteU32(mNumTexturedVertices);
@@ -481,3 +490,31 @@ int lcMesh::GetLodIndex(float Distance) const
 	else
 		return LC_MESH_LOD_HIGH;
 }
+
+/*** LPub3D Mod - screen space LOD ***/
+/*
+ * Choose the low detail when the geometry it drops would move by less than
+ * LC_MESH_LOD_PIXEL_ERROR on screen.  LodScale is the number of pixels one
+ * LDU covers at unit distance, or anywhere for an orthographic camera, and
+ * the error is measured at the point of the mesh nearest to the camera.
+ */
+int lcMesh::GetLodIndex(float Distance, float LodScale, bool Orthographic) const
+{
+	if (!mLods[LC_MESH_LOD_LOW].NumSections)
+		return LC_MESH_LOD_HIGH;
+
+	float PixelsPerUnit = LodScale;
+
+	if (!Orthographic)
+	{
+		float NearDistance = Distance - mRadius;
+
+		if (NearDistance <= 0.0f)
+			return LC_MESH_LOD_HIGH;
+
+		PixelsPerUnit /= NearDistance;
+	}
+
+	return mLodError * PixelsPerUnit < LC_MESH_LOD_PIXEL_ERROR ? LC_MESH_LOD_LOW : LC_MESH_LOD_HIGH;
+}
+/*** LPub3D Mod end ***/
@@ -3,7 +3,7 @@
 #include "lc_math.h"
 
 #define LC_MESH_FILE_ID      LC_FOURCC('M', 'E', 'S', 'H')
-#define LC_MESH_FILE_VERSION 0x0114
+#define LC_MESH_FILE_VERSION 0x0115
 
 enum lcMeshPrimitiveType
 {
@@ -50,6 +50,10 @@ enum
 	LC_NUM_MESH_LODS
 };
 
+/*** LPub3D Mod - screen space LOD ***/
+#define LC_MESH_LOD_PIXEL_ERROR 1.0f // largest on screen error the low detail may show, in pixels
+/*** LPub3D Mod end ***/
+
 class lcMesh
 {
 public:
@@ -79,10 +83,16 @@ public:
 	bool IntersectsPlanes(const lcVector4 Planes[6]);
 
 	int GetLodIndex(float Distance) const;
+/*** LPub3D Mod - screen space LOD ***/
+	int GetLodIndex(float Distance, float LodScale, bool Orthographic) const;
+/*** LPub3D Mod end ***/
 
 	lcMeshLod mLods[LC_NUM_MESH_LODS];
 	lcBoundingBox mBoundingBox;
 	float mRadius;
+/*** LPub3D Mod - screen space LOD ***/
+	float mLodError; // largest distance between the low and high detail geometry, in LDU
+/*** LPub3D Mod end ***/
 
 	void* mVertexData;
 	int mVertexDataSize;
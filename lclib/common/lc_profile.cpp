@@ -129,7 +129,16 @@ static lcProfileEntry gProfileEntries[LC_NUM_PROFILE_KEYS] =
 
 /*** LPub3D Mod - Native projection options ***/
     lcProfileEntry("Settings", "NativeViewpoint",  7),                                      // LC_PROFILE_NATIVE_VIEWPOINT  [0 = LC_VIEWPOINT_FRONT]  /*** LPub3D Mod - Native Renderer settings ***/
-    lcProfileEntry("Settings", "NativeProjection", 0)                                       // LC_PROFILE_NATIVE_PROJECTION [0 = PERSPECTIVE, 1 = ORTHOGRAPHIC]  /*** LPub3D Mod - Native Renderer settings ***/
+    lcProfileEntry("Settings", "NativeProjection", 0),                                      // LC_PROFILE_NATIVE_PROJECTION [0 = PERSPECTIVE, 1 = ORTHOGRAPHIC]  /*** LPub3D Mod - Native Renderer settings ***/
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - software rasterizer ***/
+    lcProfileEntry("Settings", "NativeSoftwareRender", 0),                                  // LC_PROFILE_NATIVE_SOFTWARE_RENDER
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - batched conditional lines ***/
+    lcProfileEntry("Settings", "ConditionalLines", 0),                                      // LC_PROFILE_CONDITIONAL_LINES [0 = OFF, 1 = PER_LINE, 2 = BATCHED]
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - screen space LOD ***/
+    lcProfileEntry("Settings", "NativeLod", 1)                                              // LC_PROFILE_NATIVE_LOD [0 = DISTANCE, 1 = IMAGE_SIZE, 2 = HIGH]
 /*** LPub3D Mod end ***/
 };
 
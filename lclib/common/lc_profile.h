@@ -76,6 +76,15 @@ enum LC_PROFILE_KEY
     // Native Renderer.
     LC_PROFILE_NATIVE_VIEWPOINT,
     LC_PROFILE_NATIVE_PROJECTION,
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - software rasterizer ***/
+    LC_PROFILE_NATIVE_SOFTWARE_RENDER,
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - batched conditional lines ***/
+    LC_PROFILE_CONDITIONAL_LINES,
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - screen space LOD ***/
+    LC_PROFILE_NATIVE_LOD,
 /*** LPub3D Mod end ***/
 	LC_NUM_PROFILE_KEYS
 };
@@ -0,0 +1,613 @@
+#include "lc_global.h"
+#include "lc_rasterizer.h"
+#include "lc_scene.h"
+#include "lc_mesh.h"
+#include "lc_colors.h"
+#include "lc_application.h"
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 0, 0))
+#include <QtConcurrent>
+#endif
+
+/*** LPub3D Mod - software rasterizer ***/
+#define LC_RASTER_TILE_SIZE 64
+#define LC_RASTER_LINE_DEPTH_BIAS 0.00002f
+
+lcRasterizer::lcRasterizer(int Width, int Height)
+	: mWidth(qMax(Width, 1)), mHeight(qMax(Height, 1))
+{
+	mTileColumns = (mWidth + LC_RASTER_TILE_SIZE - 1) / LC_RASTER_TILE_SIZE;
+	mTileRows = (mHeight + LC_RASTER_TILE_SIZE - 1) / LC_RASTER_TILE_SIZE;
+	mLineWidth = 1.0f;
+	mImageBits = nullptr;
+	mBytesPerLine = 0;
+
+	for (int Bin = 0; Bin < LC_RASTER_NUM_BINS; Bin++)
+		mTileBins[Bin].resize(mTileColumns * mTileRows);
+}
+
+QImage lcRasterizer::Render(const lcScene& Scene, const lcMatrix44& ProjectionMatrix, const lcVector3& BackgroundColor)
+{
+	const lcPreferences& Preferences = lcGetPreferences();
+
+	mViewMatrix = Scene.mViewMatrix;
+	mProjectionMatrix = ProjectionMatrix;
+	mBackgroundColor = lcVector4(BackgroundColor, 0.0f);
+	mLineWidth = qMax(Preferences.mLineWidth, 1.0f);
+
+	lcShadingMode ShadingMode = Preferences.mShadingMode;
+	if (ShadingMode == LC_SHADING_WIREFRAME && !Scene.mAllowWireframe)
+		ShadingMode = LC_SHADING_FLAT;
+
+	const bool DrawLines = Preferences.mDrawEdgeLines && Preferences.mLineWidth != 0.0f;
+	const bool DoFade = gApplication->FadePreviousSteps() && !Scene.mTranslucentMeshes.IsEmpty();
+	const bool Flat = ShadingMode == LC_SHADING_FLAT;
+
+	AddRenderMeshes(Scene, Scene.mOpaqueMeshes, false, !Flat);
+	AddRenderMeshes(Scene, Scene.mTranslucentMeshes, true, !Flat);
+
+	// Bin, DepthWrite, ColorWrite, Blend, CullBack
+	const lcRasterStep OpaqueTriangles      = { LC_RASTER_OPAQUE_TRIANGLES,      true,  true,  false, false };
+	const lcRasterStep OpaqueLines          = { LC_RASTER_OPAQUE_LINES,          true,  true,  false, false };
+	const lcRasterStep OpaqueFadeLines      = { LC_RASTER_OPAQUE_LINES,          false, true,  true,  false };
+	const lcRasterStep TranslucentTriangles = { LC_RASTER_TRANSLUCENT_TRIANGLES, false, true,  true,  false };
+	const lcRasterStep TranslucentFadeDepth = { LC_RASTER_TRANSLUCENT_TRIANGLES, true,  false, false, true  };
+	const lcRasterStep TranslucentFade      = { LC_RASTER_TRANSLUCENT_TRIANGLES, false, true,  true,  true  };
+	const lcRasterStep TranslucentFadeLines = { LC_RASTER_TRANSLUCENT_LINES,     false, true,  true,  false };
+
+	mSteps.clear();
+
+	if (ShadingMode == LC_SHADING_WIREFRAME)
+	{
+		mSteps.push_back(OpaqueLines);
+	}
+	else
+	{
+		if (DrawLines && !DoFade && !Flat)
+			mSteps.push_back(OpaqueLines);
+
+		mSteps.push_back(OpaqueTriangles);
+
+		if (DrawLines && !DoFade && Flat)
+			mSteps.push_back(OpaqueLines);
+
+		if (DoFade)
+		{
+			mSteps.push_back(TranslucentFadeDepth);
+			mSteps.push_back(TranslucentFade);
+
+			if (DrawLines)
+			{
+				mSteps.push_back(TranslucentFadeLines);
+
+				if (!Flat)
+					mSteps.push_back(OpaqueFadeLines);
+			}
+		}
+		else
+			mSteps.push_back(TranslucentTriangles);
+	}
+
+	mImage = QImage(mWidth, mHeight, QImage::Format_ARGB32);
+	mImageBits = mImage.bits();
+	mBytesPerLine = mImage.bytesPerLine();
+
+	QVector<int> Tiles(mTileColumns * mTileRows);
+	for (int TileIndex = 0; TileIndex < Tiles.size(); TileIndex++)
+		Tiles[TileIndex] = TileIndex;
+
+	QtConcurrent::blockingMap(Tiles, [this](int& TileIndex)
+	{
+		DrawTile(TileIndex);
+	});
+
+	mImageBits = nullptr;
+
+	return mImage;
+}
+
+void lcRasterizer::AddRenderMeshes(const lcScene& Scene, const lcArray<int>& Meshes, bool Translucent, bool Lit)
+{
+	const lcMatrix44 ViewProjectionMatrix = lcMul(mViewMatrix, mProjectionMatrix);
+	const lcMatrix44 InverseViewMatrix = lcMatrix44AffineInverse(mViewMatrix);
+	const lcVector3 EyePosition = lcMul30(-mViewMatrix.GetTranslation(), InverseViewMatrix);
+	const lcVector3 LightPosition = EyePosition + lcMul30(lcVector3(300.0f, 300.0f, 0.0f), InverseViewMatrix);
+
+	std::vector<lcVector4> Points;   // clip space positions
+	std::vector<lcVector2> Lighting; // diffuse and specular terms of the fake lighting shader
+
+	for (int MeshIndex : Meshes)
+	{
+		const lcRenderMesh& RenderMesh = Scene.mRenderMeshes[MeshIndex];
+		const lcMesh* Mesh = RenderMesh.Mesh;
+		const lcMeshLod& Lod = Mesh->mLods[RenderMesh.LodIndex];
+		const lcMatrix44 WorldViewProjectionMatrix = lcMul(RenderMesh.WorldMatrix, ViewProjectionMatrix);
+
+		Points.resize(Mesh->mNumVertices + Mesh->mNumTexturedVertices);
+		Lighting.resize(Points.size());
+
+		auto TransformVertex = [&](int VertexIndex, const lcVector3& Position, quint32 Normal)
+		{
+			Points[VertexIndex] = lcMul4(lcVector4(Position, 1.0f), WorldViewProjectionMatrix);
+
+			if (!Lit)
+				return;
+
+			lcVector3 WorldPosition = lcMul31(Position, RenderMesh.WorldMatrix);
+			lcVector3 WorldNormal = lcNormalize(lcMul30(lcUnpackNormal(Normal), RenderMesh.WorldMatrix));
+			lcVector3 LightDirection = lcNormalize(WorldPosition - LightPosition);
+			lcVector3 VertexToEye = lcNormalize(EyePosition - WorldPosition);
+			lcVector3 LightReflect = lcNormalize(LightDirection - 2.0f * lcDot(WorldNormal, LightDirection) * WorldNormal);
+			LightReflect = -LightReflect;
+
+			float Specular = qMin(powf(fabsf(lcDot(VertexToEye, LightReflect)), 8.0f), 1.0f) * 0.25f;
+			float Diffuse = qMin(fabsf(lcDot(WorldNormal, LightDirection)) * 0.6f + 0.65f, 1.0f);
+
+			Lighting[VertexIndex] = lcVector2(Diffuse, Specular);
+		};
+
+		const lcVertex* Vertices = (const lcVertex*)Mesh->mVertexData;
+		for (int VertexIdx = 0; VertexIdx < Mesh->mNumVertices; VertexIdx++)
+			TransformVertex(VertexIdx, Vertices[VertexIdx].Position, Vertices[VertexIdx].Normal);
+
+		const lcVertexTextured* TexturedVertices = (const lcVertexTextured*)(Vertices + Mesh->mNumVertices);
+		for (int VertexIdx = 0; VertexIdx < Mesh->mNumTexturedVertices; VertexIdx++)
+			TransformVertex(Mesh->mNumVertices + VertexIdx, TexturedVertices[VertexIdx].Position, TexturedVertices[VertexIdx].Normal);
+
+		for (int SectionIdx = 0; SectionIdx < Lod.NumSections; SectionIdx++)
+		{
+			const lcMeshSection* Section = &Lod.Sections[SectionIdx];
+			const bool Triangles = (Section->PrimitiveType & (LC_MESH_TRIANGLES | LC_MESH_TEXTURED_TRIANGLES)) != 0;
+			const bool Lines = (Section->PrimitiveType & (LC_MESH_LINES | LC_MESH_TEXTURED_LINES)) != 0;
+
+			if (!Triangles && !Lines)
+				continue;
+
+			int ColorIndex = Section->ColorIndex;
+			lcVector4 Color;
+
+			if (Triangles)
+			{
+				if (ColorIndex == gDefaultColor)
+					ColorIndex = RenderMesh.ColorIndex;
+
+				if (lcIsColorTranslucent(ColorIndex) != Translucent)
+					continue;
+
+				auto TintedColor = [ColorIndex](lcInterfaceColor InterfaceColor, float Weight)
+				{
+					lcVector3 Tinted(gColorList[ColorIndex].Value * Weight + gInterfaceColors[InterfaceColor] * (1.0f - Weight));
+					return lcVector4(Tinted, gColorList[ColorIndex].Value.w);
+				};
+
+				switch (RenderMesh.State)
+				{
+				case lcRenderMeshState::NORMAL:
+				case lcRenderMeshState::HIGHLIGHT:
+					Color = gColorList[ColorIndex].Value;
+					break;
+
+				case lcRenderMeshState::SELECTED:
+					Color = TintedColor(LC_COLOR_SELECTED, 0.5f);
+					break;
+
+				case lcRenderMeshState::FOCUSED:
+					Color = TintedColor(LC_COLOR_FOCUSED, 0.5f);
+					break;
+
+				case lcRenderMeshState::DISABLED:
+					Color = TintedColor(LC_COLOR_DISABLED, 0.25f);
+					break;
+				}
+			}
+			else
+			{
+				switch (RenderMesh.State)
+				{
+				case lcRenderMeshState::NORMAL:
+					Color = ColorIndex == gEdgeColor ? gColorList[RenderMesh.ColorIndex].Edge : gColorList[ColorIndex].Value;
+					break;
+
+				case lcRenderMeshState::SELECTED:
+					Color = gInterfaceColors[LC_COLOR_SELECTED];
+					break;
+
+				case lcRenderMeshState::FOCUSED:
+					Color = gInterfaceColors[LC_COLOR_FOCUSED];
+					break;
+
+				case lcRenderMeshState::HIGHLIGHT:
+					Color = gInterfaceColors[LC_COLOR_HIGHLIGHT];
+					break;
+
+				case lcRenderMeshState::DISABLED:
+					Color = gInterfaceColors[LC_COLOR_DISABLED];
+					break;
+				}
+			}
+
+			const lcRasterBin Bin = Triangles ? (Translucent ? LC_RASTER_TRANSLUCENT_TRIANGLES : LC_RASTER_OPAQUE_TRIANGLES) :
+			                                    (Translucent ? LC_RASTER_TRANSLUCENT_LINES : LC_RASTER_OPAQUE_LINES);
+			const int NumPoints = Triangles ? 3 : 2;
+			const int VertexOffset = Section->Texture ? Mesh->mNumVertices : 0;
+			const char* IndexData = (const char*)Mesh->mIndexData + Section->IndexOffset;
+
+			for (int Idx = 0; Idx + NumPoints <= Section->NumIndices; Idx += NumPoints)
+			{
+				lcVector4 ClipPoints[3];
+				lcVector4 Colors[3];
+
+				for (int PointIdx = 0; PointIdx < NumPoints; PointIdx++)
+				{
+					int VertexIndex = VertexOffset + (Mesh->mIndexType == GL_UNSIGNED_SHORT ? ((const quint16*)IndexData)[Idx + PointIdx] : ((const quint32*)IndexData)[Idx + PointIdx]);
+
+					ClipPoints[PointIdx] = Points[VertexIndex];
+
+					if (Triangles && Lit)
+					{
+						const lcVector2& Light = Lighting[VertexIndex];
+						Colors[PointIdx] = lcVector4(lcVector3(Color) * Light.x + lcVector3(Light.y, Light.y, Light.y), Color.w);
+					}
+					else
+						Colors[PointIdx] = Color;
+				}
+
+				AddClippedPrimitive(Bin, ClipPoints, Colors, NumPoints);
+			}
+		}
+	}
+}
+
+void lcRasterizer::AddClippedPrimitive(lcRasterBin Bin, const lcVector4* ClipPoints, const lcVector4* Colors, int NumPoints)
+{
+	// a triangle clipped by the near and far planes has at most 5 points
+	lcVector4 Points[2][5];
+	lcVector4 PointColors[2][5];
+	int Count = NumPoints;
+	int Current = 0;
+
+	for (int PointIdx = 0; PointIdx < NumPoints; PointIdx++)
+	{
+		Points[0][PointIdx] = ClipPoints[PointIdx];
+		PointColors[0][PointIdx] = Colors[PointIdx];
+	}
+
+	// keep -w <= z <= w as GL does, the near plane first
+	for (int Plane = 0; Plane < 2; Plane++)
+	{
+		const float Sign = Plane == 0 ? 1.0f : -1.0f;
+		const lcVector4* In = Points[Current];
+		const lcVector4* InColors = PointColors[Current];
+		lcVector4* Out = Points[1 - Current];
+		lcVector4* OutColors = PointColors[1 - Current];
+		int OutCount = 0;
+
+		auto Distance = [Sign](const lcVector4& Point)
+		{
+			return Point.w + Sign * Point.z;
+		};
+
+		if (Count == 2)
+		{
+			const float d0 = Distance(In[0]), d1 = Distance(In[1]);
+
+			if (d0 < 0.0f && d1 < 0.0f)
+				return;
+
+			for (int PointIdx = 0; PointIdx < 2; PointIdx++)
+			{
+				const float d = PointIdx ? d1 : d0;
+
+				if (d < 0.0f)
+				{
+					const float t = d0 / (d0 - d1);
+					Out[PointIdx] = In[0] + (In[1] - In[0]) * t;
+					OutColors[PointIdx] = InColors[0] + (InColors[1] - InColors[0]) * t;
+				}
+				else
+				{
+					Out[PointIdx] = In[PointIdx];
+					OutColors[PointIdx] = InColors[PointIdx];
+				}
+			}
+
+			OutCount = 2;
+		}
+		else
+		{
+			for (int PointIdx = 0; PointIdx < Count; PointIdx++)
+			{
+				const int NextIdx = (PointIdx + 1) % Count;
+				const float d = Distance(In[PointIdx]), Next = Distance(In[NextIdx]);
+
+				if (d >= 0.0f)
+				{
+					Out[OutCount] = In[PointIdx];
+					OutColors[OutCount++] = InColors[PointIdx];
+				}
+
+				if ((d >= 0.0f) != (Next >= 0.0f))
+				{
+					const float t = d / (d - Next);
+					Out[OutCount] = In[PointIdx] + (In[NextIdx] - In[PointIdx]) * t;
+					OutColors[OutCount++] = InColors[PointIdx] + (InColors[NextIdx] - InColors[PointIdx]) * t;
+				}
+			}
+
+			if (OutCount < 3)
+				return;
+		}
+
+		Count = OutCount;
+		Current = 1 - Current;
+	}
+
+	// project to pixels, a clipped triangle becomes a fan of triangles
+	lcVector3 Projected[5];
+
+	for (int PointIdx = 0; PointIdx < Count; PointIdx++)
+	{
+		const lcVector4& Clip = Points[Current][PointIdx];
+
+		if (Clip.w <= 0.000001f)
+			return;
+
+		const float InverseW = 1.0f / Clip.w;
+		Projected[PointIdx] = lcVector3((Clip.x * InverseW + 1.0f) * 0.5f * mWidth, (1.0f - Clip.y * InverseW) * 0.5f * mHeight, (Clip.z * InverseW + 1.0f) * 0.5f);
+	}
+
+	lcRasterPrimitive Primitive;
+	Primitive.NumPoints = Count == 2 ? 2 : 3;
+	Primitive.Points[0] = Projected[0];
+	Primitive.Colors[0] = PointColors[Current][0];
+
+	for (int PointIdx = 1; PointIdx + Primitive.NumPoints - 2 < Count; PointIdx++)
+	{
+		for (int FanIdx = 1; FanIdx < Primitive.NumPoints; FanIdx++)
+		{
+			Primitive.Points[FanIdx] = Projected[PointIdx + FanIdx - 1];
+			Primitive.Colors[FanIdx] = PointColors[Current][PointIdx + FanIdx - 1];
+		}
+
+		AddPrimitive(Bin, Primitive);
+	}
+}
+
+void lcRasterizer::AddPrimitive(lcRasterBin Bin, const lcRasterPrimitive& Primitive)
+{
+	float MinX = Primitive.Points[0].x, MaxX = MinX;
+	float MinY = Primitive.Points[0].y, MaxY = MinY;
+
+	for (int PointIdx = 1; PointIdx < Primitive.NumPoints; PointIdx++)
+	{
+		MinX = qMin(MinX, Primitive.Points[PointIdx].x);
+		MaxX = qMax(MaxX, Primitive.Points[PointIdx].x);
+		MinY = qMin(MinY, Primitive.Points[PointIdx].y);
+		MaxY = qMax(MaxY, Primitive.Points[PointIdx].y);
+	}
+
+	const float Margin = Primitive.NumPoints == 2 ? mLineWidth * 0.5f + 1.0f : 0.0f;
+	const int Left = qMax(int(floorf(MinX - Margin)), 0);
+	const int Right = qMin(int(ceilf(MaxX + Margin)), mWidth - 1);
+	const int Top = qMax(int(floorf(MinY - Margin)), 0);
+	const int Bottom = qMin(int(ceilf(MaxY + Margin)), mHeight - 1);
+
+	if (Left > Right || Top > Bottom)
+		return;
+
+	const int PrimitiveIndex = (int)mPrimitives[Bin].size();
+	mPrimitives[Bin].push_back(Primitive);
+
+	for (int TileRow = Top / LC_RASTER_TILE_SIZE; TileRow <= Bottom / LC_RASTER_TILE_SIZE; TileRow++)
+		for (int TileColumn = Left / LC_RASTER_TILE_SIZE; TileColumn <= Right / LC_RASTER_TILE_SIZE; TileColumn++)
+			mTileBins[Bin][TileRow * mTileColumns + TileColumn].push_back(PrimitiveIndex);
+}
+
+void lcRasterizer::DrawTile(int TileIndex)
+{
+	std::vector<float> Depth(LC_RASTER_TILE_SIZE * LC_RASTER_TILE_SIZE, 1.0f);
+	std::vector<lcVector4> Color(LC_RASTER_TILE_SIZE * LC_RASTER_TILE_SIZE, mBackgroundColor);
+
+	lcRasterTile Tile;
+	Tile.Left = (TileIndex % mTileColumns) * LC_RASTER_TILE_SIZE;
+	Tile.Top = (TileIndex / mTileColumns) * LC_RASTER_TILE_SIZE;
+	Tile.Right = qMin(Tile.Left + LC_RASTER_TILE_SIZE, mWidth);
+	Tile.Bottom = qMin(Tile.Top + LC_RASTER_TILE_SIZE, mHeight);
+	Tile.Depth = Depth.data();
+	Tile.Color = Color.data();
+
+	for (const lcRasterStep& Step : mSteps)
+	{
+		const std::vector<lcRasterPrimitive>& Primitives = mPrimitives[Step.Bin];
+
+		for (int PrimitiveIndex : mTileBins[Step.Bin][TileIndex])
+		{
+			const lcRasterPrimitive& Primitive = Primitives[PrimitiveIndex];
+
+			if (Primitive.NumPoints == 3)
+				DrawTriangle(Tile, Primitive, Step);
+			else
+				DrawLine(Tile, Primitive, Step);
+		}
+	}
+
+	auto ToByte = [](float Value)
+	{
+		return int(qBound(0.0f, Value, 1.0f) * 255.0f + 0.5f);
+	};
+
+	for (int y = Tile.Top; y < Tile.Bottom; y++)
+	{
+		QRgb* Pixels = (QRgb*)(mImageBits + y * mBytesPerLine);
+		const lcVector4* TileColor = Tile.Color + (y - Tile.Top) * LC_RASTER_TILE_SIZE;
+
+		for (int x = Tile.Left; x < Tile.Right; x++)
+		{
+			const lcVector4& Pixel = TileColor[x - Tile.Left];
+			Pixels[x] = qRgba(ToByte(Pixel.x), ToByte(Pixel.y), ToByte(Pixel.z), ToByte(Pixel.w));
+		}
+	}
+}
+
+void lcRasterizer::DrawTriangle(lcRasterTile& Tile, const lcRasterPrimitive& Triangle, const lcRasterStep& Step) const
+{
+	lcVector3 p0 = Triangle.Points[0], p1 = Triangle.Points[1], p2 = Triangle.Points[2];
+	lcVector4 c0 = Triangle.Colors[0], c1 = Triangle.Colors[1], c2 = Triangle.Colors[2];
+
+	float Area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+
+	if (Area == 0.0f)
+		return;
+
+	// GL front faces wind counterclockwise, that is a negative area once y points down
+	if (Step.CullBack && Area > 0.0f)
+		return;
+
+	if (Area < 0.0f)
+	{
+		std::swap(p1, p2);
+		std::swap(c1, c2);
+		Area = -Area;
+	}
+
+	const int Left = qMax(int(floorf(qMin(p0.x, qMin(p1.x, p2.x)))), Tile.Left);
+	const int Right = qMin(int(ceilf(qMax(p0.x, qMax(p1.x, p2.x)))), Tile.Right - 1);
+	const int Top = qMax(int(floorf(qMin(p0.y, qMin(p1.y, p2.y)))), Tile.Top);
+	const int Bottom = qMin(int(ceilf(qMax(p0.y, qMax(p1.y, p2.y)))), Tile.Bottom - 1);
+
+	if (Left > Right || Top > Bottom)
+		return;
+
+	// Edge functions, positive inside.  Pixels on a shared edge go to the
+	// triangle the edge is a top or left edge of so translucent seams are
+	// not blended twice.
+	struct lcEdge
+	{
+		float StepX;
+		float StepY;
+		float Row;
+		bool TopLeft;
+	};
+
+	const float x = Left + 0.5f;
+	const float y = Top + 0.5f;
+
+	auto SetupEdge = [x, y](const lcVector3& a, const lcVector3& b)
+	{
+		lcEdge Edge;
+		Edge.StepX = a.y - b.y;
+		Edge.StepY = b.x - a.x;
+		Edge.Row = Edge.StepY * (y - a.y) + Edge.StepX * (x - a.x);
+		Edge.TopLeft = b.y < a.y || (b.y == a.y && b.x > a.x);
+		return Edge;
+	};
+
+	lcEdge Edges[3] = { SetupEdge(p1, p2), SetupEdge(p2, p0), SetupEdge(p0, p1) };
+	const float InverseArea = 1.0f / Area;
+
+	auto Inside = [](float w, bool TopLeft)
+	{
+		return w > 0.0f || (w == 0.0f && TopLeft);
+	};
+
+	for (int py = Top; py <= Bottom; py++)
+	{
+		float w0 = Edges[0].Row, w1 = Edges[1].Row, w2 = Edges[2].Row;
+
+		for (int px = Left; px <= Right; px++)
+		{
+			if (Inside(w0, Edges[0].TopLeft) && Inside(w1, Edges[1].TopLeft) && Inside(w2, Edges[2].TopLeft))
+			{
+				const float b0 = w0 * InverseArea, b1 = w1 * InverseArea, b2 = w2 * InverseArea;
+				const float Depth = p0.z * b0 + p1.z * b1 + p2.z * b2;
+
+				WritePixel(Tile, px, py, Depth, c0 * b0 + c1 * b1 + c2 * b2, Step);
+			}
+
+			w0 += Edges[0].StepX;
+			w1 += Edges[1].StepX;
+			w2 += Edges[2].StepX;
+		}
+
+		Edges[0].Row += Edges[0].StepY;
+		Edges[1].Row += Edges[1].StepY;
+		Edges[2].Row += Edges[2].StepY;
+	}
+}
+
+void lcRasterizer::DrawLine(lcRasterTile& Tile, const lcRasterPrimitive& Line, const lcRasterStep& Step) const
+{
+	const lcVector3& p0 = Line.Points[0];
+	const lcVector3& p1 = Line.Points[1];
+	const float dx = p1.x - p0.x;
+	const float dy = p1.y - p0.y;
+	const float HalfWidth = mLineWidth * 0.5f + 1.0f;
+
+	// clip the line to the tile grown by the line width
+	float t0 = 0.0f, t1 = 1.0f;
+
+	auto Clip = [&t0, &t1](float p, float q)
+	{
+		if (p == 0.0f)
+			return q >= 0.0f;
+
+		float r = q / p;
+
+		if (p < 0.0f)
+		{
+			if (r > t1)
+				return false;
+			t0 = qMax(t0, r);
+		}
+		else
+		{
+			if (r < t0)
+				return false;
+			t1 = qMin(t1, r);
+		}
+
+		return true;
+	};
+
+	if (!Clip(-dx, p0.x - (Tile.Left - HalfWidth)) || !Clip(dx, (Tile.Right + HalfWidth) - p0.x) ||
+	    !Clip(-dy, p0.y - (Tile.Top - HalfWidth)) || !Clip(dy, (Tile.Bottom + HalfWidth) - p0.y))
+		return;
+
+	const int Size = qMax(int(mLineWidth + 0.5f), 1);
+	const float Offset = (Size - 1) * 0.5f;
+	const int Steps = qMax(int(ceilf(qMax(fabsf(dx), fabsf(dy)) * (t1 - t0))), 1);
+
+	for (int StepIdx = 0; StepIdx <= Steps; StepIdx++)
+	{
+		const float t = t0 + (t1 - t0) * StepIdx / Steps;
+		const float Depth = p0.z + (p1.z - p0.z) * t - LC_RASTER_LINE_DEPTH_BIAS;
+		const lcVector4 Color = Line.Colors[0] + (Line.Colors[1] - Line.Colors[0]) * t;
+		const int Left = int(floorf(p0.x + dx * t - Offset));
+		const int Top = int(floorf(p0.y + dy * t - Offset));
+
+		for (int py = qMax(Top, Tile.Top); py < qMin(Top + Size, Tile.Bottom); py++)
+			for (int px = qMax(Left, Tile.Left); px < qMin(Left + Size, Tile.Right); px++)
+				WritePixel(Tile, px, py, Depth, Color, Step);
+	}
+}
+
+void lcRasterizer::WritePixel(lcRasterTile& Tile, int x, int y, float Depth, const lcVector4& Color, const lcRasterStep& Step) const
+{
+	const int Offset = (y - Tile.Top) * LC_RASTER_TILE_SIZE + (x - Tile.Left);
+
+	if (Depth > Tile.Depth[Offset])
+		return;
+
+	if (Step.DepthWrite)
+		Tile.Depth[Offset] = Depth;
+
+	if (!Step.ColorWrite)
+		return;
+
+	lcVector4& Pixel = Tile.Color[Offset];
+
+	if (Step.Blend)
+		Pixel = Color * Color.w + Pixel * (1.0f - Color.w);
+	else
+		Pixel = Color;
+}
+/*** LPub3D Mod end ***/
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "lc_math.h"
+#include "lc_array.h"
+
+/*** LPub3D Mod - software rasterizer ***/
+/*
+ * Draws an lcScene into an image without OpenGL, for render hosts that have
+ * no framebuffer objects.  Every mesh is transformed once, its triangles and
+ * lines are binned into screen tiles, and the tiles are then rasterized in
+ * parallel, each with its own depth and colour buffer, following the passes
+ * lcScene::Draw makes for the current shading mode.  Triangles and lines
+ * crossing the near or far plane are clipped to it, as GL clips them.
+ * Conditional lines are
+ * skipped as they are in lcScene::Draw and textures are not sampled, so
+ * textured sections are drawn in their colour.
+ */
+
+struct lcRasterPrimitive
+{
+	lcVector3 Points[3]; // pixel x and y, depth from 0 to 1
+	lcVector4 Colors[3];
+	int NumPoints;       // 3 for a triangle, 2 for a line
+};
+
+class lcRasterizer
+{
+public:
+	lcRasterizer(int Width, int Height);
+
+	QImage Render(const lcScene& Scene, const lcMatrix44& ProjectionMatrix, const lcVector3& BackgroundColor);
+
+protected:
+	enum lcRasterBin
+	{
+		LC_RASTER_OPAQUE_TRIANGLES,
+		LC_RASTER_OPAQUE_LINES,
+		LC_RASTER_TRANSLUCENT_TRIANGLES,
+		LC_RASTER_TRANSLUCENT_LINES,
+		LC_RASTER_NUM_BINS
+	};
+
+	struct lcRasterStep
+	{
+		lcRasterBin Bin;
+		bool DepthWrite;
+		bool ColorWrite;
+		bool Blend;
+		bool CullBack;
+	};
+
+	struct lcRasterTile
+	{
+		int Left;
+		int Top;
+		int Right;
+		int Bottom;
+		float* Depth;
+		lcVector4* Color;
+	};
+
+	void AddRenderMeshes(const lcScene& Scene, const lcArray<int>& Meshes, bool Translucent, bool Lit);
+	void AddClippedPrimitive(lcRasterBin Bin, const lcVector4* ClipPoints, const lcVector4* Colors, int NumPoints);
+	void AddPrimitive(lcRasterBin Bin, const lcRasterPrimitive& Primitive);
+	void DrawTile(int TileIndex);
+	void DrawTriangle(lcRasterTile& Tile, const lcRasterPrimitive& Triangle, const lcRasterStep& Step) const;
+	void DrawLine(lcRasterTile& Tile, const lcRasterPrimitive& Line, const lcRasterStep& Step) const;
+	void WritePixel(lcRasterTile& Tile, int x, int y, float Depth, const lcVector4& Color, const lcRasterStep& Step) const;
+
+	int mWidth;
+	int mHeight;
+	int mTileColumns;
+	int mTileRows;
+	float mLineWidth;
+	lcMatrix44 mViewMatrix;
+	lcMatrix44 mProjectionMatrix;
+	lcVector4 mBackgroundColor;
+	std::vector<lcRasterStep> mSteps;
+	std::vector<lcRasterPrimitive> mPrimitives[LC_RASTER_NUM_BINS];
+	std::vector<std::vector<int>> mTileBins[LC_RASTER_NUM_BINS];
+	QImage mImage;
+	uchar* mImageBits;
+	int mBytesPerLine;
+};
+/*** LPub3D Mod end ***/
@@ -12,6 +12,15 @@ lcScene::lcScene()
 {
 	mActiveSubmodelInstance = nullptr;
 	mAllowWireframe = true;
+/*** LPub3D Mod - screen space LOD ***/
+	mLodScale = 0.0f;
+	mLodOrthographic = false;
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - scene statistics ***/
+	mStatistics.ConditionalLines = 0;
+	mStatistics.VisibleConditionalLines = 0;
+	mStatistics.ConditionalLineTime = 0;
+/*** LPub3D Mod end ***/
 }
 
 void lcScene::Begin(const lcMatrix44& ViewMatrix)
@@ -24,6 +33,11 @@ void lcScene::Begin(const lcMatrix44& ViewMatrix)
 	mTranslucentMeshes.RemoveAll();
 	mInterfaceObjects.RemoveAll();
 	mHasTexture = false;
+/*** LPub3D Mod - scene statistics ***/
+	mStatistics.ConditionalLines = 0;
+	mStatistics.VisibleConditionalLines = 0;
+	mStatistics.ConditionalLineTime = 0;
+/*** LPub3D Mod end ***/
 }
 
 void lcScene::End()
@@ -52,7 +66,14 @@ void lcScene::AddMesh(lcMesh* Mesh, const lcMatrix44& WorldMatrix, int ColorInde
 	RenderMesh.ColorIndex = ColorIndex;
 	RenderMesh.State = State;
 	RenderMesh.Distance = fabsf(lcMul31(WorldMatrix[3], mViewMatrix).z);
-	RenderMesh.LodIndex = RenderMesh.Mesh->GetLodIndex(RenderMesh.Distance);
+/*** LPub3D Mod - screen space LOD ***/
+	if (mLodScale > 0.0f)
+		RenderMesh.LodIndex = RenderMesh.Mesh->GetLodIndex(RenderMesh.Distance, mLodScale, mLodOrthographic);
+	else if (mLodScale < 0.0f)
+		RenderMesh.LodIndex = LC_MESH_LOD_HIGH;
+	else
+		RenderMesh.LodIndex = RenderMesh.Mesh->GetLodIndex(RenderMesh.Distance);
+/*** LPub3D Mod end ***/
 
 	bool Translucent = lcIsColorTranslucent(ColorIndex);
 
@@ -66,9 +87,62 @@ void lcScene::AddMesh(lcMesh* Mesh, const lcMatrix44& WorldMatrix, int ColorInde
 		mHasTexture = true;
 }
 
+/*** LPub3D Mod - batched conditional lines ***/
+/*
+ * A conditional line is drawn when its two control points fall on the same
+ * side of it on screen.  Rather than projecting four points and issuing a
+ * draw call per line, the mesh vertices are projected once into flat x and
+ * y arrays, every line of the section is tested in one pass over them and
+ * the visible lines are gathered into an index list drawn with one call.
+ * The per line test is kept as the PER_LINE setting of ConditionalLines.
+ */
+static void lcProjectConditionalVertices(const lcMesh* Mesh, const lcMatrix44& WorldViewProjectionMatrix, std::vector<float>& x, std::vector<float>& y)
+{
+	const lcVertex* VertexBuffer = (const lcVertex*)Mesh->mVertexData;
+	const int NumVertices = Mesh->mNumVertices;
+
+	x.resize(NumVertices);
+	y.resize(NumVertices);
+
+	for (int VertexIdx = 0; VertexIdx < NumVertices; VertexIdx++)
+	{
+		const lcVector3 Point = lcMul31(VertexBuffer[VertexIdx].Position, WorldViewProjectionMatrix);
+		x[VertexIdx] = Point.x;
+		y[VertexIdx] = Point.y;
+	}
+}
+
+template<typename IndexType>
+static void lcGatherConditionalLines(const IndexType* Indices, int NumIndices, const float* x, const float* y, std::vector<IndexType>& Visible)
+{
+	Visible.clear();
+
+	for (int i = 0; i < NumIndices; i += 4)
+	{
+		const IndexType i1 = Indices[i + 0];
+		const IndexType i2 = Indices[i + 1];
+		const IndexType i3 = Indices[i + 2];
+		const IndexType i4 = Indices[i + 3];
+		const float dy = y[i1] - y[i2];
+		const float dx = x[i2] - x[i1];
+
+		if ((dy * (x[i3] - x[i1]) + dx * (y[i3] - y[i1])) * (dy * (x[i4] - x[i1]) + dx * (y[i4] - y[i1])) >= 0)
+		{
+			Visible.push_back(i1);
+			Visible.push_back(i2);
+		}
+	}
+}
+/*** LPub3D Mod end ***/
+
 void lcScene::DrawRenderMeshes(lcContext* Context, int PrimitiveTypes, bool EnableNormals, bool DrawTranslucent, bool DrawTextured) const
 {
 	const lcArray<int>& Meshes = DrawTranslucent ? mTranslucentMeshes : mOpaqueMeshes;
+/*** LPub3D Mod - batched conditional lines ***/
+	std::vector<float> ConditionalX, ConditionalY;
+	std::vector<quint16> VisibleIndices16;
+	std::vector<quint32> VisibleIndices32;
+/*** LPub3D Mod end ***/
 
 /*** LPub3D Mod - Disable [No1. Reduce z-fighting 31703618c] ***/
 /***
@@ -156,42 +230,77 @@ void lcScene::DrawRenderMeshes(lcContext* Context, int PrimitiveTypes, bool Enab
 			else if (Section->PrimitiveType == LC_MESH_CONDITIONAL_LINES)
 			{
 				lcMatrix44 WorldViewProjectionMatrix = lcMul(RenderMesh.WorldMatrix, lcMul(mViewMatrix, Context->GetProjectionMatrix()));
-				lcVertex* VertexBuffer = (lcVertex*)Mesh->mVertexData;
-				int IndexBufferOffset = Mesh->mIndexCacheOffset != -1 ? Mesh->mIndexCacheOffset : 0;
+/*** LPub3D Mod - batched conditional lines ***/
+				QElapsedTimer ConditionalTimer;
+				ConditionalTimer.start();
 
 				int VertexBufferOffset = Mesh->mVertexCacheOffset != -1 ? Mesh->mVertexCacheOffset : 0;
 				Context->SetVertexFormat(VertexBufferOffset, 3, 1, 0, 0, EnableNormals);
 
-				if (Mesh->mIndexType == GL_UNSIGNED_SHORT)
+				mStatistics.ConditionalLines += Section->NumIndices / 4;
+
+				if (lcGetPreferences().mConditionalLines == lcConditionalLines::PER_LINE)
 				{
-					quint16* Indices = (quint16*)((char*)Mesh->mIndexData + Section->IndexOffset);
+					lcVertex* VertexBuffer = (lcVertex*)Mesh->mVertexData;
+					int IndexBufferOffset = Mesh->mIndexCacheOffset != -1 ? Mesh->mIndexCacheOffset : 0;
+					const int IndexSize = Mesh->mIndexType == GL_UNSIGNED_SHORT ? sizeof(quint16) : sizeof(quint32);
 
 					for (int i = 0; i < Section->NumIndices; i += 4)
 					{
-						lcVector3 p1 = lcMul31(VertexBuffer[Indices[i + 0]].Position, WorldViewProjectionMatrix);
-						lcVector3 p2 = lcMul31(VertexBuffer[Indices[i + 1]].Position, WorldViewProjectionMatrix);
-						lcVector3 p3 = lcMul31(VertexBuffer[Indices[i + 2]].Position, WorldViewProjectionMatrix);
-						lcVector3 p4 = lcMul31(VertexBuffer[Indices[i + 3]].Position, WorldViewProjectionMatrix);
+						int VertexIndices[4];
+
+						for (int PointIdx = 0; PointIdx < 4; PointIdx++)
+						{
+							const char* Index = (char*)Mesh->mIndexData + Section->IndexOffset + (i + PointIdx) * IndexSize;
+							VertexIndices[PointIdx] = Mesh->mIndexType == GL_UNSIGNED_SHORT ? *(const quint16*)Index : *(const quint32*)Index;
+						}
+
+						lcVector3 p1 = lcMul31(VertexBuffer[VertexIndices[0]].Position, WorldViewProjectionMatrix);
+						lcVector3 p2 = lcMul31(VertexBuffer[VertexIndices[1]].Position, WorldViewProjectionMatrix);
+						lcVector3 p3 = lcMul31(VertexBuffer[VertexIndices[2]].Position, WorldViewProjectionMatrix);
+						lcVector3 p4 = lcMul31(VertexBuffer[VertexIndices[3]].Position, WorldViewProjectionMatrix);
 
 						if (((p1.y - p2.y) * (p3.x - p1.x) + (p2.x - p1.x) * (p3.y - p1.y)) * ((p1.y - p2.y) * (p4.x - p1.x) + (p2.x - p1.x) * (p4.y - p1.y)) >= 0)
-							Context->DrawIndexedPrimitives(GL_LINES, 2, Mesh->mIndexType, IndexBufferOffset + Section->IndexOffset + i * sizeof(quint16));
+						{
+							Context->DrawIndexedPrimitives(GL_LINES, 2, Mesh->mIndexType, IndexBufferOffset + Section->IndexOffset + i * IndexSize);
+							mStatistics.VisibleConditionalLines++;
+						}
 					}
+
+					mStatistics.ConditionalLineTime += ConditionalTimer.nsecsElapsed();
+					continue;
+				}
+
+				lcProjectConditionalVertices(Mesh, WorldViewProjectionMatrix, ConditionalX, ConditionalY);
+
+				const void* VisibleIndices;
+				int NumVisibleIndices;
+
+				if (Mesh->mIndexType == GL_UNSIGNED_SHORT)
+				{
+					const quint16* Indices = (const quint16*)((char*)Mesh->mIndexData + Section->IndexOffset);
+					lcGatherConditionalLines(Indices, Section->NumIndices, ConditionalX.data(), ConditionalY.data(), VisibleIndices16);
+					VisibleIndices = VisibleIndices16.data();
+					NumVisibleIndices = (int)VisibleIndices16.size();
 				}
 				else
 				{
-					quint32* Indices = (quint32*)((char*)Mesh->mIndexData + Section->IndexOffset);
+					const quint32* Indices = (const quint32*)((char*)Mesh->mIndexData + Section->IndexOffset);
+					lcGatherConditionalLines(Indices, Section->NumIndices, ConditionalX.data(), ConditionalY.data(), VisibleIndices32);
+					VisibleIndices = VisibleIndices32.data();
+					NumVisibleIndices = (int)VisibleIndices32.size();
+				}
 
-					for (int i = 0; i < Section->NumIndices; i += 4)
-					{
-						lcVector3 p1 = lcMul31(VertexBuffer[Indices[i + 0]].Position, WorldViewProjectionMatrix);
-						lcVector3 p2 = lcMul31(VertexBuffer[Indices[i + 1]].Position, WorldViewProjectionMatrix);
-						lcVector3 p3 = lcMul31(VertexBuffer[Indices[i + 2]].Position, WorldViewProjectionMatrix);
-						lcVector3 p4 = lcMul31(VertexBuffer[Indices[i + 3]].Position, WorldViewProjectionMatrix);
+				mStatistics.VisibleConditionalLines += NumVisibleIndices / 2;
+				mStatistics.ConditionalLineTime += ConditionalTimer.nsecsElapsed();
 
-						if (((p1.y - p2.y) * (p3.x - p1.x) + (p2.x - p1.x) * (p3.y - p1.y)) * ((p1.y - p2.y) * (p4.x - p1.x) + (p2.x - p1.x) * (p4.y - p1.y)) >= 0)
-							Context->DrawIndexedPrimitives(GL_LINES, 2, Mesh->mIndexType, IndexBufferOffset + Section->IndexOffset + i * sizeof(quint32));
-					}
+				if (NumVisibleIndices)
+				{
+					Context->SetIndexBufferPointer(VisibleIndices);
+					Context->DrawIndexedPrimitives(GL_LINES, NumVisibleIndices, Mesh->mIndexType, 0);
+					Context->BindMesh(Mesh);
 				}
+/*** LPub3D Mod end ***/
 
 				continue;
 			}
@@ -251,8 +360,10 @@ void lcScene::Draw(lcContext* Context) const
 
 	Context->SetViewMatrix(mViewMatrix);
 
-	const bool DrawConditional = false;
 	const lcPreferences& Preferences = lcGetPreferences();
+/*** LPub3D Mod - batched conditional lines ***/
+	const bool DrawConditional = Preferences.mConditionalLines != lcConditionalLines::OFF;
+/*** LPub3D Mod end ***/
 
 	lcShadingMode ShadingMode = Preferences.mShadingMode;
 	if (ShadingMode == LC_SHADING_WIREFRAME && !mAllowWireframe)
@@ -3,11 +3,27 @@
 #include "lc_mesh.h"
 #include "lc_array.h"
 
+/*** LPub3D Mod - scene statistics ***/
+struct lcSceneStatistics
+{
+	int ConditionalLines;        // conditional lines tested
+	int VisibleConditionalLines; // conditional lines drawn
+	qint64 ConditionalLineTime;  // nanoseconds spent testing conditional lines
+};
+/*** LPub3D Mod end ***/
+
 class lcScene
 {
 public:
 	lcScene();
 
+/*** LPub3D Mod - scene statistics ***/
+	const lcSceneStatistics& GetStatistics() const
+	{
+		return mStatistics;
+	}
+/*** LPub3D Mod end ***/
+
 	void SetActiveSubmodelInstance(lcPiece* ActiveSubmodelInstance, const lcMatrix44& ActiveSubmodelTransform)
 	{
 		mActiveSubmodelInstance = ActiveSubmodelInstance;
@@ -34,6 +50,15 @@ public:
 		mAllowWireframe = AllowWireframe;
 	}
 
+/*** LPub3D Mod - screen space LOD ***/
+	// 0 picks the LOD by distance and a negative scale draws the high detail only
+	void SetLodScale(float LodScale, bool Orthographic)
+	{
+		mLodScale = LodScale;
+		mLodOrthographic = Orthographic;
+	}
+/*** LPub3D Mod end ***/
+
 	lcMatrix44 ApplyActiveSubmodelTransform(const lcMatrix44& WorldMatrix) const
 	{
 		return !mActiveSubmodelInstance ? WorldMatrix : lcMul(WorldMatrix, mActiveSubmodelTransform);
@@ -52,6 +77,10 @@ public:
 	void DrawInterfaceObjects(lcContext* Context) const;
 
 protected:
+/*** LPub3D Mod - software rasterizer ***/
+	friend class lcRasterizer;
+/*** LPub3D Mod end ***/
+
 	void DrawRenderMeshes(lcContext* Context, int PrimitiveTypes, bool EnableNormals, bool DrawTranslucent, bool DrawTextured) const;
 
 	lcMatrix44 mViewMatrix;
@@ -65,4 +94,11 @@ protected:
 	lcArray<int> mTranslucentMeshes;
 	lcArray<const lcObject*> mInterfaceObjects;
 	bool mHasTexture;
+/*** LPub3D Mod - scene statistics ***/
+	mutable lcSceneStatistics mStatistics;
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - screen space LOD ***/
+	float mLodScale;
+	bool mLodOrthographic;
+/*** LPub3D Mod end ***/
 };
@@ -4,6 +4,12 @@
 #include "lc_math.h"
 #include <zlib.h>
 #include <time.h>
+/*** LPub3D Mod - mapped archive ***/
+#include <QtEndian>
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - performance trace ***/
+#include "perftrace.h"
+/*** LPub3D Mod end ***/
 
 #if MAX_MEM_LEVEL >= 8
 #  define DEF_MEM_LEVEL 8
@@ -15,6 +21,10 @@ lcZipFile::lcZipFile()
 {
 	mModified = false;
 	mFile = nullptr;
+/*** LPub3D Mod - mapped archive ***/
+	mData = nullptr;
+	mDataSize = 0;
+/*** LPub3D Mod end ***/
 }
 
 lcZipFile::~lcZipFile()
@@ -34,6 +44,10 @@ bool lcZipFile::OpenRead(const QString& FileName)
 		return false;
 	}
 
+/*** LPub3D Mod - mapped archive ***/
+	MapFile();
+/*** LPub3D Mod end ***/
+
 	return true;
 }
 
@@ -47,9 +61,43 @@ bool lcZipFile::OpenRead(lcFile* File)
 		return false;
 	}
 
+/*** LPub3D Mod - mapped archive ***/
+	MapFile();
+/*** LPub3D Mod end ***/
+
 	return true;
 }
 
+/*** LPub3D Mod - mapped archive ***/
+/*
+ * Keep a read only view of the whole archive so ExtractFile can inflate
+ * entries straight from memory on any number of threads at once.  Disk
+ * archives are memory mapped, archives already in memory are used as they
+ * are.  If the view is not available ExtractFile reads through mFile under
+ * mMutex as before.
+ */
+void lcZipFile::MapFile()
+{
+	mData = nullptr;
+	mDataSize = 0;
+
+	lcDiskFile* DiskFile = dynamic_cast<lcDiskFile*>(mFile);
+
+	if (DiskFile)
+		mData = DiskFile->Map();
+	else
+	{
+		lcMemFile* MemFile = dynamic_cast<lcMemFile*>(mFile);
+
+		if (MemFile)
+			mData = MemFile->mBuffer;
+	}
+
+	if (mData)
+		mDataSize = mFile->GetLength();
+}
+/*** LPub3D Mod end ***/
+
 bool lcZipFile::OpenWrite(const QString& FileName)
 {
 	lcDiskFile* File = new lcDiskFile(FileName);
@@ -590,8 +638,119 @@ bool lcZipFile::ExtractFile(const char* FileName, lcMemFile& File, quint32 MaxLe
 	return false;
 }
 
+/*** LPub3D Mod - mapped archive ***/
+bool lcZipFile::ExtractMappedFile(int FileIndex, lcMemFile& File, quint32 MaxLength) const
+{
+	const lcZipFileInfo& FileInfo = mFiles[FileIndex];
+	const quint64 HeaderPos = FileInfo.offset_curfile + mBytesBeforeZipFile;
+
+	if (HeaderPos + 0x1e > mDataSize)
+		return false;
+
+	const uchar* Header = mData + HeaderPos;
+	const quint16 Flags = qFromLittleEndian<quint16>(Header + 6);
+	const quint16 CompressionMethod = qFromLittleEndian<quint16>(Header + 8);
+	const quint32 Crc = qFromLittleEndian<quint32>(Header + 14);
+	const quint32 CompressedSize = qFromLittleEndian<quint32>(Header + 18);
+	const quint32 UncompressedSize = qFromLittleEndian<quint32>(Header + 22);
+	const quint16 SizeFilename = qFromLittleEndian<quint16>(Header + 26);
+	const quint16 SizeExtraField = qFromLittleEndian<quint16>(Header + 28);
+
+	if (qFromLittleEndian<quint32>(Header) != 0x04034b50 || CompressionMethod != FileInfo.compression_method)
+		return false;
+
+	if (FileInfo.compression_method != 0 && FileInfo.compression_method != Z_DEFLATED)
+		return false;
+
+	if ((Flags & 8) == 0)
+	{
+		if (Crc != FileInfo.crc)
+			return false;
+
+		if (CompressedSize != 0xffffffffU && CompressedSize != FileInfo.compressed_size)
+			return false;
+
+		if (UncompressedSize != 0xffffffffU && UncompressedSize != FileInfo.uncompressed_size)
+			return false;
+	}
+
+	if (SizeFilename != FileInfo.size_filename)
+		return false;
+
+	const quint64 DataPos = HeaderPos + 0x1e + SizeFilename + SizeExtraField;
+
+	if (DataPos + FileInfo.compressed_size > mDataSize)
+		return false;
+
+	quint32 Length = lcMin((quint32)FileInfo.uncompressed_size, MaxLength);
+	File.SetLength(Length);
+	File.Seek(0, SEEK_SET);
+
+	if (FileInfo.compression_method == 0)
+	{
+		if (Length > FileInfo.compressed_size)
+			return false;
+
+		memcpy(File.mBuffer, mData + DataPos, Length);
+
+		return true;
+	}
+
+	z_stream Stream;
+
+	Stream.zalloc = (alloc_func)0;
+	Stream.zfree = (free_func)0;
+	Stream.opaque = (voidpf)0;
+	Stream.next_in = 0;
+	Stream.avail_in = 0;
+
+	if (inflateInit2(&Stream, -MAX_WBITS) != Z_OK)
+		return false;
+
+	Stream.next_in = (Bytef*)(mData + DataPos);
+	Stream.avail_in = (uInt)FileInfo.compressed_size;
+	Stream.next_out = (Bytef*)File.mBuffer;
+	Stream.avail_out = Length;
+
+	int Error = Z_OK;
+
+	while (Stream.avail_out > 0 && Error == Z_OK)
+	{
+		Error = inflate(&Stream, Z_SYNC_FLUSH);
+
+		if ((Error >= 0) && (Stream.msg != nullptr))
+			Error = Z_DATA_ERROR;
+	}
+
+	const quint64 Read = Stream.total_out;
+
+	inflateEnd(&Stream);
+
+	if (Error == Z_OK)
+		return true;
+
+	if (Error != Z_STREAM_END)
+		return false;
+
+	if (Read == FileInfo.uncompressed_size && crc32(0, File.mBuffer, (uInt)Read) != FileInfo.crc)
+		return false;
+
+	return Read != 0;
+}
+/*** LPub3D Mod end ***/
+
 bool lcZipFile::ExtractFile(int FileIndex, lcMemFile& File, quint32 MaxLength)
 {
+/*** LPub3D Mod - performance trace ***/
+	PerfSpan perfSpan("library", "lcZipFile::ExtractFile",
+	                  PerfTrace::enabled() ? QString::fromLatin1(mFiles[FileIndex].file_name) : QString(),
+	                  int(mFiles[FileIndex].uncompressed_size));
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - mapped archive ***/
+	if (mData)
+		return ExtractMappedFile(FileIndex, File, MaxLength);
+/*** LPub3D Mod end ***/
+
 	QMutexLocker Lock(&mMutex);
 
 	quint32 SizeVar;
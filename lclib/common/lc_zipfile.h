@@ -75,9 +75,17 @@ protected:
 	quint64 SearchCentralDir();
 	quint64 SearchCentralDir64();
 	bool CheckFileCoherencyHeader(int FileIndex, quint32* SizeVar, quint64* OffsetLocalExtraField, quint32* SizeLocalExtraField);
+/*** LPub3D Mod - mapped archive ***/
+	void MapFile();
+	bool ExtractMappedFile(int FileIndex, lcMemFile& File, quint32 MaxLength) const;
+/*** LPub3D Mod end ***/
 
 	QMutex mMutex;
 	lcFile* mFile;
+/*** LPub3D Mod - mapped archive ***/
+	const uchar* mData;
+	quint64 mDataSize;
+/*** LPub3D Mod end ***/
 
 	bool mModified;
 	bool mZip64;
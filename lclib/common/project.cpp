@@ -2059,7 +2059,42 @@ void Project::ExportHTML(const lcHTMLExportOptions& Options)
 	}
 }
 
-bool Project::ExportPOVRay(const QString& FileName)
+/*** LPub3D Mod - POV shared parts ***/
+/*
+ * Scenes exported with SharedParts, such as the render dialog's, include
+ * each part mesh from a file of its own in <scene>_parts, written the first
+ * time the mesh is used.  The file name carries a hash of the geometry and
+ * of the colour names the mesh refers to, so a part whose mesh changes gets
+ * a new file, and a scene only includes the parts it places.
+ */
+
+static QString lcPOVMeshKey(const lcMesh* Mesh, const char** ColorTable)
+{
+	QCryptographicHash Hash(QCryptographicHash::Md5);
+
+	Hash.addData(static_cast<const char*>(Mesh->mVertexData), Mesh->mVertexDataSize);
+	Hash.addData(static_cast<const char*>(Mesh->mIndexData), Mesh->mIndexDataSize);
+
+	const lcMeshLod& Lod = Mesh->mLods[LC_MESH_LOD_HIGH];
+
+	for (int SectionIdx = 0; SectionIdx < Lod.NumSections; SectionIdx++)
+	{
+		const lcMeshSection& Section = Lod.Sections[SectionIdx];
+		const int Values[4] = { Section.ColorIndex, Section.IndexOffset, Section.NumIndices, Section.PrimitiveType };
+
+		Hash.addData(reinterpret_cast<const char*>(Values), sizeof(Values));
+
+		if (Section.ColorIndex != gDefaultColor)
+			Hash.addData(ColorTable[Section.ColorIndex]);
+	}
+
+	return QString::fromLatin1(Hash.result().toHex().left(16));
+}
+/*** LPub3D Mod end ***/
+
+/*** LPub3D Mod - POV shared parts ***/
+bool Project::ExportPOVRay(const QString& FileName, bool SharedParts)
+/*** LPub3D Mod end ***/
 {
 	std::vector<lcModelPartsEntry> ModelParts = GetModelParts();
 
@@ -2251,6 +2286,13 @@ bool Project::ExportPOVRay(const QString& FileName)
 
 	POVFile.WriteLine("\n");
 
+/*** LPub3D Mod - POV shared parts ***/
+	QDir SharedPartsDir(QFileInfo(SaveFileName).absolutePath() + QLatin1Char('/') + QFileInfo(SaveFileName).completeBaseName() + QLatin1String("_parts"));
+
+	if (SharedParts && !SharedPartsDir.exists() && !QDir().mkpath(SharedPartsDir.absolutePath()))
+		SharedParts = false;
+/*** LPub3D Mod end ***/
+
 	lcArray<const char*> ColorTablePointer;
 	ColorTablePointer.SetSize(NumColors);
 	for (int ColorIdx = 0; ColorIdx < NumColors; ColorIdx++)
@@ -2291,6 +2333,38 @@ bool Project::ExportPOVRay(const QString& FileName)
 			sprintf(Entry.first, "lc_%s", Name);
 		}
 
+/*** LPub3D Mod - POV shared parts ***/
+		if (SharedParts && !ModelPart.Mesh)
+		{
+			QString PartFileName = SharedPartsDir.absoluteFilePath(QString::fromLatin1("lc_%1_%2.inc").arg(QString::fromLatin1(Name), lcPOVMeshKey(Mesh, &ColorTablePointer[0])));
+
+			if (!QFileInfo(PartFileName).exists())
+			{
+				QString TempFileName = PartFileName + QLatin1String(".tmp");
+				lcDiskFile PartFile(TempFileName);
+
+				if (PartFile.Open(QIODevice::WriteOnly))
+				{
+					Mesh->ExportPOVRay(PartFile, Name, &ColorTablePointer[0]);
+
+					sprintf(Line, "#declare lc_%s_clear = lc_%s\n\n", Name, Name);
+					PartFile.WriteLine(Line);
+					PartFile.Close();
+
+					if (!QFile::rename(TempFileName, PartFileName))
+						QFile::remove(TempFileName);
+				}
+			}
+
+			if (QFileInfo(PartFileName).exists())
+			{
+				sprintf(Line, "#include \"%s\"\n\n", PartFileName.toLocal8Bit().constData());
+				POVFile.WriteLine(Line);
+				continue;
+			}
+		}
+/*** LPub3D Mod end ***/
+
 		Mesh->ExportPOVRay(POVFile, Name, &ColorTablePointer[0]);
 
 		sprintf(Line, "#declare lc_%s_clear = lc_%s\n\n", Name, Name);
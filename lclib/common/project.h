@@ -107,7 +107,9 @@ public:
 	void ExportCOLLADA(const QString& FileName);
 	void ExportCSV();
 	void ExportHTML(const lcHTMLExportOptions& Options);
-	bool ExportPOVRay(const QString& FileName);
+/*** LPub3D Mod - POV shared parts ***/
+	bool ExportPOVRay(const QString& FileName, bool SharedParts = false);
+/*** LPub3D Mod end ***/
 	void ExportWavefront(const QString& FileName);
 
 	void UpdatePieceInfo(PieceInfo* Info) const;
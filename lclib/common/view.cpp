@@ -8,6 +8,9 @@
 #include "piece.h"
 #include "pieceinf.h"
 #include "lc_synth.h"
+/*** LPub3D Mod - software rasterizer ***/
+#include "lc_rasterizer.h"
+/*** LPub3D Mod end ***/
 
 /*** LPub3D Mod - Rotate Step ***/
 #include "lpub.h"
@@ -380,6 +383,27 @@ lcMatrix44 View::GetProjectionMatrix() const
 		return lcMatrix44Perspective(mCamera->m_fovy, AspectRatio, mCamera->m_zNear, mCamera->m_zFar);
 }
 
+/*** LPub3D Mod - screen space LOD ***/
+float View::GetLodScale() const
+{
+	switch (lcGetPreferences().mNativeLod)
+	{
+	case lcNativeLod::DISTANCE:
+		return 0.0f;
+
+	case lcNativeLod::HIGH:
+		return -1.0f;
+
+	case lcNativeLod::IMAGE_SIZE:
+		break;
+	}
+
+	int Height = mRenderImage.isNull() ? mHeight : mRenderImage.height();
+
+	return GetProjectionMatrix().r[1].y * Height / 2.0f;
+}
+/*** LPub3D Mod end ***/
+
 lcMatrix44 View::GetTileProjectionMatrix(int CurrentRow, int CurrentColumn, int CurrentTileWidth, int CurrentTileHeight) const
 {
 	int ImageWidth = mRenderImage.width();
@@ -777,6 +801,21 @@ void View::EndRenderToImage()
 	mContext->ClearFramebuffer();
 }
 
+/*** LPub3D Mod - software rasterizer ***/
+QImage View::RenderSoftwareImage(int Width, int Height)
+{
+	mWidth = Width;
+	mHeight = Height;
+
+	mScene.SetLodScale(GetLodScale(), mCamera->IsOrtho());
+	mModel->GetScene(mScene, mCamera, false, mHighlight, mActiveSubmodelInstance, mActiveSubmodelTransform);
+
+	lcRasterizer Rasterizer(Width, Height);
+
+	return Rasterizer.Render(mScene, GetProjectionMatrix(), mModel->GetProperties().mBackgroundSolidColor);
+}
+/*** LPub3D Mod end ***/
+
 void View::OnDraw()
 {
 	if (!mModel)
@@ -784,6 +823,10 @@ void View::OnDraw()
 
 	bool DrawInterface = mWidget != nullptr;
 
+/*** LPub3D Mod - screen space LOD ***/
+	// the interactive viewer keeps the distance LOD
+	mScene.SetLodScale(mRenderImage.isNull() ? 0.0f : GetLodScale(), mCamera->IsOrtho());
+/*** LPub3D Mod end ***/
 	mModel->GetScene(mScene, mCamera, DrawInterface, mHighlight, mActiveSubmodelInstance, mActiveSubmodelTransform);
 
 	if (DrawInterface && mTrackTool == LC_TRACKTOOL_INSERT)
@@ -124,6 +124,15 @@ public:
 	void SetCameraAngles(float Latitude, float Longitude);
 	void SetDefaultCamera();
 	lcMatrix44 GetProjectionMatrix() const;
+/*** LPub3D Mod - screen space LOD ***/
+	float GetLodScale() const;
+/*** LPub3D Mod end ***/
+/*** LPub3D Mod - scene statistics ***/
+	const lcScene& GetScene() const
+	{
+		return mScene;
+	}
+/*** LPub3D Mod end ***/
 	LC_CURSOR_TYPE GetCursor() const;
 	void ShowContextMenu() const;
 
@@ -161,6 +170,10 @@ public:
 		return mRenderImage;
 	}
 
+/*** LPub3D Mod - software rasterizer ***/
+	QImage RenderSoftwareImage(int Width, int Height);
+/*** LPub3D Mod end ***/
+
 /*** LPub3D Mod - Moved from protected: for rotate angles ***/
 public:
 	lcTrackButton mTrackButton;
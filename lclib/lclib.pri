@@ -25,6 +25,7 @@ HEADERS += \
     $$PWD/common/lc_model.h \
     $$PWD/common/lc_partselectionwidget.h \
     $$PWD/common/lc_profile.h \
+    $$PWD/common/lc_rasterizer.h \
     $$PWD/common/lc_scene.h \
     $$PWD/common/lc_selectbycolordialog.h \
     $$PWD/common/lc_shortcuts.h \
@@ -83,6 +84,7 @@ SOURCES +=  \
     $$PWD/common/lc_model.cpp \
     $$PWD/common/lc_partselectionwidget.cpp \
     $$PWD/common/lc_profile.cpp \
+    $$PWD/common/lc_rasterizer.cpp \
     $$PWD/common/lc_scene.cpp \
     $$PWD/common/lc_selectbycolordialog.cpp \
     $$PWD/common/lc_shortcuts.cpp \
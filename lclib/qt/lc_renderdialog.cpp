@@ -109,8 +109,10 @@ void lcRenderDialog::on_RenderButton_clicked()
 
 	QString FileName = GetPOVFileName();
 
-	if (!lcGetActiveProject()->ExportPOVRay(FileName))
+/*** LPub3D Mod - POV shared parts ***/
+	if (!lcGetActiveProject()->ExportPOVRay(FileName, true))
 		return;
+/*** LPub3D Mod end ***/
 
 	QStringList Arguments;
 
@@ -18,10 +18,12 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QTextStream>
+#include <QElapsedTimer>
 #include "lpub_preferences.h"
 #include "name.h"
 #include "version.h"
 #include "QsLog.h"
+#include "perftrace.h"
 
 int                         Annotations::returnInt;
 QString                     Annotations::returnString;
@@ -38,6 +40,20 @@ QHash<QString, QString>     Annotations::ld2blCodesXRef;
 QHash<QString, QString>     Annotations::ld2rbColorsXRef;
 QHash<QString, QString>     Annotations::ld2rbCodesXRef;
 
+AnnotationTable             Annotations::blCodesTable;
+AnnotationTable             Annotations::legoElementsTable;
+AnnotationTable             Annotations::ld2blCodesXRefTable;
+AnnotationTable             Annotations::ld2rbCodesXRefTable;
+
+static void logTableLoad(const QString &table, int entries, bool cached, qint64 elapsed)
+{
+    logInfo() << QString("Loaded %1 %2 from %3 in %4 ms")
+                         .arg(entries)
+                         .arg(table)
+                         .arg(cached ? "cache" : "text file")
+                         .arg(elapsed);
+}
+
 void Annotations::loadLD2BLColorsXRef(QByteArray& Buffer){
 /*
 # File: ld2blcolorsxref.lst
@@ -1014,19 +1030,30 @@ Annotations::Annotations()
 {
     returnString = QString();
 
+    QString message;
+    if (!loadAnnotations(message)) {
+        if (Preferences::modeGUI){
+            QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
+        } else {
+            logError() << message;
+        }
+    }
+}
+
+// Load the annotation lists that are still empty. Errors are returned in
+// result instead of being reported, so the lists can be read by a startup
+// worker; a list that failed is read again, and reported, by the next
+// Annotations instance.
+bool Annotations::loadAnnotations(QString &result)
+{
     if (titleAnnotations.size() == 0) {
         QString annotations = Preferences::titleAnnotationsFile;
         QFile file(annotations);
         if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-            QString message = QString("Failed to open Title Annotations file: %1:\n%2")
-                                      .arg(annotations)
-                                      .arg(file.errorString());
-            if (Preferences::modeGUI){
-                QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
-            } else {
-                logError() << message;
-            }
-            return;
+            result = QString("Failed to open Title Annotations file: %1:\n%2")
+                             .arg(annotations)
+                             .arg(file.errorString());
+            return false;
         }
         QTextStream in(&file);
 
@@ -1058,15 +1085,10 @@ Annotations::Annotations()
         QString annotations = Preferences::freeformAnnotationsFile;
         QFile file(annotations);
         if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-            QString message = QString("Failed to open Freeform Annotations file: %1:\n%2")
-                                      .arg(annotations)
-                                      .arg(file.errorString());
-            if (Preferences::modeGUI){
-                QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
-            } else {
-                logError() << message;
-            }
-            return;
+            result = QString("Failed to open Freeform Annotations file: %1:\n%2")
+                             .arg(annotations)
+                             .arg(file.errorString());
+            return false;
         }
         QTextStream in(&file);
 
@@ -1101,15 +1123,10 @@ Annotations::Annotations()
         if (!styleFile.isEmpty()) {
             QFile file(styleFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-                QString message = QString("Failed to open Annotation style file: %1:\n%2")
-                                          .arg(styleFile)
-                                          .arg(file.errorString());
-                if (Preferences::modeGUI){
-                    QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
-                } else {
-                    logError() << message;
-                }
-                return;
+                result = QString("Failed to open Annotation style file: %1:\n%2")
+                                 .arg(styleFile)
+                                 .arg(file.errorString());
+                return false;
             }
             QTextStream in(&file);
 
@@ -1164,15 +1181,10 @@ Annotations::Annotations()
         if (!blColorsFile.isEmpty()) {
             QFile file(blColorsFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-                QString message = QString("Failed to open BrickLink colors.txt file: %1:\n%2")
-                                          .arg(blColorsFile)
-                                          .arg(file.errorString());
-                if (Preferences::modeGUI){
-                    QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
-                } else {
-                    logError() << message;
-                }
-                return;
+                result = QString("Failed to open BrickLink colors.txt file: %1:\n%2")
+                                 .arg(blColorsFile)
+                                 .arg(file.errorString());
+                return false;
             }
             QTextStream in(&file);
 
@@ -1223,15 +1235,10 @@ Annotations::Annotations()
         if (!ld2blColorsXRefFile.isEmpty()) {
             QFile file(ld2blColorsXRefFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-                QString message = QString("Failed to open ld2blcolorsxref.lst file: %1:\n%2")
-                                          .arg(ld2blColorsXRefFile)
-                                          .arg(file.errorString());
-                if (Preferences::modeGUI){
-                    QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
-                } else {
-                    logError() << message;
-                }
-                return;
+                result = QString("Failed to open ld2blcolorsxref.lst file: %1:\n%2")
+                                 .arg(ld2blColorsXRefFile)
+                                 .arg(file.errorString());
+                return false;
             }
             QTextStream in(&file);
 
@@ -1276,21 +1283,18 @@ Annotations::Annotations()
         }
     }
 
-    if (ld2blCodesXRef.size() == 0) {
-        QString ld2blCodesXRefFile = Preferences::ld2blCodesXRefFile;
+    // Rebrickable Codes
+
+    if (ld2rbColorsXRef.size() == 0) {
+        QString ld2rbColorsXRefFile = Preferences::ld2rbColorsXRefFile;
         QRegExp rx("^([^\\t]+)\\t+\\s*([^\\t]+).*$");
-        if (!ld2blCodesXRefFile.isEmpty()) {
-            QFile file(ld2blCodesXRefFile);
+        if (!ld2rbColorsXRefFile.isEmpty()) {
+            QFile file(ld2rbColorsXRefFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-                QString message = QString("Failed to open ld2blcodesxref.lst file: %1:\n%2")
-                                          .arg(ld2blCodesXRefFile)
-                                          .arg(file.errorString());
-                if (Preferences::modeGUI){
-                    QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
-                } else {
-                    logError() << message;
-                }
-                return;
+                result = QString("Failed to open ld2rbcolorsxref.lst file: %1:\n%2")
+                                 .arg(ld2rbColorsXRefFile)
+                                 .arg(file.errorString());
+                return false;
             }
             QTextStream in(&file);
 
@@ -1300,26 +1304,26 @@ Annotations::Annotations()
                 QString sLine = in.readLine(0);
                 if (sLine.contains(rxin)) {
                     rx.setPattern(rxin.cap(1));
-//                    logDebug() << "LD2BL CodesXRef RegExp Pattern: " << rxin.cap(1);
+//                    logDebug() << "LD2RB ColorsXRef RegExp Pattern: " << rxin.cap(1);
                     break;
                 }
             }
 
-           in.seek(0);
+            in.seek(0);
 
             // Load input values
             while ( ! in.atEnd()) {
                 QString sLine = in.readLine(0);
                 if (sLine.contains(rx)) {
-                    QString ldpartid = rx.cap(1);
-                    QString blitemid = rx.cap(2).trimmed();
-                    ld2blCodesXRef[ldpartid.toLower()] = blitemid;
+                    QString ldcolorid = rx.cap(1);
+                    QString rbcolorid = rx.cap(2).trimmed();
+                    ld2rbColorsXRef[ldcolorid.toLower()] = rbcolorid;
                 }
             }
         } else {
-            ld2blCodesXRef.clear();
+            ld2rbColorsXRef.clear();
             QByteArray Buffer;
-            loadLD2BLCodesXRef(Buffer);
+            loadLD2RBColorsXRef(Buffer);
             QTextStream instream(Buffer);
             for (QString sLine = instream.readLine(); !sLine.isNull(); sLine = instream.readLine())
             {
@@ -1327,31 +1331,44 @@ Annotations::Annotations()
                 if (comment == '#' || comment == ' ')
                     continue;
                 if (sLine.contains(rx)) {
-                    QString ldpartid = rx.cap(1);
-                    QString blitemid = rx.cap(2).trimmed();
-                    ld2blCodesXRef[ldpartid.toLower()] = blitemid;
+                    QString ldcolorid = rx.cap(1);
+                    QString rbcolorid = rx.cap(2).trimmed();
+                    ld2rbColorsXRef[ldcolorid.toLower()] = rbcolorid;
                 }
             }
         }
     }
 
-    // Rebrickable Codes
+    return true;
+}
 
-    if (ld2rbColorsXRef.size() == 0) {
-        QString ld2rbColorsXRefFile = Preferences::ld2rbColorsXRefFile;
+// key: ldpartid
+// val: blitemid
+bool Annotations::loadLD2BLCodesXRef(){
+    if (ld2blCodesXRef.size() == 0 && ! ld2blCodesXRefTable.isOpen()) {
+        PerfSpan perfSpan("annotations", "Annotations::loadLD2BLCodesXRef");
+        QElapsedTimer timer;
+        timer.start();
+        QString ld2blCodesXRefFile = Preferences::ld2blCodesXRefFile;
         QRegExp rx("^([^\\t]+)\\t+\\s*([^\\t]+).*$");
-        if (!ld2rbColorsXRefFile.isEmpty()) {
-            QFile file(ld2rbColorsXRefFile);
+        if (!ld2blCodesXRefFile.isEmpty()) {
+            QStringList sources = QStringList() << ld2blCodesXRefFile;
+            if (ld2blCodesXRefTable.open(sources)) {
+                logTableLoad("LDraw to BrickLink part cross references", ld2blCodesXRefTable.size(), true, timer.elapsed());
+                return true;
+            }
+
+            QFile file(ld2blCodesXRefFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-                QString message = QString("Failed to open ld2rbcolorsxref.lst file: %1:\n%2")
-                                          .arg(ld2rbColorsXRefFile)
+                QString message = QString("Failed to open ld2blcodesxref.lst file: %1:\n%2")
+                                          .arg(ld2blCodesXRefFile)
                                           .arg(file.errorString());
                 if (Preferences::modeGUI){
                     QMessageBox::warning(nullptr,QMessageBox::tr("LPub3D"),message);
                 } else {
                     logError() << message;
                 }
-                return;
+                return false;
             }
             QTextStream in(&file);
 
@@ -1361,26 +1378,29 @@ Annotations::Annotations()
                 QString sLine = in.readLine(0);
                 if (sLine.contains(rxin)) {
                     rx.setPattern(rxin.cap(1));
-//                    logDebug() << "LD2RB ColorsXRef RegExp Pattern: " << rxin.cap(1);
+//                    logDebug() << "LD2BL CodesXRef RegExp Pattern: " << rxin.cap(1);
                     break;
                 }
             }
 
-            in.seek(0);
+           in.seek(0);
 
             // Load input values
             while ( ! in.atEnd()) {
                 QString sLine = in.readLine(0);
                 if (sLine.contains(rx)) {
-                    QString ldcolorid = rx.cap(1);
-                    QString rbcolorid = rx.cap(2).trimmed();
-                    ld2rbColorsXRef[ldcolorid.toLower()] = rbcolorid;
+                    QString ldpartid = rx.cap(1);
+                    QString blitemid = rx.cap(2).trimmed();
+                    ld2blCodesXRef[ldpartid.toLower()] = blitemid;
                 }
             }
+
+            ld2blCodesXRefTable.save(sources, ld2blCodesXRef);
+            logTableLoad("LDraw to BrickLink part cross references", ld2blCodesXRef.size(), false, timer.elapsed());
         } else {
-            ld2rbColorsXRef.clear();
+            ld2blCodesXRef.clear();
             QByteArray Buffer;
-            loadLD2RBColorsXRef(Buffer);
+            loadLD2BLCodesXRef(Buffer);
             QTextStream instream(Buffer);
             for (QString sLine = instream.readLine(); !sLine.isNull(); sLine = instream.readLine())
             {
@@ -1388,18 +1408,32 @@ Annotations::Annotations()
                 if (comment == '#' || comment == ' ')
                     continue;
                 if (sLine.contains(rx)) {
-                    QString ldcolorid = rx.cap(1);
-                    QString rbcolorid = rx.cap(2).trimmed();
-                    ld2rbColorsXRef[ldcolorid.toLower()] = rbcolorid;
+                    QString ldpartid = rx.cap(1);
+                    QString blitemid = rx.cap(2).trimmed();
+                    ld2blCodesXRef[ldpartid.toLower()] = blitemid;
                 }
             }
         }
     }
+    return true;
+}
 
-    if (ld2rbCodesXRef.size() == 0) {
+// key: ldpartid
+// val: rbitemid
+bool Annotations::loadLD2RBCodesXRef(){
+    if (ld2rbCodesXRef.size() == 0 && ! ld2rbCodesXRefTable.isOpen()) {
+        PerfSpan perfSpan("annotations", "Annotations::loadLD2RBCodesXRef");
+        QElapsedTimer timer;
+        timer.start();
         QString ld2rbCodesXRefFile = Preferences::ld2rbCodesXRefFile;
         QRegExp rx("^([^\\t]+)\\t+\\s*([^\\t]+).*$");
         if (!ld2rbCodesXRefFile.isEmpty()) {
+            QStringList sources = QStringList() << ld2rbCodesXRefFile;
+            if (ld2rbCodesXRefTable.open(sources)) {
+                logTableLoad("LDraw to Rebrickable part cross references", ld2rbCodesXRefTable.size(), true, timer.elapsed());
+                return true;
+            }
+
             QFile file(ld2rbCodesXRefFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
                 QString message = QString("Failed to open ld2rbcodesxref.lst file: %1:\n%2")
@@ -1410,7 +1444,7 @@ Annotations::Annotations()
                 } else {
                     logError() << message;
                 }
-                return;
+                return false;
             }
             QTextStream in(&file);
 
@@ -1436,6 +1470,9 @@ Annotations::Annotations()
                     ld2rbCodesXRef[ldpartid.toLower()] = rbitemid;
                 }
             }
+
+            ld2rbCodesXRefTable.save(sources, ld2rbCodesXRef);
+            logTableLoad("LDraw to Rebrickable part cross references", ld2rbCodesXRef.size(), false, timer.elapsed());
         } else {
             ld2rbCodesXRef.clear();
             QByteArray Buffer;
@@ -1454,16 +1491,29 @@ Annotations::Annotations()
             }
         }
     }
+    return true;
 }
 
 // key : blitemid+blcolorid
 // val1: blitemid+"-"+blcolorid
 // val2: elementid
 bool Annotations::loadBLCodes(){
-    if (blCodes.size() == 0) {
+    if (blCodes.size() == 0 && ! blCodesTable.isOpen()) {
+        PerfSpan perfSpan("annotations", "Annotations::loadBLCodes");
+        QElapsedTimer timer;
+        timer.start();
         QString blCodesFile = Preferences::blCodesFile;
         QRegExp rx("^([^\\t]+)\\t+\\s*([^\\t]+)\\t+\\s*([^\\t]+).*$");
         if (! blCodesFile.isEmpty()) {
+            // element keys are built with the BrickLink colour table
+            QStringList sources = QStringList() << blCodesFile;
+            if (! Preferences::blColorsFile.isEmpty())
+                sources << Preferences::blColorsFile;
+            if (blCodesTable.open(sources)) {
+                logTableLoad("BrickLink codes", blCodesTable.size(), true, timer.elapsed());
+                return true;
+            }
+
             QFile file(blCodesFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
                 QString message = QString("Failed to open BrickLink codes.txt file: %1:\n%2")
@@ -1519,6 +1569,8 @@ bool Annotations::loadBLCodes(){
 //            Stream.flush();
 // DEBUG <<<---
 
+            blCodesTable.save(sources, blCodes, 2);
+            logTableLoad("BrickLink codes", blCodes.size(), false, timer.elapsed());
         } else {
            return  false;
         }
@@ -1575,6 +1627,11 @@ bool Annotations::loadBLCodes(QByteArray &Buffer){
             outstream.flush();
             file.close();
 
+            QStringList sources = QStringList() << file.fileName();
+            if (! Preferences::blColorsFile.isEmpty())
+                sources << Preferences::blColorsFile;
+            blCodesTable.save(sources, blCodes, 2);
+
             QString message = QString("Finished Writing, Proceed %1 lines for file [%2]")
                                       .arg(counter)
                                       .arg(file.fileName());
@@ -1604,10 +1661,19 @@ bool Annotations::loadBLCodes(QByteArray &Buffer){
 // key: ldpartid+ldcolorid
 // val: elementid
 bool Annotations::loadLEGOElements(){
-    if (legoElements.size() == 0) {
+    if (legoElements.size() == 0 && ! legoElementsTable.isOpen()) {
+        PerfSpan perfSpan("annotations", "Annotations::loadLEGOElements");
+        QElapsedTimer timer;
+        timer.start();
         QString legoElementsFile = Preferences::legoElementsFile;
         QRegExp rx("^([^\\t]+)\\t+\\s*([^\\t]+)\\t+\\s*([^\\t]+).*$");
         if (!legoElementsFile.isEmpty()) {
+            QStringList sources = QStringList() << legoElementsFile;
+            if (legoElementsTable.open(sources)) {
+                logTableLoad("LEGO elements", legoElementsTable.size(), true, timer.elapsed());
+                return true;
+            }
+
             QFile file(legoElementsFile);
             if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
                 QString message = QString("Failed to open legoelements.lst file: %1:\n%2")
@@ -1645,6 +1711,9 @@ bool Annotations::loadLEGOElements(){
                     legoElements[QString(ldpartid+ldcolorid).toLower()] = elementid;
                 }
             }
+
+            legoElementsTable.save(sources, legoElements);
+            logTableLoad("LEGO elements", legoElements.size(), false, timer.elapsed());
         } else {
             QString message = QString("LEGO Elements file was not found : %1").arg(legoElementsFile);
             if (Preferences::modeGUI){
@@ -1709,6 +1778,11 @@ const QString &Annotations::getBLColorID(QString blcolorname)
 const QString &Annotations::getLEGOElement(QString elementkey)
 {
     loadLEGOElements();
+    PerfSpan perfSpan("annotations", "Annotations::getLEGOElement", elementkey);
+    if (legoElementsTable.isOpen()) {
+        returnString = legoElementsTable.value(elementkey.toLower());
+        return returnString;
+    }
     if (legoElements.contains(elementkey.toLower())) {
         return legoElements[elementkey.toLower()];
     }
@@ -1719,26 +1793,59 @@ const QString &Annotations::getLEGOElement(QString elementkey)
 const QString &Annotations::getBLElement(QString ldcolorid, QString ldpartid, int which)
 {
     loadBLCodes();
+    loadLD2BLCodesXRef();
+    PerfSpan perfSpan("annotations", "Annotations::getBLElement", ldpartid);
+    returnString = QString();
     QString blcolorid,elementkey;
     if (ld2blColorsXRef.contains(ldcolorid.toLower())) {
         blcolorid = ld2blColorsXRef[ldcolorid.toLower()];
     }
     if (!blcolorid.isEmpty()){
         elementkey = QString(ldpartid+blcolorid).toLower();
-        if (blCodes.contains(elementkey)){
-            return blCodes[elementkey][which];
+        if (hasBLCode(elementkey)){
+            returnString = getBLCode(elementkey,which);
+            return returnString;
         }
         else
-        if (ld2blCodesXRef.contains(ldpartid.toLower())) {
-            elementkey = QString(ld2blCodesXRef[ldpartid.toLower()]+blcolorid).toLower();
-            if (blCodes.contains(elementkey)) {
-                return blCodes[elementkey][which];
+        if (hasLD2BLCode(ldpartid.toLower())) {
+            elementkey = QString(getLD2BLCode(ldpartid.toLower())+blcolorid).toLower();
+            if (hasBLCode(elementkey)) {
+                returnString = getBLCode(elementkey,which);
+                return returnString;
             }
         }
     }
     return returnString;
 }
 
+bool Annotations::hasBLCode(const QString &elementkey)
+{
+    if (blCodesTable.isOpen())
+        return blCodesTable.contains(elementkey);
+    return blCodes.contains(elementkey);
+}
+
+QString Annotations::getBLCode(const QString &elementkey, int which)
+{
+    if (blCodesTable.isOpen())
+        return blCodesTable.value(elementkey,which);
+    return blCodes[elementkey].value(which);
+}
+
+bool Annotations::hasLD2BLCode(const QString &ldpartid)
+{
+    if (ld2blCodesXRefTable.isOpen())
+        return ld2blCodesXRefTable.contains(ldpartid);
+    return ld2blCodesXRef.contains(ldpartid);
+}
+
+QString Annotations::getLD2BLCode(const QString &ldpartid)
+{
+    if (ld2blCodesXRefTable.isOpen())
+        return ld2blCodesXRefTable.value(ldpartid);
+    return ld2blCodesXRef.value(ldpartid);
+}
+
 const int &Annotations::getRBColorID(QString ldcolorid)
 {
     returnInt = -1;
@@ -1749,6 +1856,13 @@ const int &Annotations::getRBColorID(QString ldcolorid)
 
 const QString &Annotations::getRBPartID(QString ldpartid)
 {
+    loadLD2RBCodesXRef();
+    PerfSpan perfSpan("annotations", "Annotations::getRBPartID", ldpartid);
+    if (ld2rbCodesXRefTable.isOpen()) {
+        if (ld2rbCodesXRefTable.contains(ldpartid.toLower()))
+            returnString = ld2rbCodesXRefTable.value(ldpartid.toLower());
+        return returnString;
+    }
     if (ld2rbCodesXRef.contains(ldpartid.toLower()))
         returnString = ld2rbCodesXRef[ldpartid.toLower()];
     return returnString;
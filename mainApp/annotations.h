@@ -19,6 +19,8 @@
 #include <QString>
 #include <QStringList>
 
+#include "annotationtable.h"
+
 class Annotations {
   private:
     static int                         returnInt;
@@ -35,8 +37,19 @@ class Annotations {
 
     static QHash<QString, QString>     ld2rbColorsXRef;
     static QHash<QString, QString>     ld2rbCodesXRef;
+
+    static AnnotationTable             blCodesTable;
+    static AnnotationTable             legoElementsTable;
+    static AnnotationTable             ld2blCodesXRefTable;
+    static AnnotationTable             ld2rbCodesXRefTable;
+
+    static bool hasBLCode(const QString &elementkey);
+    static QString getBLCode(const QString &elementkey, int which);
+    static bool hasLD2BLCode(const QString &ldpartid);
+    static QString getLD2BLCode(const QString &ldpartid);
   public:
     Annotations();
+    static bool loadAnnotations(QString &result);
     static const QString &freeformAnnotation(QString part);
     static const int &getAnnotationStyle(QString part);
     static const int &getAnnotationCategory(QString part);
@@ -52,6 +65,9 @@ class Annotations {
     static void loadLD2RBColorsXRef(QByteArray &Buffer);
     static void loadLD2RBCodesXRef(QByteArray &Buffer);
 
+    static bool loadLD2BLCodesXRef();
+    static bool loadLD2RBCodesXRef();
+
     static bool loadBLCodes();
     static bool loadBLCodes(QByteArray &Buffer);
     static bool loadLEGOElements();
@@ -0,0 +1,311 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * This file reads and writes the compiled annotation tables described in
+ * annotationtable.h.  All numbers in the cache are little endian:
+ *
+ *   header   magic, version, stamp, key count, values per key,
+ *            record bytes, checksum - seven 32 bit words
+ *   index    one 32 bit record offset per key, in key order
+ *   records  16 bit length and UTF-8 bytes of the key, then of each value
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtEndian>
+
+#include <algorithm>
+
+#include "annotationtable.h"
+#include "perftrace.h"
+
+#define ANNOTATION_TABLE_MAGIC   0x5441504C   // LPAT
+#define ANNOTATION_TABLE_VERSION 1
+#define ANNOTATION_TABLE_HEADER  28
+
+static quint32 fnv1a(const uchar *data, qint64 size, quint32 hash = 2166136261u)
+{
+  for (qint64 i = 0; i < size; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static void appendWord(QByteArray &buffer, quint32 value)
+{
+  uchar word[4];
+  qToLittleEndian(value, word);
+  buffer.append(reinterpret_cast<const char *>(word), 4);
+}
+
+static void appendString(QByteArray &buffer, const QByteArray &string)
+{
+  uchar length[2];
+  qToLittleEndian(quint16(string.size()), length);
+  buffer.append(reinterpret_cast<const char *>(length), 2);
+  buffer.append(string);
+}
+
+AnnotationTable::AnnotationTable()
+{
+  _data    = nullptr;
+  _records = nullptr;
+  _end     = nullptr;
+  _count   = 0;
+  _values  = 0;
+}
+
+AnnotationTable::~AnnotationTable()
+{
+  close();
+}
+
+void AnnotationTable::close()
+{
+  if (_data) {
+    _file.unmap(const_cast<uchar *>(_data));
+  }
+  _file.close();
+  _data    = nullptr;
+  _records = nullptr;
+  _end     = nullptr;
+  _count   = 0;
+  _values  = 0;
+}
+
+QString AnnotationTable::cacheFile(const QStringList &sources)
+{
+  QString cachePath = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+  return QString("%1/annotations/%2.bin").arg(cachePath).arg(QFileInfo(sources.first()).fileName());
+}
+
+quint32 AnnotationTable::stamp(const QStringList &sources, bool &ok)
+{
+  QByteArray identity = QByteArray::number(ANNOTATION_TABLE_VERSION);
+  ok = ! sources.isEmpty();
+  for (const QString &source : sources) {
+    QFileInfo info(source);
+    if ( ! info.exists()) {
+      ok = false;
+      break;
+    }
+    identity += QString("|%1|%2|%3")
+                .arg(info.canonicalFilePath())
+                .arg(info.size())
+                .arg(info.lastModified().toMSecsSinceEpoch()).toUtf8();
+  }
+  return fnv1a(reinterpret_cast<const uchar *>(identity.constData()), identity.size());
+}
+
+bool AnnotationTable::open(const QStringList &sources)
+{
+  PerfSpan perfSpan("annotations", "AnnotationTable::open", sources.value(0));
+
+  close();
+
+  bool ok;
+  quint32 sourceStamp = stamp(sources, ok);
+  if ( ! ok) {
+    return false;
+  }
+
+  _file.setFileName(cacheFile(sources));
+  if ( ! _file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  qint64 size = _file.size();
+  const uchar *data = size >= ANNOTATION_TABLE_HEADER ? _file.map(0, size) : nullptr;
+  if ( ! data) {
+    _file.close();
+    return false;
+  }
+
+  quint32 header[7];
+  for (int i = 0; i < 7; i++) {
+    header[i] = qFromLittleEndian<quint32>(data + i * 4);
+  }
+
+  quint32 count       = header[3];
+  quint32 recordBytes = header[5];
+  qint64  indexBytes  = qint64(count) * 4;
+
+  bool valid = header[0] == ANNOTATION_TABLE_MAGIC   &&
+               header[1] == ANNOTATION_TABLE_VERSION &&
+               header[2] == sourceStamp              &&
+               size == ANNOTATION_TABLE_HEADER + indexBytes + recordBytes &&
+               header[6] == fnv1a(data + ANNOTATION_TABLE_HEADER, size - ANNOTATION_TABLE_HEADER);
+
+  for (quint32 i = 0; valid && i < count; i++) {
+    valid = qFromLittleEndian<quint32>(data + ANNOTATION_TABLE_HEADER + i * 4) < recordBytes;
+  }
+
+  if ( ! valid) {
+    _file.unmap(const_cast<uchar *>(data));
+    _file.close();
+    return false;
+  }
+
+  _data    = data;
+  _records = data + ANNOTATION_TABLE_HEADER + indexBytes;
+  _end     = _records + recordBytes;
+  _count   = count;
+  _values  = header[4];
+  return true;
+}
+
+bool AnnotationTable::save(const QStringList &sources, const QHash<QString, QStringList> &table, int values)
+{
+  QVector<Entry> entries;
+  entries.reserve(table.size());
+  for (auto it = table.constBegin(); it != table.constEnd(); ++it) {
+    Entry entry;
+    entry.key = it.key().toUtf8();
+    for (int i = 0; i < values; i++) {
+      entry.values.append(i < it.value().size() ? it.value()[i].toUtf8() : QByteArray());
+    }
+    entries.append(entry);
+  }
+  return write(sources, entries, values);
+}
+
+bool AnnotationTable::save(const QStringList &sources, const QHash<QString, QString> &table)
+{
+  QVector<Entry> entries;
+  entries.reserve(table.size());
+  for (auto it = table.constBegin(); it != table.constEnd(); ++it) {
+    Entry entry;
+    entry.key = it.key().toUtf8();
+    entry.values.append(it.value().toUtf8());
+    entries.append(entry);
+  }
+  return write(sources, entries, 1);
+}
+
+bool AnnotationTable::write(const QStringList &sources, QVector<Entry> &entries, int values)
+{
+  PerfSpan perfSpan("annotations", "AnnotationTable::write", sources.value(0), entries.size());
+
+  bool ok;
+  quint32 sourceStamp = stamp(sources, ok);
+  if ( ! ok) {
+    return false;
+  }
+
+  std::sort(entries.begin(), entries.end());
+
+  QByteArray index, records;
+  for (const Entry &entry : entries) {
+    appendWord(index, quint32(records.size()));
+    appendString(records, entry.key.left(0xFFFF));
+    for (const QByteArray &value : entry.values) {
+      appendString(records, value.left(0xFFFF));
+    }
+  }
+
+  QByteArray body = index + records;
+
+  QByteArray header;
+  appendWord(header, ANNOTATION_TABLE_MAGIC);
+  appendWord(header, ANNOTATION_TABLE_VERSION);
+  appendWord(header, sourceStamp);
+  appendWord(header, quint32(entries.size()));
+  appendWord(header, quint32(values));
+  appendWord(header, quint32(records.size()));
+  appendWord(header, fnv1a(reinterpret_cast<const uchar *>(body.constData()), body.size()));
+
+  QString fileName = cacheFile(sources);
+  QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+  // a run that still has the old cache mapped keeps reading the old inode
+  QSaveFile file(fileName);
+  if ( ! file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+  file.write(header);
+  file.write(body);
+  return file.commit();
+}
+
+const uchar *AnnotationTable::find(const QByteArray &key) const
+{
+  if ( ! _data) {
+    return nullptr;
+  }
+
+  const uchar *index = _data + ANNOTATION_TABLE_HEADER;
+  quint32 lo = 0, hi = _count;
+
+  while (lo < hi) {
+    quint32 mid = lo + (hi - lo) / 2;
+    const uchar *record = _records + qFromLittleEndian<quint32>(index + mid * 4);
+    if (record + 2 > _end) {
+      return nullptr;
+    }
+    int length = qFromLittleEndian<quint16>(record);
+    if (record + 2 + length > _end) {
+      return nullptr;
+    }
+    int compare = memcmp(record + 2, key.constData(), size_t(qMin(length, key.size())));
+    if (compare == 0) {
+      compare = length - key.size();
+    }
+    if (compare == 0) {
+      return record;
+    } else if (compare < 0) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return nullptr;
+}
+
+bool AnnotationTable::contains(const QString &key) const
+{
+  return find(key.toUtf8()) != nullptr;
+}
+
+QString AnnotationTable::value(const QString &key, int which) const
+{
+  const uchar *record = find(key.toUtf8());
+  if ( ! record || which < 0 || quint32(which) >= _values) {
+    return QString();
+  }
+
+  // step over the key and the values before which
+  for (int i = 0; i <= which; i++) {
+    record += 2 + qFromLittleEndian<quint16>(record);
+    if (record + 2 > _end) {
+      return QString();
+    }
+  }
+
+  int length = qFromLittleEndian<quint16>(record);
+  if (record + 2 + length > _end) {
+    return QString();
+  }
+  return QString::fromUtf8(reinterpret_cast<const char *>(record + 2), length);
+}
@@ -0,0 +1,99 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * An annotation table is a compiled copy of one of the large reference
+ * tables Annotations reads from the extras folder - the BrickLink codes,
+ * the LEGO elements and the LDraw to BrickLink and Rebrickable part cross
+ * references.  The first time a table is parsed it is written to the user
+ * cache as a sorted string table, and later runs map that file and look
+ * keys up with a binary search instead of running every line of the text
+ * file through a QRegExp.
+ *
+ * The cache file starts with a format version, a stamp made from the path,
+ * size and modification time of every source file the table was built
+ * from, and a checksum of the rest of the file.  A cache that does not
+ * match on all three is ignored and the table is parsed again.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#ifndef ANNOTATIONTABLE_H
+#define ANNOTATIONTABLE_H
+
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class AnnotationTable {
+public:
+  AnnotationTable();
+  ~AnnotationTable();
+
+  /* map the cache compiled from sources, false if missing or stale */
+  bool open(const QStringList &sources);
+
+  /* compile the table parsed from sources into the cache */
+  bool save(const QStringList &sources, const QHash<QString, QStringList> &table, int values);
+  bool save(const QStringList &sources, const QHash<QString, QString> &table);
+
+  void close();
+
+  bool isOpen() const
+  {
+    return _data != nullptr;
+  }
+
+  int size() const
+  {
+    return int(_count);
+  }
+
+  bool contains(const QString &key) const;
+
+  /* value number which for key, or a null string */
+  QString value(const QString &key, int which = 0) const;
+
+private:
+  struct Entry {
+    QByteArray        key;
+    QList<QByteArray> values;
+    bool operator<(const Entry &other) const
+    {
+      return key < other.key;
+    }
+  };
+
+  bool write(const QStringList &sources, QVector<Entry> &entries, int values);
+  const uchar *find(const QByteArray &key) const;
+
+  static QString cacheFile(const QStringList &sources);
+  static quint32 stamp(const QStringList &sources, bool &ok);
+
+  QFile        _file;
+  const uchar *_data;       // mapped cache file
+  const uchar *_records;    // first record, past the header and index
+  const uchar *_end;        // end of the records
+  quint32      _count;      // number of keys
+  quint32      _values;     // values per key
+};
+
+#endif // ANNOTATIONTABLE_H
@@ -15,6 +15,7 @@
 #include "application.h"
 
 #include <QDir>
+#include <QDateTime>
 #include <iostream>
 #include <QMessageBox>
 #include <TCFoundation/TCUserDefaults.h>
@@ -22,11 +23,14 @@
 #include "lpub_preferences.h"
 #include "lpub.h"
 #include "resolution.h"
+#include "annotations.h"
 
 #include "lc_math.h"
 #include "lc_profile.h"
 
 #include "updatecheck.h"
+#include "startup.h"
+#include "perftrace.h"
 
 #include "QsLogDest.h"
 
@@ -115,6 +119,8 @@ Application::Application(int &argc, char **argv)
   m_instance = this;
   m_console_mode = false;
   m_print_output = false;
+  m_startup_trace = false;
+  m_performance_trace = false;
   m_redirect_io_to_console = true;
 #ifdef Q_OS_WIN
   m_allocated_console = false;
@@ -327,6 +333,12 @@ void Application::initialize()
             if (Param == QLatin1String("-ns") || Param == QLatin1String("--no-stdout-log"))
                 Preferences::setStdOutToLogPreference(true);
             else
+            if (Param == QLatin1String("-st") || Param == QLatin1String("--startup-trace"))
+                m_startup_trace = true;
+            else
+            if (Param == QLatin1String("-pt") || Param == QLatin1String("--performance-trace"))
+                m_performance_trace = true;
+            else
             // Version output
             if (Param == QLatin1String("-v") || Param == QLatin1String("--version"))
             {
@@ -365,23 +377,33 @@ void Application::initialize()
                 fprintf(stdout, "  +ll, ++liblego: Load the LDraw LEGO archive parts library in GUI mode.\n");
                 fprintf(stdout, "  +lt, ++libtente: Load the LDraw TENTE archive parts library in GUI mode.\n");
                 fprintf(stdout, "  +lv, ++libvexiq: Load the LDraw VEXIQ archive parts library in GUI mode.\n");
+                fprintf(stdout, "  -bm, --batch-manifest <path>: Process each model file listed in the manifest, one per line followed by its own options, in this one process.\n");
+                fprintf(stdout, "  -br, --batch-report <path>: Write the JSON status and timing report of a batch manifest run to this file. Default is standard output.\n");
+                fprintf(stdout, "  -cl, --conditional-lines <off|line|batch>: Draw conditional lines in native renderer images, testing each line on its own or a mesh section in one batch, and log the line counts. Default is off.\n");
                 fprintf(stdout, "  -d, --image-output-directory <directory>: Designate the png, jpg or bmp save folder using absolute path.\n");
                 fprintf(stdout, "  -fc, --fade-steps-color <LDraw color code>: Set the global fade color. Overridden by fade opacity - if opacity not 100 percent. Default is %s\n",LEGO_FADE_COLOUR_DEFAULT);
                 fprintf(stdout, "  -fo, --fade-step-opacity <percent>: Set the fade steps opacity percent. Overrides fade color - if opacity not 100 percent. Default is %s percent\n",QString(FADE_OPACITY_DEFAULT).toLatin1().constData());
                 fprintf(stdout, "  -fs, --fade-steps: Turn on fade previous steps. Default is off.\n");
                 fprintf(stdout, "  -hc, --highlight-step-color <Hex color code>: Set the step highlight color. Color code optional. Format is #RRGGBB. Default is %s.\n",HIGHLIGHT_COLOUR_DEFAULT);
                 fprintf(stdout, "  -hs, --highlight-step: Turn on highlight current step. Default is off.\n");
+                fprintf(stdout, "  -ic, --index-check: Count the pages with the page index and again with a full page walk, and log any difference. Default is off.\n");
+                fprintf(stdout, "  -lc, --lod-check: Load parts from the library instead of the mesh cache and log any primitive whose low detail version does not match its files. Default is off.\n");
                 fprintf(stdout, "  -ll, --liblego: Load the LDraw LEGO archive parts library in command console mode.\n");
                 fprintf(stdout, "  -lt, --libtente: Load the LDraw TENTE archive parts library in command console mode.\n");
                 fprintf(stdout, "  -lv, --libvexiq: Load the LDraw VEXIQ archive parts library in command console mode.\n");
+                fprintf(stdout, "  -nl, --native-lod <size|distance|high>: Pick the mesh detail of native renderer images by size in the image, by camera distance as the 3DViewer does, or always the high detail. Default is size.\n");
                 fprintf(stdout, "  -ns, --no-stdout-log: Do not enable standard output for logged entries. Useful on Linux to prevent double (stdout and QSLog) output. Default is off.\n");
                 fprintf(stdout, "  -o, --export-option <option>: Set output format pdf, png, jpeg, bmp, stl, 3ds, pov, dae or obj. Used with process-export. Default is pdf.\n");
                 fprintf(stdout, "  -of, --pdf-output-file <path>: Designate the pdf document save file using absolute path.\n");
                 fprintf(stdout, "  -p, --preferred-renderer <renderer>: Set renderer native, ldglite, ldview, ldview-sc, ldview-scsl, povray, or povray-ldv. Default is native.\n ");
                 fprintf(stdout, "  -pe, --process-export: Export instruction document or images. Used with export-option. Default is pdf document.\n");
                 fprintf(stdout, "  -pf, --process-file: Process ldraw file and generate images in png format.\n");
+                fprintf(stdout, "  -pt, --performance-trace: Write a Chrome trace (JSON) of page generation to the logs folder. Default is off.\n");
                 fprintf(stdout, "  -r, --range <page range>: Set page range - e.g. 1,2,9,10-42. Default is all pages.\n");
+                fprintf(stdout, "  -rj, --render-jobs <number>: Run at most this many POV-Ray renders at once. Default is as many as the cores take.\n");
                 fprintf(stdout, "  -rs, --reset-search-dirs: Reset the LDraw parts directories to those searched by default. Default is off.\n");
+                fprintf(stdout, "  -sr, --software-render: Draw native renderer images with the software rasterizer instead of OpenGL. Default is off.\n");
+                fprintf(stdout, "  -st, --startup-trace: Print the time taken by each startup stage. Default is off.\n");
                 fprintf(stdout, "  -v, --version: Output LPub3D version information and exit.\n");
                 fprintf(stdout, "  -x, --clear-cache: Reset the LDraw file and image caches. Used with export-option change. Default is off.\n");
 //              fprintf(stdout, "  -im, --image-matte: [Experimental] Turn on image matting for fade previous step. Combine current and previous images using pixel blending - LDView only. Default is off.\n");
@@ -554,6 +576,11 @@ void Application::initialize()
 
     qRegisterMetaType<LogType>("LogType");
 
+    if (m_performance_trace || Preferences::performanceTrace)
+        PerfTrace::start(QDir(Preferences::lpubDataPath+"/logs").filePath(
+                         QString("%1Trace-%2.json").arg(VER_PRODUCTNAME_STR)
+                         .arg(QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss"))));
+
     logInfo() << QString("Initializing application...");
 
     // splash
@@ -573,23 +600,6 @@ void Application::initialize()
 
     emit splashMsgSig(QString("5% - Loading library for %1...").arg(Preferences::validLDrawPartsLibrary));
 
-    // Preferences
-    Preferences::lpub3dLibPreferences(false);
-    Preferences::ldrawPreferences(false);
-
-    emit splashMsgSig("15% - Preferences loading...");
-
-    Preferences::lpub3dUpdatePreferences();
-    Preferences::fadestepPreferences();
-    Preferences::highlightstepPreferences();
-    Preferences::unitsPreferences();
-    Preferences::annotationPreferences();
-    Preferences::pliPreferences();
-    Preferences::userInterfacePreferences();
-
-    // Resolution
-    defaultResolutionType(Preferences::preferCentimeters);
-
     // Translator - not implemented
     QTranslator QtTranslator;
     if (QtTranslator.load(QLocale::system(), "qt", "_", QLibraryInfo::location(QLibraryInfo::TranslationsPath)))
@@ -636,31 +646,76 @@ void Application::initialize()
 * initialize::createStatusBar                            (gui->initialize)
 * initialize::createDockWindows                          (gui->initialize)
 * initialize::toggleLCStatusBar                          (gui->initialize)
+*
+* Each stage below is a startup task (see startup.h). Main tasks run here
+* in order; the LDraw color parts and annotation lists are read on worker
+* threads while the 3D viewer and the windows are built, and the update
+* check waits until the main window is shown. The workers follow the GUI
+* stage because getRequireds can still change the preferences they read.
 */
 
-    // set theme
-    setTheme();
+    m_startup.add("Preferences", [this]() {
+        Preferences::lpub3dLibPreferences(false);
+        Preferences::ldrawPreferences(false);
 
-    emit splashMsgSig(QString("20% - %1 GUI window loading...").arg(VER_PRODUCTNAME_STR));
+        emit splashMsgSig("15% - Preferences loading...");
 
-    // initialize gui
-    gui = new Gui();
+        Preferences::lpub3dUpdatePreferences();
+        Preferences::fadestepPreferences();
+        Preferences::highlightstepPreferences();
+        Preferences::unitsPreferences();
+        Preferences::annotationPreferences();
+        Preferences::pliPreferences();
+        Preferences::userInterfacePreferences();
 
-    // Check if preferred renderer set and launch Preference dialogue if not to set Renderer
-    gui->getRequireds();
+        // Resolution
+        defaultResolutionType(Preferences::preferCentimeters);
+    });
 
-    emit splashMsgSig("30% - 3D Viewer window loading...");
+    m_startup.add("GUI", [this]() {
+        // set theme
+        setTheme();
 
-    gApplication = new lcApplication();
+        emit splashMsgSig(QString("20% - %1 GUI window loading...").arg(VER_PRODUCTNAME_STR));
 
-    emit splashMsgSig(QString("40% - 3D Viewer initialization..."));
+        // initialize gui
+        gui = new Gui();
 
-    if (gApplication->Initialize(LibraryPaths, gui)) {
-        gui->initialize();
-    } else {
-        emit gui->messageSig(LOG_ERROR, QString("Unable to initialize 3D Viewer."));
-        throw InitException{};
-    }
+        // Check if preferred renderer set and launch Preference dialogue if not to set Renderer
+        gui->getRequireds();
+    }, QStringList() << "Preferences");
+
+    m_startup.add("LDraw color parts", []() {
+        QString result;
+        if (Preferences::enableFadeSteps)
+            LDrawColourParts::LDrawColorPartsLoad(result);
+    }, QStringList() << "GUI", StartupWorker);
+
+    m_startup.add("Annotations", []() {
+        QString result;
+        Annotations::loadAnnotations(result);
+    }, QStringList() << "GUI", StartupWorker);
+
+    m_startup.add("3D Viewer", [this, &LibraryPaths]() {
+        emit splashMsgSig("30% - 3D Viewer window loading...");
+
+        gApplication = new lcApplication();
+
+        emit splashMsgSig(QString("40% - 3D Viewer initialization..."));
+
+        if (gApplication->Initialize(LibraryPaths, gui)) {
+            gui->initialize();
+        } else {
+            emit gui->messageSig(LOG_ERROR, QString("Unable to initialize 3D Viewer."));
+            throw InitException{};
+        }
+    }, QStringList() << "GUI");
+
+    m_startup.add("Update versions", [this]() {
+        availableVersions = new AvailableVersions(this);
+    }, QStringList() << "Preferences", StartupDeferred);
+
+    m_startup.run();
 }
 
 void Application::mainApp()
@@ -670,10 +725,13 @@ void Application::mainApp()
 
     emit splashMsgSig(QString("100% - %1 loaded.").arg(VER_PRODUCTNAME_STR));
 
-    availableVersions = new AvailableVersions(this);
-
+    // prompts to generate the list if the worker could not read it
+    m_startup.require("LDraw color parts");
     gui->ldrawColorPartsLoad();
 
+    // a list the worker could not read is reported when first used
+    m_startup.require("Annotations");
+
     if (modeGUI()) {
         splash->finish(gui);
 
@@ -681,6 +739,8 @@ void Application::mainApp()
 
         gui->show();
 
+        m_startup.require("Update versions");
+
         if (!m_commandline_file.isEmpty())
             emit gui->loadFileSig(m_commandline_file);
         else if (Preferences::loadLastOpenedFile){
@@ -691,6 +751,8 @@ void Application::mainApp()
         DoInitialUpdateCheck();
 #endif
     }
+
+    StartupTrace::report(m_startup_trace);
 }
 
 int Application::run()
@@ -724,6 +786,13 @@ int Application::run()
     emit gui->messageSig(LOG_ERROR, QString("Run: An unhandled exception has been thrown."));
   }
 
+  if (PerfTrace::enabled()) {
+    if (PerfTrace::write())
+      emit gui->messageSig(LOG_INFO, QString("Run: Performance trace written to %1.").arg(PerfTrace::fileName()));
+    else
+      emit gui->messageSig(LOG_ERROR, QString("Run: Unable to write performance trace %1.").arg(PerfTrace::fileName()));
+  }
+
   emit gui->messageSig(LOG_INFO, QString("Run: Application terminated with return code %1.").arg(ExecReturn));
 
   if (!m_print_output)
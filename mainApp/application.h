@@ -24,6 +24,7 @@
 #include "QsLog.h"
 #include "lc_global.h"
 #include "name.h"
+#include "startup.h"
 
 #ifdef Q_OS_WIN
   #include <Windows.h>
@@ -114,6 +115,15 @@ private:
     /// Print details flag
     bool m_print_output;
 
+    /// Print the startup trace to standard output
+    bool m_startup_trace;
+
+    /// Record the page generation performance trace
+    bool m_performance_trace;
+
+    /// Startup stages
+    StartupScheduler m_startup;
+
     /// Redirect input/output to console
     bool m_redirect_io_to_console;
 
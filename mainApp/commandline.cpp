@@ -14,8 +14,50 @@
 **
 ****************************************************************************/
 
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QTextStream>
+
 #include "application.h"
 #include "lpub.h"
+#include "perftrace.h"
+#include "render.h"
+
+#include "lc_application.h"
+#include "lc_library.h"
+
+/*
+ * Split a batch manifest line into arguments.  Arguments are separated
+ * by spaces and a double quoted argument may contain spaces.
+ */
+
+static QStringList manifestArguments(const QString &line)
+{
+  QStringList arguments;
+  QString argument;
+  bool quoted = false, started = false;
+
+  for (int i = 0; i < line.size(); i++) {
+      QChar c = line[i];
+      if (c == '"') {
+          quoted  = ! quoted;
+          started = true;
+      } else if (c.isSpace() && ! quoted) {
+          if (started)
+              arguments << argument;
+          argument.clear();
+          started = false;
+      } else {
+          argument += c;
+          started   = true;
+      }
+  }
+  if (started)
+      arguments << argument;
+
+  return arguments;
+}
 
 int Gui::processCommandLine()
 {
@@ -27,6 +69,266 @@ int Gui::processCommandLine()
   if (viewerJob > 0)
     return 0;
 
+  QStringList Arguments = Application::instance()->arguments();
+
+  // Batch manifest - all other arguments apply to every model
+  QString manifestFile, reportFile;
+  QStringList modelArguments;
+  for (int ArgIdx = 0; ArgIdx < Arguments.size(); ArgIdx++) {
+      const QString& Param = Arguments[ArgIdx];
+      if ((Param == QLatin1String("-bm") || Param == QLatin1String("--batch-manifest")) &&
+          ArgIdx < Arguments.size() - 1) {
+          manifestFile = Arguments[++ArgIdx];
+      } else
+      if ((Param == QLatin1String("-br") || Param == QLatin1String("--batch-report")) &&
+          ArgIdx < Arguments.size() - 1) {
+          reportFile = Arguments[++ArgIdx];
+      } else {
+          modelArguments << Param;
+      }
+  }
+
+  if (!manifestFile.isEmpty())
+      return processBatch(manifestFile, reportFile, modelArguments);
+
+  if (!reportFile.isEmpty())
+      emit messageSig(LOG_INFO,QString("Batch report '%1' ignored - no batch manifest specified.").arg(reportFile));
+
+  return processModel(modelArguments);
+}
+
+/*
+ * Process every model listed in a batch manifest in this one process, so
+ * the parts library, annotation tables and renderer settings loaded at
+ * startup are reused.  Each manifest line is a model file followed by
+ * any command line options for that model only, e.g.
+ *
+ *   "/models/my house.mpd" -pe -o png -d /out/house
+ *
+ * The model options follow the command line options, so they win, and
+ * the manifest model file replaces any given on the command line.
+ * Blank lines and lines starting with # are skipped.  The preferences a
+ * model's options may change are put back before the next model, and a
+ * JSON report with the status and time of each model is written to the
+ * report file, or to standard output if none is given.  With the
+ * performance trace on, each model also lists the count and time of
+ * every traced stage.
+ */
+
+int Gui::processBatch(const QString &manifestFile, const QString &reportFile, const QStringList &Arguments)
+{
+  QFile manifest(manifestFile);
+  if (!manifest.open(QIODevice::ReadOnly | QIODevice::Text)) {
+      emit messageSig(LOG_ERROR,QString("Cannot read batch manifest '%1': %2.")
+                                        .arg(manifestFile).arg(manifest.errorString()));
+      return 1;
+  }
+
+  QList<QStringList> models;
+  QTextStream in(&manifest);
+  while (!in.atEnd()) {
+      QString line = in.readLine().trimmed();
+      if (line.isEmpty() || line.startsWith("#"))
+          continue;
+      QStringList arguments = manifestArguments(line);
+      if (arguments.size())
+          models.append(arguments);
+  }
+  manifest.close();
+
+  emit messageSig(LOG_INFO,QString("Batch manifest '%1' lists %2 model files.")
+                                   .arg(QFileInfo(manifestFile).fileName()).arg(models.size()));
+
+  // Preferences the command line options may change
+  const QString preferredRenderer        = Preferences::preferredRenderer;
+  const QString povFileGenerator         = Preferences::povFileGenerator;
+  const bool    usingNativeRenderer      = Preferences::usingNativeRenderer;
+  const bool    enableLDViewSingleCall   = Preferences::enableLDViewSingleCall;
+  const bool    enableLDViewSnaphsotList = Preferences::enableLDViewSnaphsotList;
+  const bool    enableFadeSteps          = Preferences::enableFadeSteps;
+  const bool    fadeStepsUseColour       = Preferences::fadeStepsUseColour;
+  const int     fadeStepsOpacity         = Preferences::fadeStepsOpacity;
+  const QString validFadeStepsColour     = Preferences::validFadeStepsColour;
+  const bool    enableHighlightStep      = Preferences::enableHighlightStep;
+  const QString highlightStepColour      = Preferences::highlightStepColour;
+  const int     highlightStepLineWidth   = Preferences::highlightStepLineWidth;
+  const int     pageDisplayPause         = Preferences::pageDisplayPause;
+  const bool    nativeSoftwareRender     = gApplication->mPreferences.mNativeSoftwareRender;
+  const lcConditionalLines conditionalLines = gApplication->mPreferences.mConditionalLines;
+  const lcNativeLod nativeLod            = gApplication->mPreferences.mNativeLod;
+  const bool    checkLod                 = lcGetPiecesLibrary()->mCheckLod;
+
+  // Saved preferences processModel turns off
+  const bool    sceneGuides              = Preferences::sceneGuides;
+  const bool    sceneRuler               = Preferences::sceneRuler;
+  const bool    snapToGrid               = Preferences::snapToGrid;
+
+  QElapsedTimer batchTimer;
+  batchTimer.start();
+
+  QJsonArray report;
+  int failed = 0;
+
+  for (int i = 0; i < models.size(); i++) {
+      Preferences::enableLDViewSingleCall   = enableLDViewSingleCall;
+      Preferences::enableLDViewSnaphsotList = enableLDViewSnaphsotList;
+      Preferences::povFileGenerator         = povFileGenerator;
+      Preferences::enableFadeSteps          = enableFadeSteps;
+      Preferences::fadeStepsUseColour       = fadeStepsUseColour;
+      Preferences::fadeStepsOpacity         = fadeStepsOpacity;
+      Preferences::validFadeStepsColour     = validFadeStepsColour;
+      Preferences::enableHighlightStep      = enableHighlightStep;
+      Preferences::highlightStepColour      = highlightStepColour;
+      Preferences::highlightStepLineWidth   = highlightStepLineWidth;
+      Preferences::pageDisplayPause         = pageDisplayPause;
+      gApplication->mPreferences.mNativeSoftwareRender = nativeSoftwareRender;
+      gApplication->mPreferences.mConditionalLines     = conditionalLines;
+      gApplication->mPreferences.mNativeLod            = nativeLod;
+      lcGetPiecesLibrary()->mCheckLod                  = checkLod;
+      if (Preferences::preferredRenderer != preferredRenderer) {
+          Preferences::preferredRenderer   = preferredRenderer;
+          Preferences::usingNativeRenderer = usingNativeRenderer;
+          Render::setRenderer(Preferences::preferredRenderer);
+          Preferences::updatePOVRayConfigFiles();
+      }
+      saveFileName.clear();
+      saveDirectoryName.clear();
+      resetCache = false;
+      pageIndexCheck = false;
+      fadeStepLines.clear();
+      POVRayScheduler::maxJobs = 0;
+
+      QString modelFile = models[i].first();
+      emit messageSig(LOG_INFO,QString("Batch model %1 of %2: '%3'.")
+                                       .arg(i + 1).arg(models.size()).arg(modelFile));
+
+      QElapsedTimer modelTimer;
+      modelTimer.start();
+      qint64 traceStart = PerfTrace::enabled() ? PerfTrace::now() : 0;
+      lcLibraryFileCacheStats cacheStart = lcGetPiecesLibrary()->GetFileCacheStats();
+
+      int result = 1;
+      QString error;
+      try {
+          result = processModel(QStringList() << Arguments << models[i]);
+      } catch (const std::exception &ex) {
+          error = QString::fromLatin1(ex.what());
+      } catch (...) {
+          error = QString("Unhandled exception");
+      }
+
+      QJsonObject entry;
+      entry["file"]      = modelFile;
+      entry["status"]    = result == 0 ? QString("ok") : QString("failed");
+      entry["exitCode"]  = result;
+      entry["elapsedMs"] = double(modelTimer.elapsed());
+      entry["pages"]     = result == 0 ? maxPages : 0;
+      entry["parts"]     = result == 0 ? ldrawFile.getPartCount() : 0;
+      if (!error.isEmpty())
+          entry["error"] = error;
+
+      // library subfiles served from the decompressed file cache
+      lcLibraryFileCacheStats cacheEnd = lcGetPiecesLibrary()->GetFileCacheStats();
+      quint64 cacheHits   = cacheEnd.Hits - cacheStart.Hits;
+      quint64 cacheMisses = cacheEnd.Misses - cacheStart.Misses;
+      QJsonObject cache;
+      cache["hits"]       = double(cacheHits);
+      cache["misses"]     = double(cacheMisses);
+      cache["hitRate"]    = cacheHits + cacheMisses ? double(cacheHits) / (cacheHits + cacheMisses) : 0.0;
+      cache["inflatedBytesSaved"] = double(cacheEnd.InflatedBytesSaved - cacheStart.InflatedBytesSaved);
+      cache["bytes"]      = double(cacheEnd.Bytes);
+      cache["entries"]    = cacheEnd.Entries;
+      entry["libraryCache"] = cache;
+
+      // faded previous step lines configureModelStep kept for this model
+      int fadeLines = 0;
+      double fadeBytes = 0.0;
+      for (const FadeStepLines &faded : fadeStepLines) {
+          fadeLines += faded.lines.size();
+          for (const FadeStepLine &line : faded.lines)
+              fadeBytes += sizeof(FadeStepLine) + (line.line.size() + line.colourCode.size()) * sizeof(QChar);
+      }
+      QJsonObject fade;
+      fade["models"] = fadeStepLines.size();
+      fade["lines"]  = fadeLines;
+      fade["bytes"]  = fadeBytes;
+      entry["fadeStepLines"] = fade;
+
+      // 3DViewer step contents kept for the pages drawn
+      ViewerStepMemory viewerMemory = ldrawFile.viewerStepMemory();
+      QJsonObject viewer;
+      viewer["steps"]     = viewerMemory._steps;
+      viewer["lines"]     = viewerMemory._lines;
+      viewer["bytes"]     = double(viewerMemory._bytes);
+      viewer["fullBytes"] = double(viewerMemory._fullBytes);
+      entry["viewerSteps"] = viewer;
+
+      // time spent in each traced stage of this model
+      if (PerfTrace::enabled()) {
+          QJsonObject stages;
+          QMap<QString, PerfStage> traced = PerfTrace::stages(traceStart);
+          for (auto it = traced.constBegin(); it != traced.constEnd(); ++it) {
+              QJsonObject stage;
+              stage["count"] = it.value().count;
+              stage["ms"]    = it.value().total / 1000.0;
+              stage["maxMs"] = it.value().longest / 1000.0;
+              stages[it.key()] = stage;
+          }
+          entry["stages"] = stages;
+      }
+      report.append(entry);
+
+      if (result != 0)
+          failed++;
+  }
+
+  if (Preferences::sceneGuides != sceneGuides)
+      Preferences::setSceneGuidesPreference(sceneGuides);
+
+  if (Preferences::sceneRuler != sceneRuler)
+      Preferences::setSceneRulerPreference(sceneRuler);
+
+  if (Preferences::snapToGrid != snapToGrid)
+      Preferences::setSnapToGridPreference(snapToGrid);
+
+  QJsonObject document;
+  document["manifest"]  = QFileInfo(manifestFile).absoluteFilePath();
+  document["models"]    = report;
+  document["succeeded"] = models.size() - failed;
+  document["failed"]    = failed;
+  document["elapsedMs"] = double(batchTimer.elapsed());
+  if (PerfTrace::enabled())
+      document["trace"] = PerfTrace::fileName();
+
+  QByteArray json = QJsonDocument(document).toJson(QJsonDocument::Indented);
+  bool reportWritten = true;
+
+  if (reportFile.isEmpty()) {
+      fprintf(stdout, "%s", json.constData());
+      fflush(stdout);
+  } else {
+      QFile file(reportFile);
+      if (file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+          file.write(json);
+          file.close();
+      } else {
+          emit messageSig(LOG_ERROR,QString("Cannot write batch report '%1': %2.")
+                                            .arg(reportFile).arg(file.errorString()));
+          reportWritten = false;
+      }
+  }
+
+  emit messageSig(LOG_INFO,QString("Batch manifest '%1' processed - %2 succeeded, %3 failed%4. %5.")
+                                   .arg(QFileInfo(manifestFile).fileName())
+                                   .arg(models.size() - failed).arg(failed)
+                                   .arg(reportWritten ? QString() : QString(", report not written"))
+                                   .arg(gui->elapsedTime(batchTimer.elapsed())));
+
+  return failed || !reportWritten ? 1 : 0;
+}
+
+int Gui::processModel(const QStringList &Arguments)
+{
   // Declarations
    int fadeStepsOpacity    = FADE_OPACITY_DEFAULT;
    int highlightLineWidth  = HIGHLIGHT_LINE_WIDTH_DEFAULT;
@@ -46,8 +348,6 @@ int Gui::processCommandLine()
           fadeStepsColour, highlightStepColour, message;
 
   // Process parameters
-  QStringList Arguments = Application::instance()->arguments();
-
   const int NumArguments = Arguments.size();
   for (int ArgIdx = 1; ArgIdx < NumArguments; ArgIdx++)
     {
@@ -64,6 +364,8 @@ int Gui::processCommandLine()
 
       if (  /* These are treated in Application::initialize() so ignore here */
             (Param == QLatin1String("-ns") || Param == QLatin1String("--no-stdout-log")) ||
+            (Param == QLatin1String("-st") || Param == QLatin1String("--startup-trace")) ||
+            (Param == QLatin1String("-pt") || Param == QLatin1String("--performance-trace")) ||
             (Param == QLatin1String("-ll") || Param == QLatin1String("--liblego"))  ||
             (Param == QLatin1String("-lt") || Param == QLatin1String("--libtente")) ||
             (Param == QLatin1String("-lv") || Param == QLatin1String("--libvexiq"))
@@ -120,6 +422,21 @@ int Gui::processCommandLine()
       if (Param == QLatin1String("-pf") || Param == QLatin1String("--process-file"))
         processFile = true;
       else
+      if (Param == QLatin1String("-cl") || Param == QLatin1String("--conditional-lines"))
+      {
+        QString conditionalLines;
+        ParseString(conditionalLines, true);
+
+        if (conditionalLines == QLatin1String("off"))
+          gApplication->mPreferences.mConditionalLines = lcConditionalLines::OFF;
+        else if (conditionalLines == QLatin1String("line"))
+          gApplication->mPreferences.mConditionalLines = lcConditionalLines::PER_LINE;
+        else if (conditionalLines == QLatin1String("batch"))
+          gApplication->mPreferences.mConditionalLines = lcConditionalLines::BATCHED;
+        else
+          emit messageSig(LOG_INFO,QString("Invalid conditional lines option specified: '%1'.").arg(conditionalLines));
+      }
+      else
       if (Param == QLatin1String("-pe") || Param == QLatin1String("--process-export"))
         processExport = true;
       else
@@ -138,12 +455,36 @@ int Gui::processCommandLine()
       if (Param == QLatin1String("-hc") || Param == QLatin1String("--highlight-step-color"))
         ParseString(highlightStepColour, false);
       else
+      if (Param == QLatin1String("-ic") || Param == QLatin1String("--index-check"))
+        pageIndexCheck = true;
+      else
 //      if (Param == QLatin1String("-im") || Param == QLatin1String("--image-matte"))
 //        imageMatting = true;
 //      else
+      if (Param == QLatin1String("-lc") || Param == QLatin1String("--lod-check"))
+        lcGetPiecesLibrary()->mCheckLod = true;
+      else
+      if (Param == QLatin1String("-nl") || Param == QLatin1String("--native-lod"))
+      {
+        QString nativeLod;
+        ParseString(nativeLod, true);
+
+        if (nativeLod == QLatin1String("distance"))
+          gApplication->mPreferences.mNativeLod = lcNativeLod::DISTANCE;
+        else if (nativeLod == QLatin1String("size"))
+          gApplication->mPreferences.mNativeLod = lcNativeLod::IMAGE_SIZE;
+        else if (nativeLod == QLatin1String("high"))
+          gApplication->mPreferences.mNativeLod = lcNativeLod::HIGH;
+        else
+          emit messageSig(LOG_INFO,QString("Invalid native LOD option specified: '%1'.").arg(nativeLod));
+      }
+      else
       if (Param == QLatin1String("-of") || Param == QLatin1String("--pdf-output-file"))
         ParseString(saveFileName, false);
       else
+      if (Param == QLatin1String("-sr") || Param == QLatin1String("--software-render"))
+        gApplication->mPreferences.mNativeSoftwareRender = true;
+      else
       if (Param == QLatin1String("-rs") || Param == QLatin1String("--reset-search-dirs"))
           resetSearchDirs = true;
       else
@@ -162,6 +503,9 @@ int Gui::processCommandLine()
       if (Param == QLatin1String("-r") || Param == QLatin1String("--range"))
         ParseString(pageRange, false);
       else
+      if (Param == QLatin1String("-rj") || Param == QLatin1String("--render-jobs"))
+        ParseInteger(POVRayScheduler::maxJobs);
+      else
       if (Param == QLatin1String("--line-width"))
         ParseInteger(highlightLineWidth);
       else
@@ -51,6 +51,7 @@
 #include "pagepointer.h"
 #include "lgraphicsscene.h"
 #include "name.h"
+#include "perftrace.h"
 
 /*
  * We need to draw page every time there is change to the LDraw file.
@@ -213,6 +214,7 @@ int Gui::addGraphicsPageItems(
     LGraphicsScene *scene,
     bool            printing)
 {
+  PerfSpan perfSpan("page", "formatPage", QString(), displayPageNum);
 
   Page                    *page     = dynamic_cast<Page *>(steps);
 
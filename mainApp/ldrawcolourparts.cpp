@@ -19,10 +19,12 @@
 #include "QsLog.h"
 
 QHash<QString, QString>  LDrawColourParts::ldrawColourParts;
+QAtomicInt               LDrawColourParts::ldrawColourPartsVersion;
 
 bool LDrawColourParts::LDrawColorPartsLoad(QString &result)
 {
     ldrawColourParts.clear();
+    ldrawColourPartsVersion.ref();
     QString colorPartsFile = Preferences::ldrawColourPartsFile;
     QFile file(colorPartsFile);
     if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
@@ -54,6 +56,7 @@ bool LDrawColourParts::LDrawColorPartsLoad(QString &result)
             //qDebug() << "** Color part loaded: " << partFile << " Lib: " << QString("%1:::%2").arg(partLibType).arg(partFile);
         }
     }
+    ldrawColourPartsVersion.ref();
     return true;
 }
 
@@ -17,14 +17,21 @@
 
 #include <QHash>
 #include <QString>
+#include <QAtomicInt>
 
 class LDrawColourParts
 {
   private:
     static QHash<QString, QString>   ldrawColourParts;
+    static QAtomicInt                ldrawColourPartsVersion;
   public:
     LDrawColourParts(){}
     static bool ldrawColorPartsIsLoaded();
+    /* bumped when the list is cleared and again when it is loaded */
+    static int ldrawColorPartsVersion()
+    {
+        return ldrawColourPartsVersion.load();
+    }
     static bool LDrawColorPartsLoad(QString &result);
     static bool isLDrawColourPart(QString part);
     static QString getLDrawColourPartInfo(QString part);
@@ -40,6 +40,7 @@
 #include <QRegExp>
 #include <QHash>
 #include <functional>
+#include <QtConcurrent>
 
 #include "paths.h"
 
@@ -49,6 +50,7 @@
 #include "lc_library.h"
 #include "project.h"
 #include "pieceinf.h"
+#include "perftrace.h"
 
 QStringList LDrawFile::_loadedParts;
 QString LDrawFile::_file           = "";
@@ -80,6 +82,9 @@ LDrawSubFile::LDrawSubFile(
   _renderedStepNumber = 0;
   _mirrorRendered = false;
   _changedSinceLastWrite = true;
+  _changedSinceLastIndex = true;
+  _refSteps = 0;
+  _refsVersion = -1;
   _unofficialPart = unofficialPart;
   _generated = generated;
   _prevStepPosition = 0;
@@ -87,14 +92,14 @@ LDrawSubFile::LDrawSubFile(
 }
 
 /* initialize viewer step*/
-ViewerStep::ViewerStep(const QStringList &rotatedContents,
-                       const QStringList &unrotatedContents,
+ViewerStep::ViewerStep(int                rotatedContents,
+                       int                unrotatedContents,
                        const QString     &filePath,
                        const QString     &csiKey,
                        bool               multiStep,
                        bool               calledOut){
-    _rotatedContents << rotatedContents;
-    _unrotatedContents << unrotatedContents;
+    _rotatedContents   = rotatedContents;
+    _unrotatedContents = unrotatedContents;
     _filePath  = filePath;
     _csiKey    = csiKey;
     _modified  = false;
@@ -106,10 +111,11 @@ void LDrawFile::empty()
 {
   _subFiles.clear();
   _subFileOrder.clear();
-  _viewerSteps.clear();
+  clearViewerSteps();
   _loadedParts.clear();
   _mpd = false;
   _partCount = 0;
+  _subFilesVersion++;
 }
 
 /* Add a new subFile */
@@ -130,6 +136,7 @@ void LDrawFile::insert(const QString &mcFileName,
   LDrawSubFile subFile(contents,datetime,unofficialPart,generated,subFilePath);
   _subFiles.insert(fileName,subFile);
   _subFileOrder << fileName;
+  _subFilesVersion++;
 }
 
 /* return the number of lines in the file */
@@ -212,12 +219,7 @@ QDateTime LDrawFile::lastModified(const QString &mcFileName)
 
 bool LDrawFile::contains(const QString &file)
 {
-  for (int i = 0; i < _subFileOrder.size(); i++) {
-    if (_subFileOrder[i].toLower() == file.toLower()) {
-      return true;
-    }
-  }
-  return false;
+  return _subFiles.contains(file.toLower());
 }
 
 bool LDrawFile::isSubmodel(const QString &file)
@@ -275,6 +277,8 @@ void LDrawFile::setContents(const QString     &mcFileName,
     //i.value()._datetime = QDateTime::currentDateTime();
     i.value()._contents = contents;
     i.value()._changedSinceLastWrite = true;
+    i.value()._changedSinceLastIndex = true;
+    i.value()._refsVersion = -1;
   }
 }
 
@@ -396,6 +400,8 @@ void LDrawFile::insertLine(const QString &mcFileName, int lineNumber, const QStr
     i.value()._modified = true;
  //   i.value()._datetime = QDateTime::currentDateTime();
     i.value()._changedSinceLastWrite = true;
+    i.value()._changedSinceLastIndex = true;
+    i.value()._refsVersion = -1;
   }
 }
   
@@ -409,6 +415,8 @@ void LDrawFile::replaceLine(const QString &mcFileName, int lineNumber, const QSt
     i.value()._modified = true;
 //    i.value()._datetime = QDateTime::currentDateTime();
     i.value()._changedSinceLastWrite = true;
+    i.value()._changedSinceLastIndex = true;
+    i.value()._refsVersion = -1;
   }
 }
 
@@ -422,6 +430,8 @@ void LDrawFile::deleteLine(const QString &mcFileName, int lineNumber)
     i.value()._modified = true;
 //    i.value()._datetime = QDateTime::currentDateTime();
     i.value()._changedSinceLastWrite = true;
+    i.value()._changedSinceLastIndex = true;
+    i.value()._refsVersion = -1;
   }
 }
 
@@ -500,6 +510,8 @@ int LDrawFile::instances(const QString &mcFileName, bool mirrored)
 
 int LDrawFile::loadFile(const QString &fileName)
 {
+    PerfSpan perfSpan("load", "LDrawFile::loadFile", fileName);
+
     QFile file(fileName);
     if (!file.open(QFile::ReadOnly | QFile::Text)) {
         emit gui->messageSig(LOG_ERROR, QString("Cannot read file %1:\n%2.")
@@ -659,10 +671,123 @@ void LDrawFile::showLoadMessages()
         LdrawFilesLoad::showLoadMessages(_loadedParts);
 }
 
+/*
+ * Hand written matchers for the metas the loaders check on every line.
+ * Each matches the same lines as the case insensitive QRegExp it replaced,
+ * e.g. "^0\\s+FILE\\s+(.*)$", and hands back the captured text.  Lines
+ * are trimmed when they get here.
+ */
+
+static bool matchLoadMeta(const QString &line,
+                          const QString &keyword,
+                          bool           bang,     // allow !keyword
+                          bool           colon,    // allow keyword:
+                          QString       *capture)  // nullptr if nothing may follow
+{
+    if (line.size() < 2 || line.at(0) != QLatin1Char('0') || ! line.at(1).isSpace()) {
+        return false;
+    }
+    int p = 2;
+    while (p < line.size() && line.at(p).isSpace()) {
+        ++p;
+    }
+    if (bang && p < line.size() && line.at(p) == QLatin1Char('!')) {
+        ++p;
+    }
+    if (line.midRef(p,keyword.size()).compare(keyword,Qt::CaseInsensitive) != 0) {
+        return false;
+    }
+    p += keyword.size();
+    if (colon && p < line.size() && line.at(p) == QLatin1Char(':')) {
+        ++p;
+    }
+    int q = p;
+    while (q < line.size() && line.at(q).isSpace()) {
+        ++q;
+    }
+    if (! capture) {
+        return q == line.size();
+    }
+    if (q == p) {
+        return false;
+    }
+    *capture = line.mid(q);
+    return true;
+}
+
+static bool isFileMeta(const QString &line)
+{
+    QString fileName;
+    return matchLoadMeta(line,"FILE",false,false,&fileName) ||
+           matchLoadMeta(line,"NOFILE",false,false,nullptr);
+}
+
+/* lines up to the next FILE or NOFILE meta, used to size submodel contents */
+
+static int submodelSize(const QStringList &lines, int sofLine)
+{
+    int i = sofLine + 1;
+    while (i < lines.size() && ! isFileMeta(lines.at(i))) {
+        ++i;
+    }
+    return i - sofLine - 1;
+}
+
+/*
+ * Read a whole LDraw file into trimmed lines.  The file is memory mapped
+ * when it can be, decoded in one go and split on line ends in one pass,
+ * rather than pulled through QTextStream a line at a time.  As with
+ * QTextStream, a UTF-8, UTF-16 or UTF-32 byte order mark overrides the
+ * codec, and lines may end with LF, CR LF or a lone CR.
+ */
+
+static QString decodeLDrawText(const QByteArray &bytes, QTextCodec *codec)
+{
+    return QTextCodec::codecForUtfText(bytes,codec)->toUnicode(bytes);
+}
+
+static QStringList readLDrawLines(QFile &file, QTextCodec *codec)
+{
+    QString text;
+    qint64 fileSize = file.size();
+    uchar *data = fileSize > 0 ? file.map(0,fileSize) : nullptr;
+    if (data) {
+        text = decodeLDrawText(QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(fileSize)),codec);
+        file.unmap(data);
+    } else {
+        text = decodeLDrawText(file.readAll(),codec);
+    }
+
+    if (text.size() && text.at(0) == QChar(0xFEFF)) {
+        text.remove(0,1);
+    }
+
+    QStringList lines;
+    lines.reserve(text.count(QLatin1Char('\n')) + text.count(QLatin1Char('\r')) / 2 + 1);
+
+    int size  = text.size();
+    int start = 0;
+    for (int i = 0; i < size; i++) {
+        QChar c = text.at(i);
+        if (c == QLatin1Char('\n') || c == QLatin1Char('\r')) {
+            lines << text.mid(start,i - start).trimmed();
+            if (c == QLatin1Char('\r') && i + 1 < size && text.at(i + 1) == QLatin1Char('\n')) {
+                ++i;
+            }
+            start = i + 1;
+        }
+    }
+    if (start < size) {
+        lines << text.mid(start).trimmed();
+    }
+
+    return lines;
+}
+
 void LDrawFile::loadMPDFile(const QString &fileName, QDateTime &datetime)
 {    
     QFile file(fileName);
-    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+    if (!file.open(QFile::ReadOnly)) {
         emit gui->messageSig(LOG_ERROR, QString("Cannot read file %1:\n%2.")
                              .arg(fileName)
                              .arg(file.errorString()));
@@ -670,19 +795,15 @@ void LDrawFile::loadMPDFile(const QString &fileName, QDateTime &datetime)
     }
 
     QFileInfo   fileInfo(fileName);
-    QTextStream in(&file);
-    in.setCodec(_currFileIsUTF8 ? QTextCodec::codecForName("UTF-8") : QTextCodec::codecForName("System"));
+    QTextCodec *codec = _currFileIsUTF8 ? QTextCodec::codecForName("UTF-8") : QTextCodec::codecForName("System");
 
-    QStringList stageContents;
     QStringList stageSubfiles;
+    QSet<QString> stageChecked;    // type 1 line references already checked
 
     /* Read it in the first time to put into fileList in order of
      appearance */
 
-    while ( ! in.atEnd()) {
-        QString sLine = in.readLine(0);
-        stageContents << sLine.trimmed();
-    }
+    QStringList stageContents = readLDrawLines(file,codec);
     file.close();
 
     topLevelFileNotCaptured        = true;
@@ -721,18 +842,15 @@ void LDrawFile::loadMPDFile(const QString &fileName, QDateTime &datetime)
             &loadMPDContents,
             &stageContents,
             &stageSubfiles,
+            &stageChecked,
+            &codec,
             &fileInfo,
             &searchPaths,
             &datetime] (int i) {
         bool alreadyLoaded;
         QStringList contents;
         QString     subfileName;
-        QRegExp sofRE("^0\\s+FILE\\s+(.*)$",Qt::CaseInsensitive);
-        QRegExp eofRE("^0\\s+NOFILE\\s*$",Qt::CaseInsensitive);
-
-        QRegExp upAUT("^0\\s+Author:?\\s+(.*)$",Qt::CaseInsensitive);
-        QRegExp upNAM("^0\\s+Name:?\\s+(.*)$",Qt::CaseInsensitive);
-        QRegExp upCAT("^0\\s+!?CATEGORY\\s+(.*)$",Qt::CaseInsensitive);
+        QString     metaValue;
 
         emit gui->progressBarPermInitSig();
         emit gui->progressPermRangeSig(1, stageContents.size());
@@ -749,47 +867,52 @@ void LDrawFile::loadMPDFile(const QString &fileName, QDateTime &datetime)
 
             emit gui->progressPermSetValueSig(i);
 
-            bool sof = smLine.contains(sofRE);  //start of file
-            bool eof = smLine.contains(eofRE);  //end of file
-
-            QStringList tokens;
-            split(smLine,tokens);
-
-            // submodel file check;
-            if (tokens.size() == 15 && tokens[0] == "1") {
-                const QString stageSubfileName = tokens[tokens.size()-1].toLower();
-                PieceInfo* standardPart = lcGetPiecesLibrary()->FindPiece(stageSubfileName.toLatin1().constData(), nullptr, false, false);
-                if (! standardPart && ! LDrawFile::contains(stageSubfileName.toLower()) && ! stageSubfiles.contains(stageSubfileName)) {
-                    stageSubfiles.append(stageSubfileName);
+            QString sofName;
+            bool sof = matchLoadMeta(smLine,"FILE",false,false,&sofName);           //start of file
+            bool eof = ! sof && matchLoadMeta(smLine,"NOFILE",false,false,nullptr); //end of file
+
+            // submodel file check - once per referenced name
+            if (smLine.startsWith(QLatin1Char('1'))) {
+                QStringList tokens;
+                split(smLine,tokens);
+                if (tokens.size() == 15 && tokens[0] == "1") {
+                    const QString stageSubfileName = tokens[tokens.size()-1].toLower();
+                    if (! stageChecked.contains(stageSubfileName)) {
+                        stageChecked.insert(stageSubfileName);
+                        PieceInfo* standardPart = lcGetPiecesLibrary()->FindPiece(stageSubfileName.toLatin1().constData(), nullptr, false, false);
+                        if (! standardPart && ! LDrawFile::contains(stageSubfileName) && ! stageSubfiles.contains(stageSubfileName)) {
+                            stageSubfiles.append(stageSubfileName);
+                        }
+                    }
                 }
             }
 
             if (topLevelFileNotCaptured) {
                 if (sof){
-                    _file = sofRE.cap(1).replace(QFileInfo(sofRE.cap(1)).suffix(),"");
+                    _file = QString(sofName).replace(QFileInfo(sofName).suffix(),"");
                     descriptionLine = i+1;      //next line should be description
                     topLevelFileNotCaptured = false;
                 }
             }
 
             if (topLevelAuthorNotCaptured) {
-                if (smLine.contains(upAUT)) {
-                    _author = upAUT.cap(1).replace(": ","");
+                if (matchLoadMeta(smLine,"Author",false,true,&metaValue)) {
+                    _author = metaValue.replace(": ","");
                     Preferences::defaultAuthor = _author;
                     topLevelAuthorNotCaptured = false;
                 }
             }
 
             if (topLevelNameNotCaptured) {
-                if (smLine.contains(upNAM)) {
-                    _name = upNAM.cap(1).replace(": ","");
+                if (matchLoadMeta(smLine,"Name",false,true,&metaValue)) {
+                    _name = metaValue.replace(": ","");
                     topLevelNameNotCaptured = false;
                 }
             }
 
             if (topLevelCategoryNotCaptured && subfileName == topLevelFile()) {
-                if (smLine.contains(upCAT)) {
-                        _category = upCAT.cap(1);
+                if (matchLoadMeta(smLine,"CATEGORY",true,false,&metaValue)) {
+                        _category = metaValue;
                     topLevelCategoryNotCaptured = false;
                 }
             }
@@ -832,7 +955,8 @@ void LDrawFile::loadMPDFile(const QString &fileName, QDateTime &datetime)
                  * - else if at end of file marker, clear subfileName
                  */
                 if (sof) {
-                    subfileName = sofRE.cap(1).toLower();
+                    subfileName = sofName.toLower();
+                    contents.reserve(submodelSize(stageContents,i));
                     if (! alreadyLoaded)
                         emit gui->messageSig(LOG_INFO, "Loading MPD " + modelType() + " '" + subfileName + "'...");
                 } else {
@@ -910,19 +1034,15 @@ void LDrawFile::loadMPDFile(const QString &fileName, QDateTime &datetime)
                     setSubFilePath(subfile,fileInfo.absoluteFilePath());
                     stageSubfiles.removeAt(stageSubfiles.indexOf(subfile));
                     file.setFileName(fileInfo.absoluteFilePath());
-                    if (!file.open(QFile::ReadOnly | QFile::Text)) {
+                    if (!file.open(QFile::ReadOnly)) {
                         emit gui->messageSig(LOG_NOTICE, QString("Cannot read file %1:\n%2.")
                                              .arg(fileInfo.absoluteFilePath())
                                              .arg(file.errorString()));
                         return;
                     }
 
-                    QTextStream in(&file);
-                    in.setCodec(_currFileIsUTF8 ? QTextCodec::codecForName("UTF-8") : QTextCodec::codecForName("System"));
-                    while ( ! in.atEnd()) {
-                        QString sLine = in.readLine(0);
-                        stageContents << sLine.trimmed();
-                    }
+                    stageContents << readLDrawLines(file,codec);
+                    file.close();
                 }
             }
             if (subFileFound) {
@@ -942,52 +1062,243 @@ void LDrawFile::loadMPDFile(const QString &fileName, QDateTime &datetime)
     emit gui->progressPermStatusRemoveSig();
 }
 
+/*
+ * An external LDR subfile as it comes back from a worker thread.  The
+ * worker locates the file, reads it and picks out its type 1 references;
+ * everything that needs the gui, the parts library or isHeader stays on
+ * the main thread.
+ */
+
+class LDrawLoadJob {
+  public:
+    QString     _parentPath;    // directory of the referencing file
+    QString     _fileName;      // referenced file name
+    QString     _filePath;      // located file, empty if not found
+    QString     _error;         // open error
+    QStringList _contents;
+    QStringList _refNames;      // first reference to each name, in file order
+    QList<int>  _refLines;      // line of each first reference
+    bool        _mpd;           // has a FILE meta, loaded by loadMPDFile
+
+    LDrawLoadJob()
+    {
+      _mpd = false;
+    }
+};
+
+/*
+ * Load an LDR file and the external subfiles it references.  The subfiles
+ * are found a level at a time, breadth first, with each level located and
+ * read concurrently.  Once the whole graph is read it is inserted depth
+ * first from the top, which gives the same submodel order, messages and
+ * header capture as loading one file after another.
+ */
+
 void LDrawFile::loadLDRFile(const QString &path, const QString &fileName)
 {
-    if (_subFiles[fileName]._contents.isEmpty()) {
+    QMap<QString, LDrawSubFile>::const_iterator it = _subFiles.constFind(fileName.toLower());
+    if (it != _subFiles.constEnd() && ! it.value()._contents.isEmpty()) {
+        return;
+    }
 
-        QString fullName(path + QDir::separator() + fileName);
+    QTextCodec *codec = _currFileIsUTF8 ? QTextCodec::codecForName("UTF-8") : QTextCodec::codecForName("System");
+    bool extendedSearch = Preferences::extendedSubfileSearch;
 
-        QFile file(fullName);
-        if ( ! file.open(QFile::ReadOnly | QFile::Text)) {
-            emit gui->messageSig(LOG_ERROR,QString("Cannot read file %1:\n%2.")
-                                 .arg(fullName)
-                                 .arg(file.errorString()));
+    QStringList searchPaths = Preferences::ldSearchDirs;
+    QString ldrawPath = QDir::toNativeSeparators(Preferences::ldrawLibPath);
+    if (!searchPaths.contains(ldrawPath + QDir::separator() + "MODELS",Qt::CaseInsensitive))
+        searchPaths.append(ldrawPath + QDir::separator() + "MODELS");
+    if (!searchPaths.contains(ldrawPath + QDir::separator() + "PARTS",Qt::CaseInsensitive))
+        searchPaths.append(ldrawPath + QDir::separator() + "PARTS");
+    if (!searchPaths.contains(ldrawPath + QDir::separator() + "P",Qt::CaseInsensitive))
+        searchPaths.append(ldrawPath + QDir::separator() + "P");
+    if (!searchPaths.contains(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "PARTS",Qt::CaseInsensitive))
+        searchPaths.append(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "PARTS");
+    if (!searchPaths.contains(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "P",Qt::CaseInsensitive))
+        searchPaths.append(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "P");
+
+    /* Runs on worker threads - only touches the job and the copies captured here */
+
+    std::function<LDrawLoadJob(const LDrawLoadJob &)> readSubFile;
+    readSubFile = [
+            codec,
+            searchPaths,
+            extendedSearch] (const LDrawLoadJob &request)
+    {
+        LDrawLoadJob job = request;
+
+        if (job._filePath.isEmpty()) {
+            QString subFilePath;
+            // current path
+            if (QFileInfo(job._parentPath + QDir::separator() + job._fileName).isFile()) {
+                subFilePath = job._parentPath + QDir::separator() + job._fileName;
+            } else
+            // file path
+            if (QFileInfo(job._fileName).isFile()) {
+                subFilePath = job._fileName;
+            }
+            else
+            // extended search - LDraw subfolder paths and extra search directorie paths
+            if (extendedSearch) {
+                for (QString searchPath : searchPaths) {
+                    if (QFileInfo(searchPath + QDir::separator() + job._fileName).isFile()) {
+                        subFilePath = searchPath + QDir::separator() + job._fileName;
+                        break;
+                    }
+                }
+            }
+            if (subFilePath.isEmpty()) {
+                return job;
+            }
+            job._filePath = QFileInfo(subFilePath).absoluteFilePath();
+        }
+
+        QFile file(job._filePath);
+        if ( ! file.open(QFile::ReadOnly)) {
+            job._error = file.errorString();
+            return job;
+        }
+        job._contents = readLDrawLines(file,codec);
+        file.close();
+
+        QSet<QString> checkedSubfiles;   // type 1 line references already listed
+        QString mpdName;
+        for (int i = 0; i < job._contents.size(); i++) {
+            const QString &line = job._contents.at(i);
+            if (matchLoadMeta(line,"FILE",false,false,&mpdName)) {
+                job._mpd = true;
+                break;
+            }
+            QStringList tokens;
+            if (line.startsWith(QLatin1Char('1'))) {
+                split(line,tokens);
+            }
+            if (tokens.size() == 15 && tokens[0] == "1" && ! checkedSubfiles.contains(tokens[14].toLower())) {
+                checkedSubfiles.insert(tokens[14].toLower());
+                job._refNames << QFileInfo(tokens[14]).fileName();
+                job._refLines << i;
+            }
+        }
+        return job;
+    };
+
+    QHash<QString, LDrawLoadJob> loaded;     // read files by file path
+    QHash<QString, QString>      located;    // parent path and name to file path
+    QHash<QString, bool>         standard;   // name is a library part
+
+    auto locateKey = [] (const QString &parentPath, const QString &name) -> QString
+    {
+        return parentPath + QLatin1Char('|') + name.toLower();
+    };
+
+    auto isStandardPart = [&standard] (const QString &name)
+    {
+        QString key = name.toLower();
+        QHash<QString, bool>::const_iterator it = standard.constFind(key);
+        if (it != standard.constEnd()) {
+            return it.value();
+        }
+        bool standardPart = lcGetPiecesLibrary()->FindPiece(name.toLatin1().constData(), nullptr, false, false) != nullptr;
+        standard.insert(key,standardPart);
+        return standardPart;
+    };
+
+    /* discover and read the reference graph a level at a time */
+
+    QString topFilePath = QFileInfo(path + QDir::separator() + fileName).absoluteFilePath();
+
+    QList<LDrawLoadJob> level;
+    LDrawLoadJob top;
+    top._fileName = fileName;
+    top._filePath = topFilePath;
+    level << top;
+
+    QSet<QString> requested;
+
+    while (level.size()) {
+        if (level.size() > 1) {
+            level = QtConcurrent::blockingMapped<QList<LDrawLoadJob> >(level, readSubFile);
+        } else {
+            level[0] = readSubFile(level[0]);
+        }
+
+        QList<LDrawLoadJob> nextLevel;
+
+        for (int i = 0; i < level.size(); i++) {
+            const LDrawLoadJob &job = level[i];
+            if ( ! job._parentPath.isEmpty()) {
+                located.insert(locateKey(job._parentPath,job._fileName),job._filePath);
+            }
+            if (job._filePath.isEmpty() || loaded.contains(job._filePath)) {
+                continue;
+            }
+            loaded.insert(job._filePath,job);
+            if (job._mpd || ! job._error.isEmpty()) {
+                continue;
+            }
+            QString parentPath = QFileInfo(job._filePath).absolutePath();
+            for (int r = 0; r < job._refNames.size(); r++) {
+                const QString &name = job._refNames[r];
+                QString key = locateKey(parentPath,name);
+                if (requested.contains(key) || isStandardPart(name) || LDrawFile::contains(name)) {
+                    continue;
+                }
+                requested.insert(key);
+                LDrawLoadJob request;
+                request._parentPath = parentPath;
+                request._fileName   = name;
+                nextLevel << request;
+            }
+        }
+
+        level = nextLevel;
+    }
+
+    /* insert the files depth first, in the order they were referenced */
+
+    std::function<void(const QString &)> insertLDRFile;
+    insertLDRFile = [
+            this,
+            &insertLDRFile,
+            &loaded,
+            &located,
+            &locateKey,
+            &isStandardPart] (const QString &filePath)
+    {
+        QMap<QString, LDrawSubFile>::const_iterator it = _subFiles.constFind(QFileInfo(filePath).fileName().toLower());
+        if (it != _subFiles.constEnd() && ! it.value()._contents.isEmpty()) {
             return;
         }
 
-        QFileInfo   fileInfo(fullName);
-        QTextStream in(&file);
-        in.setCodec(_currFileIsUTF8 ? QTextCodec::codecForName("UTF-8") : QTextCodec::codecForName("System"));
+        LDrawLoadJob job = loaded.value(filePath);
 
-        QStringList contents;
-        QStringList subfiles;
+        if ( ! job._error.isEmpty()) {
+            emit gui->messageSig(LOG_ERROR,QString("Cannot read file %1:\n%2.")
+                                 .arg(filePath)
+                                 .arg(job._error));
+            return;
+        }
 
-        unofficialPart                 = false;
+        QFileInfo fileInfo(filePath);
 
         QString modelType = topLevelModel ? "model" : "submodel";
 
-        /* Read it in the first time to put into fileList in order of
-         appearance */
-
-        QRegExp mpdMeta("^0\\s+FILE\\s+(.*)$",Qt::CaseInsensitive);
-        while ( ! in.atEnd()) {
-            QString line = in.readLine(0);
+        if (job._mpd) {
             QString scModelType = modelType[0].toUpper() + modelType.right(modelType.size() - 1);
-            if (line.contains(mpdMeta)) {
-                file.close();
-                emit gui->messageSig(LOG_INFO_STATUS, QString(scModelType + " file %1 identified as Multi-Part LDraw System (MPD) Document").arg(fileInfo.fileName()));
-                QDateTime datetime = fileInfo.lastModified();
-                loadMPDFile(fileInfo.absoluteFilePath(),datetime);
-                return;
-            } else {
-                contents << line.trimmed();
-                if (isHeader(line) && ! unofficialPart) {
-                    unofficialPart = getUnofficialFileType(line);
-                }
+            emit gui->messageSig(LOG_INFO_STATUS, QString(scModelType + " file %1 identified as Multi-Part LDraw System (MPD) Document").arg(fileInfo.fileName()));
+            QDateTime datetime = fileInfo.lastModified();
+            loadMPDFile(fileInfo.absoluteFilePath(),datetime);
+            return;
+        }
+
+        QStringList contents = job._contents;
+
+        unofficialPart = false;
+        for (int i = 0; i < contents.size() && ! unofficialPart; i++) {
+            if (isHeader(contents.at(i))) {
+                unofficialPart = getUnofficialFileType(contents.at(i));
             }
         }
-        file.close();
 
         if (topLevelModel) {
             topLevelDescriptionNotCaptured = true;
@@ -997,22 +1308,8 @@ void LDrawFile::loadLDRFile(const QString &path, const QString &fileName)
             descriptionLine                = 0;
         }
 
-        QStringList searchPaths = Preferences::ldSearchDirs;
-        QString ldrawPath = QDir::toNativeSeparators(Preferences::ldrawLibPath);
-        if (!searchPaths.contains(ldrawPath + QDir::separator() + "MODELS",Qt::CaseInsensitive))
-            searchPaths.append(ldrawPath + QDir::separator() + "MODELS");
-        if (!searchPaths.contains(ldrawPath + QDir::separator() + "PARTS",Qt::CaseInsensitive))
-            searchPaths.append(ldrawPath + QDir::separator() + "PARTS");
-        if (!searchPaths.contains(ldrawPath + QDir::separator() + "P",Qt::CaseInsensitive))
-            searchPaths.append(ldrawPath + QDir::separator() + "P");
-        if (!searchPaths.contains(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "PARTS",Qt::CaseInsensitive))
-            searchPaths.append(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "PARTS");
-        if (!searchPaths.contains(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "P",Qt::CaseInsensitive))
-            searchPaths.append(ldrawPath + QDir::separator() + "UNOFFICIAL" + QDir::separator() + "P");
-
-        QRegExp upAUT("^0\\s+Author:?\\s+(.*)$",Qt::CaseInsensitive);
-        QRegExp upNAM("^0\\s+Name:?\\s+(.*)$",Qt::CaseInsensitive);
-        QRegExp upCAT("^0\\s+!?CATEGORY\\s+(.*)$",Qt::CaseInsensitive);
+        QString metaValue;
+        QString parentPath = fileInfo.absolutePath();
 
         emit gui->progressBarPermInitSig();
         emit gui->progressPermRangeSig(1, contents.size());
@@ -1024,17 +1321,15 @@ void LDrawFile::loadLDRFile(const QString &path, const QString &fileName)
 
         insert(fileInfo.fileName(),contents,datetime,unofficialPart,false,fileInfo.absoluteFilePath());
 
-        /* read it a second time to find submodels */
+        /* walk it a second time to load the subfiles it references */
 
+        int r = 0;
         for (int i = 0; i < contents.size(); i++) {
 
-            QString line = contents.at(i);
+            const QString &line = contents.at(i);
 
             emit gui->progressPermSetValueSig(i);
 
-            QStringList tokens;
-            split(line,tokens);
-
             if (topLevelModel) {
 
                 if (topLevelDescriptionNotCaptured && i == descriptionLine && ! isHeader(line)) {
@@ -1043,61 +1338,43 @@ void LDrawFile::loadLDRFile(const QString &path, const QString &fileName)
                 }
 
                 if (topLevelNameNotCaptured) {
-                    if (line.contains(upNAM)) {
-                        _name = upNAM.cap(1).replace(": ","");
+                    if (matchLoadMeta(line,"Name",false,true,&metaValue)) {
+                        _name = metaValue.replace(": ","");
                         topLevelNameNotCaptured = false;
                     }
                 }
 
                 if (topLevelAuthorNotCaptured) {
-                    if (line.contains(upAUT)) {
-                        _author = upAUT.cap(1).replace(": ","");
+                    if (matchLoadMeta(line,"Author",false,true,&metaValue)) {
+                        _author = metaValue.replace(": ","");
                         topLevelAuthorNotCaptured = false;
                     }
                 }
 
                 if (topLevelCategoryNotCaptured) {
-                    if (line.contains(upCAT)) {
-                        _category = upCAT.cap(1);
+                    if (matchLoadMeta(line,"CATEGORY",true,false,&metaValue)) {
+                        _category = metaValue;
                         topLevelCategoryNotCaptured = false;
                     }
                 }
             }
 
-            // resolve outstanding subfiles
-            if (tokens.size() == 15 && tokens[0] == "1") {
-                QFileInfo subFileInfo = QFileInfo(tokens[tokens.size()-1]);
-                PieceInfo* standardPart = lcGetPiecesLibrary()->FindPiece(subFileInfo.fileName().toLatin1().constData(), nullptr, false, false);
-                if (! standardPart && ! LDrawFile::contains(subFileInfo.fileName())) {
-                    bool subFileFound = false;
-                    // current path
-                    if ((subFileFound = QFileInfo(path + QDir::separator() + subFileInfo.fileName()).isFile())) {
-                        subFileInfo = QFileInfo(path + QDir::separator() + subFileInfo.fileName());
-                    } else
-                    // file path
-                    if ((subFileFound = QFileInfo(subFileInfo.fileName()).isFile())){
-                        subFileInfo = QFileInfo(subFileInfo.fileName());
-                    }
-                    else
-                    // extended search - LDraw subfolder paths and extra search directorie paths
-                    if (Preferences::extendedSubfileSearch) {
-                        for (QString subFilePath : searchPaths){
-                            if ((subFileFound = QFileInfo(subFilePath + QDir::separator() + subFileInfo.fileName()).isFile())) {
-                                subFileInfo = QFileInfo(subFilePath + QDir::separator() + subFileInfo.fileName());
-                                break;
-                            }
-                        }
-                    }
+            if (r == job._refLines.size() || job._refLines[r] != i) {
+                continue;
+            }
 
-                    if (subFileFound) {
-                        emit gui->messageSig(LOG_NOTICE, QString("Subfile %1 detected").arg(subFileInfo.fileName()));
-                        topLevelModel = false;
-                        loadLDRFile(subFileInfo.absolutePath(),subFileInfo.fileName());
-                    } else {
-                        emit gui->messageSig(LOG_NOTICE, QString("Subfile %1 not found.")
-                                             .arg(subFileInfo.fileName()));
-                    }
-                }
+            const QString &name = job._refNames[r++];
+            if (isStandardPart(name) || LDrawFile::contains(name)) {
+                continue;
+            }
+
+            QString subFilePath = located.value(locateKey(parentPath,name));
+            if (subFilePath.size()) {
+                emit gui->messageSig(LOG_NOTICE, QString("Subfile %1 detected").arg(QFileInfo(subFilePath).fileName()));
+                topLevelModel = false;
+                insertLDRFile(subFilePath);
+            } else {
+                emit gui->messageSig(LOG_NOTICE, QString("Subfile %1 not found.").arg(name));
             }
         }
 
@@ -1107,7 +1384,9 @@ void LDrawFile::loadLDRFile(const QString &path, const QString &fileName)
         emit gui->progressPermStatusRemoveSig();
         emit gui->messageSig(LOG_TRACE, QString("LDR " + modelType + " file '" + fileInfo.fileName() + "' with " +
                                                  QString::number(contents.size()) + " lines loaded."));
-    }
+    };
+
+    insertLDRFile(topFilePath);
 }
 
 bool LDrawFile::saveFile(const QString &fileName)
@@ -1153,15 +1432,147 @@ bool LDrawFile::mirrored(
   //return a*(e*i - f*h) - b*(d*i - f*g) + c*(d*h - e*g) < 0;
 }
 
-void LDrawFile::countInstances(const QString &mcFileName, bool isMirrored, bool callout)
+static bool isLPubMeta(const QStringList &tokens, int size, const QString &keyword)
 {
-  //logTrace() << QString("countInstances, File: %1, Mirrored: %2, Callout: %3").arg(mcFileName,(isMirrored?"Yes":"No"),(callout?"Yes":"No"));
+  return tokens.size() == size &&
+         tokens[0] == "0" &&
+        (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
+         tokens[2] == keyword;
+}
 
-  QString fileName = mcFileName.toLower();
+static bool validPartExtension(const QString &name)
+{
+  QString ext = name.toUpper();
+  return ext.contains(".DAT") || ext.contains(".LDR") || ext.endsWith(".MPD");
+}
+
+/* part count references follow PART and PLI ignore */
+
+static void addPartRef(const QStringList &tokens, bool &doCountParts, QMap<QString, int> &partRefs)
+{
+  if (tokens.size() == 5 &&
+      tokens[0] == "0" &&
+     (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
+     (tokens[2] == "PART" || tokens[2] == "PLI") &&
+      tokens[3] == "BEGIN"  &&
+      tokens[4] == "IGN") {
+    doCountParts = false;
+  } else if (tokens.size() == 4 &&
+             tokens[0] == "0" &&
+            (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
+            (tokens[2] == "PART" || tokens[2] == "PLI") &&
+             tokens[3] == "END") {
+    doCountParts = true;
+  }
+
+  if (doCountParts && tokens.size() == 15 && tokens[0] == "1" && validPartExtension(tokens[14])) {
+    ++partRefs[tokens[14]];
+  }
+}
+
+/*
+ * Tokenize a submodel once into the submodel references countInstances
+ * follows, the part references countParts follows and its step count.
+ * The refs are rebuilt when the contents change or submodels come and go.
+ */
+
+void LDrawFile::buildSubFileRefs(LDrawSubFile &subFile)
+{
   bool partsAdded = false;
   bool noStep = false;
   bool stepIgnore = false;
-  
+  bool doCountParts = true;
+
+  subFile._subFileRefs.clear();
+  subFile._partRefs.clear();
+  subFile._refSteps = 0;
+
+  auto addSubFileRef = [&subFile] (const QString &fileName, bool isMirrored, bool callout)
+  {
+    if (subFile._subFileRefs.size()) {
+      SubFileRef &last = subFile._subFileRefs.last();
+      if (last._fileName == fileName && last._mirrored == isMirrored && last._callout == callout) {
+        ++last._count;
+        return;
+      }
+    }
+    subFile._subFileRefs.append(SubFileRef(fileName,isMirrored,callout));
+  };
+
+  int j = subFile._contents.size();
+
+  for (int i = 0; i < j; i++) {
+    QStringList tokens;
+    split(subFile._contents[i],tokens);
+    addPartRef(tokens,doCountParts,subFile._partRefs);
+
+    /* Sorry, but models that are callouts are not counted as instances */
+        // called out
+    if (isLPubMeta(tokens,4,"CALLOUT") && tokens[3] == "BEGIN") {
+      partsAdded = true;
+         //process callout content
+      for (++i; i < j; i++) {
+        split(subFile._contents[i],tokens);
+        addPartRef(tokens,doCountParts,subFile._partRefs);
+        if (tokens.size() == 15 && tokens[0] == "1") {
+          if (contains(tokens[14]) && ! stepIgnore) {
+            addSubFileRef(tokens[14].toLower(),mirrored(tokens),true);
+          }
+        } else if (isLPubMeta(tokens,4,"CALLOUT") && tokens[3] == "END") {
+          break;
+        }
+      }
+      //lpub3d ignore part - so set ignore step
+    } else if (tokens.size() == 5 &&
+               tokens[0] == "0" &&
+               (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
+               (tokens[2] == "PART" || tokens[2] == "PLI") &&
+               tokens[3] == "BEGIN"  &&
+               tokens[4] == "IGN") {
+      stepIgnore = true;
+      // lpub3d part - so set include step
+    } else if (tokens.size() == 4 &&
+               tokens[0] == "0" &&
+               (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
+               (tokens[2] == "PART" || tokens[2] == "PLI") &&
+               tokens[3] == "END") {
+      stepIgnore = false;
+      // no step
+    } else if (isLPubMeta(tokens,3,"NOSTEP")) {
+      noStep = true;
+      // LDraw step or rotstep - so check if parts added
+    } else if (tokens.size() >= 2 && tokens[0] == "0" &&
+              (tokens[1] == "STEP" || tokens[1] == "ROTSTEP")) {
+      // parts added - increment step
+      subFile._refSteps += partsAdded && ! noStep;
+      // reset partsAdded
+      partsAdded = false;
+      noStep = false;
+    } else if (tokens.size() == 15 && tokens[0] == "1") {
+      if (contains(tokens[14]) && ! stepIgnore) {
+        addSubFileRef(tokens[14].toLower(),mirrored(tokens),false);
+      }
+      partsAdded = true;
+    }
+  }
+  //add step if parts added
+  subFile._refSteps += partsAdded && ! noStep;
+
+  subFile._refsVersion = _subFilesVersion;
+}
+
+/*
+ * Walk the submodel reference graph depth first.  A submodel is expanded
+ * on its first visit only, later visits just add to its instance count,
+ * so each edge is followed once and a run of references is added at once.
+ */
+
+void LDrawFile::countInstances(const QString &mcFileName, bool isMirrored, bool callout)
+{
+  //logTrace() << QString("countInstances, File: %1, Mirrored: %2, Callout: %3").arg(mcFileName,(isMirrored?"Yes":"No"),(callout?"Yes":"No"));
+
+  QString fileName = mcFileName.toLower();
+
   QMap<QString, LDrawSubFile>::iterator f = _subFiles.find(fileName);
   if (f != _subFiles.end()) {
     // count mirrored instance automatically
@@ -1173,88 +1584,24 @@ void LDrawFile::countInstances(const QString &mcFileName, bool isMirrored, bool
       }
       return;
     }
-    // get content size and reset numSteps
-    int j = f->_contents.size();
-    f->_numSteps = 0;
-
-    // process submodel content...
-    for (int i = 0; i < j; i++) {
-      QStringList tokens;
-      QString line = f->_contents[i];
-      split(line,tokens);
-      
-      /* Sorry, but models that are callouts are not counted as instances */
-          // called out
-      if (tokens.size() == 4 && 
-          tokens[0] == "0" && 
-          (tokens[1] == "LPUB" || tokens[1] == "!LPUB") && 
-          tokens[2] == "CALLOUT" && 
-          tokens[3] == "BEGIN") {
-        partsAdded = true;
-           //process callout content
-        for (++i; i < j; i++) {
-          split(f->_contents[i],tokens);
-          if (tokens.size() == 15 && tokens[0] == "1") {
-            if (contains(tokens[14]) && ! stepIgnore) {
-              countInstances(tokens[14],mirrored(tokens),true);
-            }
-          } else if (tokens.size() == 4 &&
-              tokens[0] == "0" && 
-              (tokens[1] == "LPUB" || tokens[1] == "!LPUB") && 
-              tokens[2] == "CALLOUT" && 
-              tokens[3] == "END") {
-            
-            break;
-          }
-        }
-        //lpub3d ignore part - so set ignore step
-      } else if (tokens.size() == 5 &&
-                 tokens[0] == "0" &&
-                 (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
-                 (tokens[2] == "PART" || tokens[2] == "PLI") &&
-                 tokens[3] == "BEGIN"  &&
-                 tokens[4] == "IGN") {
-        stepIgnore = true;
-        // lpub3d part - so set include step
-      } else if (tokens.size() == 4 &&
-                 tokens[0] == "0" &&
-                 (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
-                 (tokens[2] == "PART" || tokens[2] == "PLI") &&
-                 tokens[3] == "END") {
-        stepIgnore = false;
-        // no step
-      } else if (tokens.size() == 3 && tokens[0] == "0" &&
-                (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
-                 tokens[2] == "NOSTEP") {
-        noStep = true;
-        // LDraw step or rotstep - so check if parts added
-      } else if (tokens.size() >= 2 && tokens[0] == "0" &&
-                (tokens[1] == "STEP" || tokens[1] == "ROTSTEP")) {
-        // parts added - increment step
-        if (partsAdded && ! noStep) {
-          int incr = (isMirrored && f->_mirrorInstances == 0) ||
-                     (!isMirrored && f->_instances == 0);
-          f->_numSteps += incr;
-        }
-        // reset partsAdded
-        partsAdded = false;
-        noStep = false;
-        // buffer exchange - do nothing
-      } else if (tokens.size() == 4 && tokens[0] == "0"
-                                     && tokens[1] == "BUFEXCHG") {
-        // check if subfile and process...
-      } else if (tokens.size() == 15 && tokens[0] == "1") {
-        bool containsSubFile = contains(tokens[14]);
-        if (containsSubFile && ! stepIgnore) {
-          countInstances(tokens[14],mirrored(tokens),false);
+    if (f->_refsVersion != _subFilesVersion) {
+      buildSubFileRefs(f.value());
+    }
+    f->_numSteps = f->_refSteps;
+
+    QVector<SubFileRef> refs = f->_subFileRefs;
+    for (int i = 0; i < refs.size(); i++) {
+      const SubFileRef &ref = refs[i];
+      countInstances(ref._fileName,ref._mirrored,ref._callout);
+      if (ref._count > 1) {
+        QMap<QString, LDrawSubFile>::iterator r = _subFiles.find(ref._fileName);
+        if (ref._mirrored) {
+          r->_mirrorInstances += ref._count - 1;
+        } else {
+          r->_instances += ref._count - 1;
         }
-        partsAdded = true;
       }
     }
-    //add step if parts added
-    f->_numSteps += partsAdded && ! noStep &&
-                       ( (isMirrored && f->_mirrorInstances == 0) ||
-                       (!isMirrored && f->_instances == 0) );
     //
     if ( ! callout) {
       if (isMirrored) {
@@ -1263,9 +1610,8 @@ void LDrawFile::countInstances(const QString &mcFileName, bool isMirrored, bool
         ++f->_instances;
       }
     }
-
+    f->_beenCounted = true;
   } // file end
-  f->_beenCounted = true;
 }
 
 void LDrawFile::countInstances()
@@ -1323,132 +1669,137 @@ bool LDrawFile::saveMPDFile(const QString &fileName)
 
 void LDrawFile::countParts(const QString &fileName){
 
+    QHash<QString, int> subFileParts;
+    QHash<QString, int> libraryParts;
+
+    _partCount += countSubFileParts(fileName,subFileParts,libraryParts);
+}
+
+/*
+ * Count the parts in a submodel from its tokenized part references.  Each
+ * submodel is counted once and multiplied by how often it is referenced,
+ * and each library part is looked up once.
+ */
+
+int LDrawFile::countSubFileParts(const QString &fileName,
+                                 QHash<QString, int> &subFileParts,
+                                 QHash<QString, int> &libraryParts){
+
+    QString subFileName = fileName.toLower();
+
+    QHash<QString, int>::const_iterator c = subFileParts.constFind(subFileName);
+    if (c != subFileParts.constEnd()) {
+        return c.value();
+    }
+
     //logDebug() << QString("  Subfile: %1, Subfile Parts Count: %2").arg(fileName).arg(count);
     emit gui->messageSig(LOG_STATUS, QString("Processing subfile '%1'").arg(fileName));
 
     int sfCount = 0;
-    bool doCountParts = true;
-
-    QRegExp validEXT("\\.DAT|\\.LDR|\\.MPD$",Qt::CaseInsensitive);
+    subFileParts.insert(subFileName,sfCount);
 
-    QMap<QString, LDrawSubFile>::iterator f = _subFiles.find(fileName.toLower());
+    QMap<QString, LDrawSubFile>::iterator f = _subFiles.find(subFileName);
     if (f != _subFiles.end()) {
-        // get content size and reset numSteps
-        int j = f->_contents.size();
+        if (f->_refsVersion != _subFilesVersion) {
+            buildSubFileRefs(f.value());
+        }
+        QMap<QString, int> partRefs = f->_partRefs;
+        QMap<QString, int>::const_iterator p;
+        for (p = partRefs.constBegin(); p != partRefs.constEnd(); ++p) {
+            sfCount += p.value() * countPartRef(p.key(),subFileParts,libraryParts);
+        }
+    }
 
-        // process submodel content...
-        for (int i = 0; i < j; i++) {
-            QStringList tokens;
-            QString line = f->_contents[i];
+    subFileParts.insert(subFileName,sfCount);
+    return sfCount;
+}
 
-            split(line,tokens);
+int LDrawFile::countPartRef(const QString &name,
+                            QHash<QString, int> &subFileParts,
+                            QHash<QString, int> &libraryParts){
 
-// interrogate each line
-//          if (tokens[0] != "1") {
-//              logNotice() << QString("     Line: [%1] %2").arg(fileName).arg(line);
-//            }
+    QString partString = "|" + name + "|";
+    bool containsSubFile = contains(name.toLower());
+    if (containsSubFile) {
+        int subFileType = isUnofficialPart(name.toLower());
+        if (subFileType == UNOFFICIAL_SUBMODEL){
+            return countSubFileParts(name,subFileParts,libraryParts);
+        } else {
+            switch(subFileType){
+            case  UNOFFICIAL_PART:
+                partString += QString("Unofficial inlined part");
+                if (!_loadedParts.contains(QString(VALID_LOAD_MSG) + partString)) {
+                    _loadedParts.append(QString(VALID_LOAD_MSG) + partString);
+                    emit gui->messageSig(LOG_NOTICE,QString("Unofficial inlined part [%1] validated.").arg(name));
+                }
+                return 1;
+            case  UNOFFICIAL_SUBPART:
+                partString += QString("Unofficial inlined subpart");
+                if (!_loadedParts.contains(QString(SUBPART_LOAD_MSG) + partString)) {
+                    _loadedParts.append(QString(SUBPART_LOAD_MSG) + partString);
+                    emit gui->messageSig(LOG_NOTICE,QString("Unofficial inlined part [%1] is a subpart").arg(name));
+                }
+                break;
+            case  UNOFFICIAL_PRIMITIVE:
+                partString += QString("Unofficial inlined primitive");
+                if (!_loadedParts.contains(QString(PRIMITIVE_LOAD_MSG) + partString)) {
+                    _loadedParts.append(QString(PRIMITIVE_LOAD_MSG) + partString);
+                    emit gui->messageSig(LOG_NOTICE,QString("Unofficial inlined part [%1] is a primitive").arg(name));
+                }
+                break;
+            default:
+                break;
+            }
+        }
+        return 0;
+    }
 
-            if (tokens.size() == 5 &&
-                tokens[0] == "0" &&
-               (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
-               (tokens[2] == "PART" || tokens[2] == "PLI") &&
-                tokens[3] == "BEGIN"  &&
-                tokens[4] == "IGN") {
-                doCountParts = false;
+    QHash<QString, int>::const_iterator l = libraryParts.constFind(name);
+    if (l != libraryParts.constEnd()) {
+        return l.value();
+    }
+
+    int count = 0;
+    if (! ExcludedParts::hasExcludedPart(name)) {
+        QString partFile = name.toUpper();
+        if (partFile.startsWith("S\\")) {
+            partFile.replace("S\\","S/");
+        }
+        PieceInfo* pieceInfo = lcGetPiecesLibrary()->FindPiece(partFile.toLatin1().constData(), nullptr, false, false);
+        if (pieceInfo) {
+            partString += pieceInfo->m_strDescription;
+            if (pieceInfo->IsSubPiece()) {
+                if (!_loadedParts.contains(QString(SUBPART_LOAD_MSG) + partString)){
+                    _loadedParts.append(QString(SUBPART_LOAD_MSG) + partString);
+                    emit gui->messageSig(LOG_NOTICE,QString("Part [%1] is a subpart").arg(name));
+                }
             } else
-            if (tokens.size() == 4 &&
-                tokens[0] == "0" &&
-               (tokens[1] == "LPUB" || tokens[1] == "!LPUB") &&
-               (tokens[2] == "PART" || tokens[2] == "PLI") &&
-                tokens[3] == "END") {
-               doCountParts = true;
+            if (pieceInfo->IsPartType()) {
+                count = 1;
+                if (!_loadedParts.contains(QString(VALID_LOAD_MSG) + partString)) {
+                    _loadedParts.append(QString(VALID_LOAD_MSG) + partString);
+                    emit gui->messageSig(LOG_NOTICE,QString("Part [%1] validated.").arg(name));
+                }
+            } else
+            if (lcGetPiecesLibrary()->IsPrimitive(partFile.toLatin1().constData())){
+                if (!_loadedParts.contains(QString(PRIMITIVE_LOAD_MSG) + partString)) {
+                    _loadedParts.append(QString(PRIMITIVE_LOAD_MSG) + partString);
+                    emit gui->messageSig(LOG_NOTICE,QString("Part [%1] is a primitive part").arg(name));
+                }
             }
-
-            if (doCountParts && tokens.size() == 15 && tokens[0] == "1" && (tokens[14].contains(validEXT))) {
-                QString partString = "|" + tokens[14] + "|";
-                bool containsSubFile = contains(tokens[14].toLower());
-                if (containsSubFile) {
-                    int subFileType = isUnofficialPart(tokens[14].toLower());
-                    if (subFileType == UNOFFICIAL_SUBMODEL){
-                        countParts(tokens[14]);
-                    } else {
-                        switch(subFileType){
-                        case  UNOFFICIAL_PART:
-                            _partCount++;sfCount++;
-                            partString += QString("Unofficial inlined part");
-                            if (!_loadedParts.contains(QString(VALID_LOAD_MSG) + partString)) {
-                                _loadedParts.append(QString(VALID_LOAD_MSG) + partString);
-                                emit gui->messageSig(LOG_NOTICE,QString("Unofficial inlined part %1 [%2] validated.").arg(_partCount).arg(tokens[14]));
-                            }
-                            break;
-                        case  UNOFFICIAL_SUBPART:
-                            partString += QString("Unofficial inlined subpart");
-                            if (!_loadedParts.contains(QString(SUBPART_LOAD_MSG) + partString)) {
-                                _loadedParts.append(QString(SUBPART_LOAD_MSG) + partString);
-                                emit gui->messageSig(LOG_NOTICE,QString("Unofficial inlined part [%1] is a subpart").arg(tokens[14]));
-                            }
-                            break;
-                        case  UNOFFICIAL_PRIMITIVE:
-                            partString += QString("Unofficial inlined primitive");
-                            if (!_loadedParts.contains(QString(PRIMITIVE_LOAD_MSG) + partString)) {
-                                _loadedParts.append(QString(PRIMITIVE_LOAD_MSG) + partString);
-                                emit gui->messageSig(LOG_NOTICE,QString("Unofficial inlined part [%1] is a primitive").arg(tokens[14]));
-                            }
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                } else if (! ExcludedParts::hasExcludedPart(tokens[14])) {
-                    QString partFile = tokens[14].toUpper();
-                    if (partFile.startsWith("S\\")) {
-                        partFile.replace("S\\","S/");
-                    }
-                    PieceInfo* pieceInfo;
-                    if (!_loadedParts.contains(QString(VALID_LOAD_MSG) + partString)) {
-                        pieceInfo = lcGetPiecesLibrary()->FindPiece(partFile.toLatin1().constData(), nullptr, false, false);
-                        if (pieceInfo) {
-                            partString += pieceInfo->m_strDescription;
-                            if (pieceInfo->IsSubPiece()) {
-                                if (!_loadedParts.contains(QString(SUBPART_LOAD_MSG) + partString)){
-                                    _loadedParts.append(QString(SUBPART_LOAD_MSG) + partString);
-                                    emit gui->messageSig(LOG_NOTICE,QString("Part [%1] is a subpart").arg(tokens[14]));
-                                }
-                            } else
-                            if (pieceInfo->IsPartType()) {
-                                _partCount++;sfCount++;
-                                if (!_loadedParts.contains(QString(VALID_LOAD_MSG) + partString)) {
-                                    _loadedParts.append(QString(VALID_LOAD_MSG) + partString);
-                                    emit gui->messageSig(LOG_NOTICE,QString("Part %1 [%2] validated.").arg(_partCount).arg(tokens[14]));
-                                }
-                            } else
-                            if (lcGetPiecesLibrary()->IsPrimitive(partFile.toLatin1().constData())){
-                                if (pieceInfo->IsSubPiece()) {
-                                    if (!_loadedParts.contains(QString(SUBPART_LOAD_MSG) + partString)) {
-                                        _loadedParts.append(QString(SUBPART_LOAD_MSG) + partString);
-                                        emit gui->messageSig(LOG_NOTICE,QString("Part [%1] is a subpart").arg(tokens[14]));
-                                    }
-                                } else {
-                                    if (!_loadedParts.contains(QString(PRIMITIVE_LOAD_MSG) + partString)) {
-                                        _loadedParts.append(QString(PRIMITIVE_LOAD_MSG) + partString);
-                                        emit gui->messageSig(LOG_NOTICE,QString("Part [%1] is a primitive part").arg(tokens[14]));
-                                    }
-                                }
-                            }
-                        } else {
-                            partString += QString("Part not found");
-                            if (!_loadedParts.contains(QString(MISSING_LOAD_MSG) + partString)) {
-                                _loadedParts.append(QString(MISSING_LOAD_MSG) + partString);
-                                emit gui->messageSig(LOG_NOTICE,QString("Part [%1] not excluded, not a submodel and not found in the %2 library archives.")
-                                                     .arg(tokens[14])
-                                        .arg(VER_PRODUCTNAME_STR));
-                            }
-                        }
-                    }
-                }  // check excluded
+        } else {
+            partString += QString("Part not found");
+            if (!_loadedParts.contains(QString(MISSING_LOAD_MSG) + partString)) {
+                _loadedParts.append(QString(MISSING_LOAD_MSG) + partString);
+                emit gui->messageSig(LOG_NOTICE,QString("Part [%1] not excluded, not a submodel and not found in the %2 library archives.")
+                                     .arg(name)
+                                     .arg(VER_PRODUCTNAME_STR));
             }
         }
-    }
+    }  // check excluded
+
+    libraryParts.insert(name,count);
+    return count;
 }
 
 bool LDrawFile::saveLDRFile(const QString &fileName)
@@ -1502,6 +1853,18 @@ bool LDrawFile::changedSinceLastWrite(const QString &fileName)
   return false;
 }
 
+bool LDrawFile::changedSinceLastIndex(const QString &fileName)
+{
+  QString mcFileName = fileName.toLower();
+  QMap<QString, LDrawSubFile>::iterator i = _subFiles.find(mcFileName);
+  if (i != _subFiles.end()) {
+    bool value = i.value()._changedSinceLastIndex;
+    i.value()._changedSinceLastIndex = false;
+    return value;
+  }
+  return false;
+}
+
 void LDrawFile::tempCacheCleared()
 {
   QString key;
@@ -1524,9 +1887,13 @@ void LDrawFile::insertViewerStep(const QString     &fileName,
   QMap<QString, ViewerStep>::iterator i = _viewerSteps.find(mfileName);
 
   if (i != _viewerSteps.end()) {
+    releaseViewerStepLines(i.value()._rotatedContents);
+    releaseViewerStepLines(i.value()._unrotatedContents);
     _viewerSteps.erase(i);
   }
-  ViewerStep viewerStep(rotatedContents,unrotatedContents,filePath,csiKey,multiStep,calledOut);
+  ViewerStep viewerStep(storeViewerStepLines(rotatedContents,true),
+                        storeViewerStepLines(unrotatedContents,false),
+                        filePath,csiKey,multiStep,calledOut);
   _viewerSteps.insert(mfileName,viewerStep);
 }
 
@@ -1538,10 +1905,10 @@ void LDrawFile::updateViewerStep(const QString &fileName, const QStringList &con
   QMap<QString, ViewerStep>::iterator i = _viewerSteps.find(mfileName);
 
   if (i != _viewerSteps.end()) {
-    if (rotated)
-      i.value()._rotatedContents = contents;
-    else
-      i.value()._unrotatedContents = contents;
+    int &stored = rotated ? i.value()._rotatedContents : i.value()._unrotatedContents;
+    int  previous = stored;
+    stored = storeViewerStepLines(contents,rotated);
+    releaseViewerStepLines(previous);
     i.value()._modified = true;
   }
 }
@@ -1553,7 +1920,7 @@ QStringList LDrawFile::getViewerStepRotatedContents(const QString &fileName)
   QString mfileName = fileName.toLower();
   QMap<QString, ViewerStep>::iterator i = _viewerSteps.find(mfileName);
   if (i != _viewerSteps.end()) {
-    return i.value()._rotatedContents;
+    return viewerStepLines(i.value()._rotatedContents);
   }
   return _emptyList;
 }
@@ -1565,7 +1932,7 @@ QStringList LDrawFile::getViewerStepUnrotatedContents(const QString &fileName)
   QString mfileName = fileName.toLower();
   QMap<QString, ViewerStep>::iterator i = _viewerSteps.find(mfileName);
   if (i != _viewerSteps.end()) {
-    return i.value()._unrotatedContents;
+    return viewerStepLines(i.value()._unrotatedContents);
   }
   return _emptyList;
 }
@@ -1638,6 +2005,180 @@ bool LDrawFile::isViewerStepCalledOut(const QString &fileName)
 void LDrawFile::clearViewerSteps()
 {
   _viewerSteps.clear();
+  clearViewerStepLines();
+}
+
+/* Estimate the memory held by the viewer step contents */
+
+static qint64 viewerLineBytes(const QString &line)
+{
+  return sizeof(QString) + sizeof(QArrayData) + (line.size() + 1) * sizeof(QChar);
+}
+
+ViewerStepMemory LDrawFile::viewerStepMemory()
+{
+  ViewerStepMemory memory;
+  memory._steps = _viewerSteps.size();
+  memory._lines = _viewerStepLinePool.size();
+
+  // each interned line once, with its use count in a hash node
+  QHash<QString, int>::const_iterator pooled = _viewerStepLinePool.constBegin();
+  for (; pooled != _viewerStepLinePool.constEnd(); ++pooled) {
+    memory._bytes += viewerLineBytes(pooled.key()) + sizeof(int) + 2 * sizeof(void *);
+  }
+
+  // stored contents only refer to the lines after their prefix
+  for (const ViewerStepLines &stored : _viewerStepLines) {
+    memory._bytes += sizeof(ViewerStepLines) + stored._lines.size() * sizeof(void *);
+  }
+
+  // each viewer step holding its rotated and unrotated contents in full
+  for (const ViewerStep &viewerStep : _viewerSteps) {
+    int contents[2] = { viewerStep._rotatedContents, viewerStep._unrotatedContents };
+    for (int c = 0; c < 2; c++) {
+      memory._fullBytes += sizeof(QStringList);
+      for (const QString &line : viewerStepLines(contents[c])) {
+        memory._fullBytes += sizeof(void *) + viewerLineBytes(line);
+      }
+    }
+  }
+
+  return memory;
+}
+
+/*
+ * Store viewer step contents against the contents of the same kind stored
+ * just before them.  Consecutive steps of a submodel usually only append
+ * parts, so most steps keep just the lines the step added.  Chains are cut
+ * every so often so materializing a step stays bounded.  The returned
+ * contents carry one reference for the caller, released with
+ * releaseViewerStepLines when the viewer step drops them.
+ */
+
+int LDrawFile::storeViewerStepLines(const QStringList &contents, bool rotated)
+{
+  int &last = _lastViewerStepLines[rotated ? 0 : 1];
+  QStringList &lastContents = _lastViewerStepContents[rotated ? 0 : 1];
+
+  // a redrawn step stores the same contents again, so share them
+  if (last >= 0 && contents == lastContents) {
+    _viewerStepLines[last]._refs++;
+    return last;
+  }
+
+  ViewerStepLines stored;
+  stored._size = contents.size();
+  stored._refs = 2;             // the caller and last stored
+
+  if (last >= 0 && _viewerStepLines[last]._depth < 32) {
+    int size = qMin(contents.size(),lastContents.size());
+    int prefix = 0;
+    while (prefix < size && contents.at(prefix) == lastContents.at(prefix)) {
+      ++prefix;
+    }
+    if (prefix > 0) {
+      stored._base   = last;
+      stored._prefix = prefix;
+      stored._depth  = _viewerStepLines[last]._depth + 1;
+    }
+  }
+
+  if (stored._base >= 0) {
+    _viewerStepLines[stored._base]._refs++;
+  }
+
+  stored._lines.reserve(contents.size() - stored._prefix);
+  for (int i = stored._prefix; i < contents.size(); i++) {
+    const QString &line = contents.at(i);
+    QHash<QString, int>::iterator pooled = _viewerStepLinePool.find(line);
+    if (pooled == _viewerStepLinePool.end()) {
+      pooled = _viewerStepLinePool.insert(line,0);
+    }
+    pooled.value()++;
+    stored._lines << pooled.key();
+  }
+
+  int index;
+  if (_freeViewerStepLines.isEmpty()) {
+    index = _viewerStepLines.size();
+    _viewerStepLines.append(stored);
+  } else {
+    index = _freeViewerStepLines.takeLast();
+    _viewerStepLines[index] = stored;
+  }
+
+  int previous = last;
+  last = index;
+  lastContents = contents;
+  releaseViewerStepLines(previous);
+
+  return index;
+}
+
+/*
+ * Drop one reference to stored viewer step contents.  Contents nothing
+ * uses give their lines back to the pool, free their slot for reuse and
+ * drop their reference to the contents they were based on.
+ */
+
+void LDrawFile::releaseViewerStepLines(int index)
+{
+  while (index >= 0 && index < _viewerStepLines.size()) {
+    ViewerStepLines &stored = _viewerStepLines[index];
+    if (--stored._refs > 0) {
+      return;
+    }
+
+    for (const QString &line : stored._lines) {
+      QHash<QString, int>::iterator pooled = _viewerStepLinePool.find(line);
+      if (pooled != _viewerStepLinePool.end() && --pooled.value() == 0) {
+        _viewerStepLinePool.erase(pooled);
+      }
+    }
+
+    int base = stored._base;
+    stored = ViewerStepLines();
+    _freeViewerStepLines.append(index);
+    index = base;
+  }
+}
+
+/* Rebuild stored viewer step contents from their chain of bases */
+
+QStringList LDrawFile::viewerStepLines(int index)
+{
+  if (index < 0 || index >= _viewerStepLines.size()) {
+    return _emptyList;
+  }
+
+  QVector<int> chain;
+  for (int i = index; i >= 0; i = _viewerStepLines[i]._base) {
+    chain.append(i);
+  }
+
+  QStringList contents;
+  contents.reserve(_viewerStepLines[index]._size);
+
+  for (int c = chain.size() - 1; c >= 0; c--) {
+    const ViewerStepLines &stored = _viewerStepLines[chain[c]];
+    while (contents.size() > stored._prefix) {
+      contents.removeLast();
+    }
+    contents << stored._lines;
+  }
+
+  return contents;
+}
+
+void LDrawFile::clearViewerStepLines()
+{
+  _viewerStepLines.clear();
+  _freeViewerStepLines.clear();
+  _viewerStepLinePool.clear();
+  for (int i = 0; i < 2; i++) {
+    _lastViewerStepLines[i] = -1;
+    _lastViewerStepContents[i].clear();
+  }
 }
 
 // -- -- Utility Functions -- -- //
@@ -1772,6 +2313,8 @@ QList<QRegExp> LDrawUnofficialOtherRegExp;
 LDrawFile::LDrawFile()
 {
     _loadedParts.clear();
+    _subFilesVersion = 0;
+    clearViewerStepLines();
   {
     LDrawHeaderRegExp
         << QRegExp("^0\\s+AUTHOR:?[^\n]*",Qt::CaseInsensitive)
@@ -1842,8 +2385,19 @@ LDrawFile::LDrawFile()
 
 }
 
-bool isHeader(QString &line)
+/* every header and unofficial part pattern is anchored on ^0\s+ */
+
+static inline bool isMetaLine(const QString &line)
+{
+  return line.size() > 1 && line.at(0) == QLatin1Char('0') && line.at(1).isSpace();
+}
+
+bool isHeader(const QString &line)
 {
+  if ( ! isMetaLine(line)) {
+    return false;
+  }
+
   int size = LDrawHeaderRegExp.size();
 
   for (int i = 0; i < size; i++) {
@@ -1861,8 +2415,12 @@ bool isComment(QString &line){
   return false;
 }
 
-int getUnofficialFileType(QString &line)
+int getUnofficialFileType(const QString &line)
 {
+  if ( ! isMetaLine(line)) {
+    return UNOFFICIAL_SUBMODEL;
+  }
+
   int size = LDrawUnofficialPartRegExp.size();
   for (int i = 0; i < size; i++) {
     if (line.contains(LDrawUnofficialPartRegExp[i])) {
@@ -35,6 +35,9 @@
 #include <QMap>
 #include <QDateTime>
 #include <QList>
+#include <QVector>
+#include <QHash>
+#include <QSet>
 
 #include "excludedparts.h"
 #include "QsLog.h"
@@ -45,6 +48,31 @@ extern QList<QRegExp> LDrawUnofficialSubPartRegExp;
 extern QList<QRegExp> LDrawUnofficialPrimitiveRegExp;
 extern QList<QRegExp> LDrawUnofficialOtherRegExp;
 
+/* A run of references from a submodel to another submodel.  These are
+   the edges countInstances walks instead of rescanning the contents. */
+
+class SubFileRef {
+  public:
+    QString     _fileName;      // lower case submodel name
+    int         _count;         // consecutive references
+    bool        _mirrored;
+    bool        _callout;       // inside an unassembled callout
+
+    SubFileRef()
+    {
+      _count    = 0;
+      _mirrored = false;
+      _callout  = false;
+    }
+    SubFileRef(const QString &fileName, bool mirrored, bool callout)
+    {
+      _fileName = fileName;
+      _count    = 1;
+      _mirrored = mirrored;
+      _callout  = callout;
+    }
+};
+
 class LDrawSubFile {
   public:
     QStringList _contents;
@@ -59,14 +87,21 @@ class LDrawSubFile {
     int         _renderedStepNumber;
     bool        _mirrorRendered;
     bool        _changedSinceLastWrite;
+    bool        _changedSinceLastIndex;
     bool        _generated;
     int         _prevStepPosition;
     int         _startPageNumber;
     int         _unofficialPart;
+    QVector<SubFileRef> _subFileRefs; // submodel references in file order
+    QMap<QString, int>  _partRefs;    // counted part references and how many
+    int         _refSteps;            // steps with parts added
+    int         _refsVersion;         // subfile set the refs were built for
 
     LDrawSubFile()
     {
       _unofficialPart = 0;
+      _refSteps = 0;
+      _refsVersion = -1;
     }
     LDrawSubFile(
             const QStringList &contents,
@@ -80,10 +115,35 @@ class LDrawSubFile {
     }
 };
 
+/* Viewer step contents are kept as the lines they share with the step
+   stored before them plus the lines that follow.  Lines are interned so
+   repeated lines across steps share one string.  Stored contents are
+   counted by the viewer steps and later contents using them, and their
+   slot is reused once nothing does. */
+
+class ViewerStepLines {
+  public:
+    int         _base;          // stored contents the prefix comes from, -1 if none
+    int         _prefix;        // lines taken from the base
+    int         _depth;         // bases to walk to materialize
+    int         _size;          // materialized number of lines
+    int         _refs;          // viewer steps, later contents and last stored using this
+    QStringList _lines;         // lines after the prefix
+
+    ViewerStepLines()
+    {
+      _base   = -1;
+      _prefix = 0;
+      _depth  = 0;
+      _size   = 0;
+      _refs   = 0;
+    }
+};
+
 class ViewerStep {
   public:
-    QStringList _rotatedContents;
-    QStringList _unrotatedContents;
+    int         _rotatedContents;     // index into the stored viewer step lines
+    int         _unrotatedContents;
     QString   	_filePath;
     QString     _csiKey;
     bool        _modified;
@@ -92,19 +152,35 @@ class ViewerStep {
 
     ViewerStep()
     {
+      _rotatedContents   = -1;
+      _unrotatedContents = -1;
       _modified = false;
     }
     ViewerStep(
-      const QStringList &rotatedContents,
-      const QStringList &unrotatedContents,
+      int                rotatedContents,
+      int                unrotatedContents,
       const QString     &filePath,
       const QString     &csiKey,
       bool               multiStep,
       bool               calledOut);
-    ~ViewerStep()
+};
+
+/* Bytes the viewer step contents hold, and the bytes the same contents
+   would hold as a full line list per viewer step. */
+
+class ViewerStepMemory {
+  public:
+    int    _steps;          // viewer steps
+    int    _lines;          // interned lines
+    qint64 _bytes;
+    qint64 _fullBytes;
+
+    ViewerStepMemory()
     {
-      _rotatedContents.clear();
-      _unrotatedContents.clear();
+      _steps     = 0;
+      _lines     = 0;
+      _bytes     = 0;
+      _fullBytes = 0;
     }
 };
 
@@ -112,6 +188,11 @@ class LDrawFile {
   private:
     QMap<QString, LDrawSubFile> _subFiles;
     QMap<QString, ViewerStep>   _viewerSteps;
+    QVector<ViewerStepLines>    _viewerStepLines;       // viewer step contents
+    QVector<int>                _freeViewerStepLines;   // released viewer step contents slots
+    QHash<QString, int>         _viewerStepLinePool;    // interned viewer step lines and their use count
+    int                         _lastViewerStepLines[2];     // last rotated, unrotated contents stored
+    QStringList                 _lastViewerStepContents[2];
     QStringList                 _emptyList;
     QString                     _emptyString;
     bool                        _mpd;
@@ -127,6 +208,19 @@ class LDrawFile {
     bool unofficialPart;
     bool topLevelModel;
     int  descriptionLine;
+    int  _subFilesVersion;   // bumped when submodels are added or removed
+
+    void buildSubFileRefs(LDrawSubFile &subFile);
+    int  storeViewerStepLines(const QStringList &contents, bool rotated);
+    QStringList viewerStepLines(int index);
+    void releaseViewerStepLines(int index);
+    void clearViewerStepLines();
+    int  countSubFileParts(const QString &fileName,
+                           QHash<QString, int> &subFileParts,
+                           QHash<QString, int> &libraryParts);
+    int  countPartRef(const QString &name,
+                      QHash<QString, int> &subFileParts,
+                      QHash<QString, int> &libraryParts);
 
   public:
     LDrawFile();
@@ -196,6 +290,10 @@ class LDrawFile {
                         const QString &charsAdded);
 
     bool isMpd();
+    int  subFilesVersion()
+    {
+      return _subFilesVersion;
+    }
     QString topLevelFile();
     int isUnofficialPart(const QString &name);
     int numSteps(const QString &fileName);
@@ -215,6 +313,7 @@ class LDrawFile {
     void countInstances();
     void countInstances(const QString &fileName, bool mirrored, const bool callout = false);
     bool changedSinceLastWrite(const QString &fileName);
+    bool changedSinceLastIndex(const QString &fileName);
     void tempCacheCleared();
 
     /* ViewerStep functions */
@@ -236,12 +335,13 @@ class LDrawFile {
     bool        isViewerStepCalledOut(const QString &fileName);
     bool        viewerStepContentExist(      const QString &fileName);
     void        clearViewerSteps();
+    ViewerStepMemory viewerStepMemory();
 };
 
 int split(const QString &line, QStringList &argv);
 int validSoQ(const QString &line, int soq);
-int  getUnofficialFileType(QString &line);
-bool isHeader(QString &line);
+int  getUnofficialFileType(const QString &line);
+bool isHeader(const QString &line);
 bool isComment(QString &line);
 bool isGhost(QString &line);
 
@@ -49,6 +49,7 @@
 #include "updatecheck.h"
 #include "step.h"
 #include "messageboxresizable.h"
+#include "startup.h"
 
 #include "QProgressDialog"
 #include "lc_http.h"
@@ -1692,14 +1693,9 @@ void Gui::clearStepCSICache(QString &pngName) {
       emit messageSig(LOG_ERROR,QString("Unable to remove %1")
                                         .arg(assemDirName + "/" + fileInfo.fileName()));
     }
-  QString ldrName;
-  if (renderer->useLDViewSCall()){
-      ldrName = tmpDirName + "/" + fileInfo.completeBaseName() + ".ldr";
-    } else {
-      ldrName = tmpDirName + "/csi.ldr";
-    }
+  QString ldrName = tmpDirName + "/" + fileInfo.completeBaseName() + ".ldr";
   file.setFileName(ldrName);
-  if (!file.remove()) {
+  if (file.exists() && !file.remove()) {
       emit messageSig(LOG_ERROR,QString("Unable to remove %1")
                                         .arg(ldrName));
     }
@@ -1749,7 +1745,6 @@ void Gui::clearPageCSIGraphicsItems(Step *step) {
   QString tmpDirName   = QDir::currentPath() + "/" + Paths::tmpDir;
   QString assemDirName = QDir::currentPath() + "/" + Paths::assemDir;
   QString ldrName;
-  bool itemsCleared = false;
   // process step's image(s)
   QFileInfo fileInfo(step->pngName);
   QFile file(assemDirName + "/" + fileInfo.fileName());
@@ -1757,21 +1752,11 @@ void Gui::clearPageCSIGraphicsItems(Step *step) {
       emit messageSig(LOG_ERROR,QString("Unable to remove %1")
                             .arg(assemDirName + "/" + fileInfo.fileName()));
   }
-  if (renderer->useLDViewSCall()){
-      ldrName = tmpDirName + "/" + fileInfo.completeBaseName() + ".ldr";
-      file.setFileName(ldrName);
-      if (!file.remove()) {
-         emit messageSig(LOG_ERROR,QString("Unable to remove %1")
-                                           .arg(ldrName));
-      }
-  } else if (! itemsCleared){
-      ldrName = tmpDirName + "/csi.ldr";
-      file.setFileName(ldrName);
-      if (!file.remove()) {
-          emit messageSig(LOG_ERROR,QString("Unable to remove %1")
-                                            .arg(ldrName));
-      }
-      itemsCleared = true;
+  ldrName = tmpDirName + "/" + fileInfo.completeBaseName() + ".ldr";
+  file.setFileName(ldrName);
+  if (file.exists() && !file.remove()) {
+     emit messageSig(LOG_ERROR,QString("Unable to remove %1")
+                                       .arg(ldrName));
   }
   // process callout step(s) image(s)
   for (int k = 0; k < step->list.size(); k++) {
@@ -2474,6 +2459,7 @@ Gui::Gui()
     exportMode                      = EXPORT_PDF;
     pageRangeText                   = "1";
     resetCache                      = false;
+    pageIndexCheck                  = false;
     m_previewDialog                 = false;
     m_partListCSIFile               = false;
     m_exportingContent              = false;
@@ -2704,16 +2690,20 @@ void Gui::initialize()
 
   emit Application::instance()->splashMsgSig(QString("90% - %1 widgets loading...").arg(VER_PRODUCTNAME_STR));
 
+  StartupTrace::begin("Actions, menus and docks");
   createActions();
   createMenus();
   createToolBars();
   createStatusBar();
   createDockWindows();
   toggleLCStatusBar(true);
+  StartupTrace::end();
 
   emit Application::instance()->splashMsgSig(QString("95% - LDraw colors loading..."));
 
+  StartupTrace::begin("LDraw colors");
   LDrawColor::LDrawColorInit();
+  StartupTrace::end();
 
   emit disable3DActionsSig();
   setCurrentFile("");
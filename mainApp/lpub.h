@@ -338,6 +338,7 @@
 #include <QDockWidget>
 #include <QSettings>
 #include <QDateTime>
+#include <QVector>
 #include <QFileSystemWatcher>
 #include <QtPrintSupport>
 #include <QFile>
@@ -357,6 +358,7 @@
 #include "color.h"
 #include "ranges.h"
 #include "ldrawfiles.h"
+#include "pageindex.h"
 #include "where.h"
 #include "aboutdialog.h"
 #include "version.h"
@@ -456,6 +458,29 @@ const QString nativeExportNames[] =
   "POV-RAY RENDER" // RENDER_POVRAY
 };
 
+/* A csi line as configureModelStep rewrote it for a faded previous step */
+
+class FadeStepLine {
+public:
+  QString line;           // configured line
+  QString colourCode;     // original colour code if it needs a colour entry
+  bool    type_1_5_line;
+
+  FadeStepLine()
+  {
+    type_1_5_line = false;
+  }
+};
+
+/* The faded previous step lines of one model and the csi lines they
+   were made from, which share their data with the next step's lines. */
+
+class FadeStepLines {
+public:
+  QStringList           parts;  // csi lines of the step the lines were made for
+  QVector<FadeStepLine> lines;  // faded rendition of the leading parts
+};
+
 class Gui : public QMainWindow
 {
 
@@ -483,6 +508,7 @@ public:
   QString         pageRangeText;    // page range parameters
   bool            submodelIconsLoaded; // load submodel images
   bool            resetCache;       // reset model, fade and highlight parts
+  bool            pageIndexCheck;   // count pages with findPage too and compare [commandline only]
   QString         saveFileName;      // user specified output file Name [commandline only]
   QString         saveDirectoryName; // user specified output directory name [commandline only]
 
@@ -974,6 +1000,8 @@ public slots:
   void loadLDSearchDirParts();
   bool loadFile(const QString &file);
   int processCommandLine();
+  int processBatch(const QString &manifestFile, const QString &reportFile, const QStringList &Arguments);
+  int processModel(const QStringList &Arguments);
 
 
   void showPovrayRenderDialog();
@@ -1064,6 +1092,9 @@ private:
   LGraphicsScene        *KpageScene;         // top of displayed page's graphics items
   LGraphicsView         *KpageView;          // the visual representation of the scene
   LDrawFile              ldrawFile;          // contains MPD or all files used in model
+  PageIndex              pageIndex;          // tokenized page boundary summary of each submodel
+  QHash<QString, FadeStepLines> fadeStepLines; // faded previous step lines by model name
+  QString                fadeStepLinesKey;   // model and fade settings fadeStepLines were made with
   QString                curFile;            // the file name for MPD, or top level file
   QString                pdfPrintedFile;     // the print preview produced pdf file
   QElapsedTimer          timer;              // measure elapsed time for slow functions
@@ -1107,6 +1138,7 @@ private:
   bool            nextPageContinuousIsRunning;    // stop the continuous next page action
 
   void countPages();
+  bool checkPageIndex();
 
   void skipHeader(Where &current);
 
@@ -1122,6 +1154,14 @@ private:
     bool           printing,
     int            contStepNumber);
 
+  int indexPages(                  // count pages and record the top of each
+    int           &pageNum,        // page from the page index summaries
+    QString const &addColour,
+    Where         &current,
+    PgSizeData    &pageSize,
+    bool           mirrored,
+    Meta           meta);
+
   int drawPage(// process the page of interest and any callouts
     LGraphicsView  *view,
     LGraphicsScene *scene,
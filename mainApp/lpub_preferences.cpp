@@ -156,6 +156,7 @@ bool    Preferences::lpub3dLoaded               = false;
 bool    Preferences::enableDocumentLogo         = false;
 bool    Preferences::enableLDViewSingleCall     = true;
 bool    Preferences::enableLDViewSnaphsotList   = false;
+bool    Preferences::exportImageProofing        = false;
 bool    Preferences::displayAllAttributes       = false;
 bool    Preferences::generateCoverPages         = false;
 bool    Preferences::printDocumentTOC           = false;
@@ -189,6 +190,7 @@ bool    Preferences::showInstanceCount          = false;
 
 bool    Preferences::includeAllLogAttributes    = false;
 bool    Preferences::allLogLevels               = false;
+bool    Preferences::performanceTrace           = false;
 
 bool    Preferences::logLevel                   = false;
 bool    Preferences::logging                    = false;   // logging on/off offLevel (grp box)
@@ -243,6 +245,7 @@ int     Preferences::gridSizeIndex              = GRID_SIZE_INDEX_DEFAULT;
 int     Preferences::pageHeight                 = PAGE_HEIGHT_DEFAULT;
 int     Preferences::pageWidth                  = PAGE_WIDTH_DEFAULT;
 int     Preferences::rendererTimeout            = RENDERER_TIMEOUT_DEFAULT;          // measured in seconds
+int     Preferences::exportImageQuality         = EXPORT_IMAGE_QUALITY_DEFAULT;      // -1=default, 0-100
 int     Preferences::pageDisplayPause           = PAGE_DISPLAY_PAUSE_DEFAULT;        // measured in seconds
 int     Preferences::cameraDistFactorNative     = CAMERA_DISTANCE_FACTOR_NATIVE_DEFAULT;
 
@@ -845,6 +848,15 @@ void Preferences::loggingPreferences()
         includeAllLogAttributes = Settings.value(QString("%1/%2").arg(LOGGING,"IncludeAllLogAttributes")).toBool();
     }
 
+    // Chrome trace of page generation written to the logs folder
+    if ( ! Settings.contains(QString("%1/%2").arg(LOGGING,"PerformanceTrace"))) {
+        QVariant uValue(false);
+        performanceTrace = false;
+        Settings.setValue(QString("%1/%2").arg(LOGGING,"PerformanceTrace"),uValue);
+    } else {
+        performanceTrace = Settings.value(QString("%1/%2").arg(LOGGING,"PerformanceTrace")).toBool();
+    }
+
     if ( ! Settings.contains(QString("%1/%2").arg(LOGGING,"Logging"))) {
         QVariant uValue(true);
         logging = true;
@@ -1998,6 +2010,23 @@ void Preferences::rendererPreferences(UpdateFlag updateFlag)
         rendererTimeout = Settings.value(QString("%1/%2").arg(SETTINGS,"RendererTimeout")).toInt();
     }
 
+    // Export image quality
+    if ( ! Settings.contains(QString("%1/%2").arg(SETTINGS,"ExportImageQuality"))) {
+        exportImageQuality = EXPORT_IMAGE_QUALITY_DEFAULT;
+        Settings.setValue(QString("%1/%2").arg(SETTINGS,"ExportImageQuality"),exportImageQuality);
+    } else {
+        exportImageQuality = Settings.value(QString("%1/%2").arg(SETTINGS,"ExportImageQuality")).toInt();
+    }
+
+    // Export image proofing (fast draft PNG and JPEG images)
+    if ( ! Settings.contains(QString("%1/%2").arg(SETTINGS,"ExportImageProofing"))) {
+        QVariant uValue(false);
+        exportImageProofing = false;
+        Settings.setValue(QString("%1/%2").arg(SETTINGS,"ExportImageProofing"),uValue);
+    } else {
+        exportImageProofing = Settings.value(QString("%1/%2").arg(SETTINGS,"ExportImageProofing")).toBool();
+    }
+
     // Native renderer camera distance factor
     if ( ! Settings.contains(QString("%1/%2").arg(SETTINGS,"CameraDistFactorNative"))) {
         cameraDistFactorNative = CAMERA_DISTANCE_FACTOR_NATIVE_DEFAULT;
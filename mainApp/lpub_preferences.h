@@ -189,6 +189,7 @@ class Preferences
     static bool    enableDocumentLogo;
     static bool    enableLDViewSingleCall;
     static bool    enableLDViewSnaphsotList;
+    static bool    exportImageProofing;
     static bool    displayAllAttributes;
     static bool    generateCoverPages;
     static bool    printDocumentTOC;
@@ -239,6 +240,7 @@ class Preferences
 
     static bool    includeAllLogAttributes;
     static bool    allLogLevels;
+    static bool    performanceTrace;
 
     static bool    logging;       // logging on/off offLevel (grp box)
     static bool    logLevel;      // log level combo (grp box)
@@ -275,6 +277,7 @@ class Preferences
     static int     gridSizeIndex;
     static int     pageDisplayPause;
     static int     rendererTimeout;
+    static int     exportImageQuality;
     static int     sceneGuidesLine;
     static int     sceneGuidesPosition;
     static int     povrayRenderQuality;
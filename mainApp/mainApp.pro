@@ -346,6 +346,7 @@ win32 {
 HEADERS += \
     aboutdialog.h \
     annotations.h \
+    annotationtable.h \
     application.h \
     archiveparts.h \
     backgrounddialog.h \
@@ -392,11 +393,14 @@ HEADERS += \
     pagepointeritem.h \
     pagepointerbackgrounditem.h \
     pagesizedialog.h \
+    pageimagewriter.h \
+    pageindex.h \
     pagesizes.h \
     pairdialog.h \
     parmshighlighter.h \
     parmswindow.h \
     paths.h \
+    perftrace.h \
     placement.h \
     placementdialog.h \
     pli.h \
@@ -423,6 +427,7 @@ HEADERS += \
     rx.h \
     scaledialog.h \
     sizeandorientationdialog.h \
+    startup.h \
     step.h \
     submodelcolordialog.h \
     textitem.h \
@@ -443,6 +448,7 @@ HEADERS += \
 SOURCES += \
     aboutdialog.cpp \
     annotations.cpp \
+    annotationtable.cpp \
     application.cpp \
     archiveparts.cpp \
     assemglobals.cpp \
@@ -495,11 +501,14 @@ SOURCES += \
     pagepointeritem.cpp \
     pagepointerbackgrounditem.cpp \
     pagesizedialog.cpp \
+    pageimagewriter.cpp \
+    pageindex.cpp \
     pagesizes.cpp \
     pairdialog.cpp \
     parmshighlighter.cpp \
     parmswindow.cpp \
     paths.cpp \
+    perftrace.cpp \
     placement.cpp \
     placementdialog.cpp \
     pli.cpp \
@@ -528,6 +537,7 @@ SOURCES += \
     rx.cpp \
     scaledialog.cpp \
     sizeandorientationdialog.cpp \
+    startup.cpp \
     step.cpp \
     submodelcolordialog.cpp \
     textitem.cpp \
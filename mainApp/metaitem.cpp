@@ -3853,7 +3853,7 @@ bool MetaItem::offsetPoint(
       ok[0] = true;
       pngName = QDir::currentPath() + "/" + Paths::tmpDir + "/" + label + "Mono.png";
       if (Preferences::usingNativeRenderer){
-          ldrName = QDir::currentPath() + "/" + Paths::tmpDir + "/csi.ldr";
+          ldrName = Render::getCsiLdrFileName(pngName);
           ok[0] = (renderer->rotateParts(addLine,meta.rotStep,csiParts,ldrName,modelName,meta.LPub.assem.cameraAngles) == 0);
       }
       ok[1] = (renderer->renderCsi(addLine,csiParts,csiKeys,pngName,meta) == 0);
@@ -4300,7 +4300,7 @@ QPointF MetaItem::defaultPointerTip(
       ok[0] = true;
       pngName = QDir::currentPath() + "/" + Paths::tmpDir + "/" + monoOutPngBaseName + ".png";
       if (Preferences::usingNativeRenderer){
-         ldrName = QDir::currentPath() + "/" + Paths::tmpDir + "/csi.ldr";
+         ldrName = Render::getCsiLdrFileName(pngName);
          ok[0] = (renderer->rotateParts(addLine,meta.rotStep,csiParts,ldrName,modelName,meta.LPub.assem.cameraAngles) == 0);
       }
       ok[1] = (renderer->renderCsi(addLine,csiParts,csiKeys,pngName,meta) == 0);
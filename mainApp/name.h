@@ -376,6 +376,11 @@ static const SceneObject NoContextSceneObjects[] =
 
 #define PAGE_DISPLAY_PAUSE_DEFAULT              3    // measured in seconds
 
+#define EXPORT_IMAGE_QUALITY_DEFAULT            -1   // QImage::save default compression
+#define EXPORT_IMAGE_PROOF_PNG_QUALITY          90   // fast, lightly compressed PNG for proofing
+#define EXPORT_IMAGE_PROOF_JPG_QUALITY          50   // small, quickly encoded JPEG for proofing
+#define EXPORT_IMAGE_MAX_PENDING                4    // page images encoding or waiting at once
+
 // Internal common material colours
 #define LDRAW_EDGE_MATERIAL_COLOUR              "24"
 #define LDRAW_MAIN_MATERIAL_COLOUR              "16"
@@ -290,7 +290,9 @@ bool Gui::saveFile(const QString &fileName)
 
 void Gui::closeFile()
 {
+  clearViewerSteps();
   ldrawFile.empty();
+  pageIndex.clear();
   editWindow->textEdit()->document()->clear();
   editWindow->textEdit()->document()->setModified(false);
   mpdCombo->setMaxCount(0);
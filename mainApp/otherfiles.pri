@@ -17,6 +17,13 @@ docs/RELEASE_NOTES.html \
 ../builds/check/build_checks.bat \
 ../builds/check/build_checks.sh \
 ../builds/check/build_checks.mpd \
+../builds/check/image_checks.sh \
+../builds/check/image_checks.mpd \
+../builds/check/index_checks.sh \
+../builds/check/index_checks.mpd \
+../builds/check/load_checks.sh \
+../builds/check/perf_checks.sh \
+../builds/check/render_checks.sh \
 ../builds/linux/CreateDeb.sh \
 ../builds/linux/CreatePkg.sh \
 ../builds/linux/CreateRpm.sh \
@@ -0,0 +1,113 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * This file encodes exported page images on worker threads as described
+ * in pageimagewriter.h.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#include <QRunnable>
+#include <QThread>
+#include <QMutexLocker>
+#include <QFileInfo>
+
+#include "pageimagewriter.h"
+#include "lpub_preferences.h"
+#include "name.h"
+#include "perftrace.h"
+
+class PageImageJob : public QRunnable {
+public:
+  PageImageJob(PageImageWriter *writer, const QImage &image, const QString &fileName)
+    : _writer(writer), _image(image), _fileName(fileName)
+  {
+  }
+
+  void run() override
+  {
+    PerfSpan perfSpan("export", "encodeImage", _fileName);
+    bool ok = _image.save(_fileName, nullptr, _writer->quality(_fileName));
+    _image = QImage();
+    _writer->done(_fileName, ok);
+  }
+
+private:
+  PageImageWriter *_writer;
+  QImage           _image;
+  QString          _fileName;
+};
+
+PageImageWriter::PageImageWriter()
+{
+  _pending    = 0;
+  _maxPending = qBound(1, QThread::idealThreadCount(), EXPORT_IMAGE_MAX_PENDING);
+  _quality    = Preferences::exportImageQuality;
+  _proofing   = Preferences::exportImageProofing;
+  _pool.setMaxThreadCount(_maxPending);
+}
+
+PageImageWriter::~PageImageWriter()
+{
+  finish();
+}
+
+int PageImageWriter::quality(const QString &fileName) const
+{
+  if (_proofing) {
+    QString suffix = QFileInfo(fileName).suffix().toLower();
+    if (suffix == "png") {
+      return EXPORT_IMAGE_PROOF_PNG_QUALITY;
+    } else if (suffix == "jpg" || suffix == "jpeg") {
+      return EXPORT_IMAGE_PROOF_JPG_QUALITY;
+    }
+  }
+  return _quality;
+}
+
+void PageImageWriter::write(const QImage &image, const QString &fileName)
+{
+  QMutexLocker locker(&_mutex);
+  while (_pending >= _maxPending) {
+    _finished.wait(&_mutex);
+  }
+  _pending++;
+  locker.unlock();
+
+  _pool.start(new PageImageJob(this, image, fileName));
+}
+
+void PageImageWriter::done(const QString &fileName, bool ok)
+{
+  QMutexLocker locker(&_mutex);
+  if (! ok) {
+    _failures.append(fileName);
+  }
+  _pending--;
+  _finished.wakeAll();
+}
+
+bool PageImageWriter::finish()
+{
+  _pool.waitForDone();
+
+  QMutexLocker locker(&_mutex);
+  return _failures.isEmpty();
+}
@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * The page image writer takes the page images Gui::exportAs paints and
+ * encodes them to disk on a pool of worker threads, so compressing one
+ * page overlaps laying out and painting the next.  At most a fixed number
+ * of images wait or encode at once; write blocks until one finishes when
+ * that many are in flight, which bounds the memory an export holds.
+ *
+ * The quality handed to QImage::save comes from the ExportImageQuality
+ * setting.  When ExportImageProofing is set it depends on the format
+ * instead: PNG gets EXPORT_IMAGE_PROOF_PNG_QUALITY, a light compression
+ * that encodes much faster, and JPEG gets EXPORT_IMAGE_PROOF_JPG_QUALITY,
+ * a low quality that makes smaller files a little faster.  BMP is not
+ * compressed, so proofing leaves it alone.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#ifndef PAGEIMAGEWRITER_H
+#define PAGEIMAGEWRITER_H
+
+#include <QImage>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+
+class PageImageWriter {
+public:
+  PageImageWriter();
+  ~PageImageWriter();
+
+  /* queue an image to be saved, waiting while the queue is full */
+  void write(const QImage &image, const QString &fileName);
+
+  /* wait for every queued image, false if any could not be saved */
+  bool finish();
+
+  QStringList failures() const
+  {
+    return _failures;
+  }
+
+  /* quality to save the named image with, by its format */
+  int quality(const QString &fileName) const;
+
+private:
+  friend class PageImageJob;
+  void done(const QString &fileName, bool ok);
+
+  QThreadPool     _pool;
+  QMutex          _mutex;
+  QWaitCondition  _finished;
+  QStringList     _failures;
+  int             _pending;
+  int             _maxPending;
+  int             _quality;
+  bool            _proofing;
+};
+
+#endif // PAGEIMAGEWRITER_H
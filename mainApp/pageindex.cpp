@@ -0,0 +1,404 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * This file builds the per submodel page index summaries described in
+ * pageindex.h.  The line classification here must follow the return codes
+ * Meta::parse hands findPage for the same lines.  builds/check/index_checks.sh
+ * counts the pages of its check models both ways (see Gui::checkPageIndex)
+ * to catch the two drifting apart.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#include <QtConcurrent>
+
+#include "pageindex.h"
+#include "ldrawfiles.h"
+#include "meta.h"
+
+/*
+ * Reduce an LPub meta to its keywords the way BranchMeta::parse sees
+ * them - LPUB becomes !LPUB and a LOCAL or GLOBAL qualifier is dropped.
+ */
+
+static QStringList lpubKeywords(const QStringList &tokens)
+{
+  QStringList argv = tokens.mid(1);
+  if (argv.size() && argv[0] == "LPUB") {
+    argv[0] = "!LPUB";
+  }
+  if (argv.size() > 2 && (argv[2] == "LOCAL" || argv[2] == "GLOBAL")) {
+    argv.removeAt(2);
+  }
+  return argv;
+}
+
+static bool validRotStep(const QStringList &tokens)
+{
+  if (tokens.size() == 3) {
+    return tokens[2] == "END";
+  }
+  if (tokens.size() == 6) {
+    bool ok[3];
+    tokens[2].toFloat(&ok[0]);
+    tokens[3].toFloat(&ok[1]);
+    tokens[4].toFloat(&ok[2]);
+    return ok[0] && ok[1] && ok[2] &&
+          (tokens[5] == "ABS" || tokens[5] == "REL" || tokens[5] == "ADD");
+  }
+  return false;
+}
+
+static bool classifyMeta(const QStringList &tokens, IndexLine &index)
+{
+  if (tokens.size() < 2 || tokens[0] != "0") {
+    return false;
+  }
+
+  const QString &keyword = tokens[1];
+
+  if (keyword == "STEP") {
+    index.type = IndexStep;
+    return true;
+  }
+
+  if (keyword == "ROTSTEP") {
+    if (validRotStep(tokens)) {
+      index.type = IndexStep;
+      return true;
+    }
+    return false;
+  }
+
+  if (keyword == "BUFEXCHG") {
+    if (tokens.size() == 4 && tokens[2].size() == 1 &&
+        tokens[2][0] >= 'A' && tokens[2][0] <= 'Z') {
+      if (tokens[3] == "STORE") {
+        index.type = IndexBufferStore;
+        return true;
+      } else if (tokens[3] == "RETRIEVE") {
+        index.type = IndexBufferLoad;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (keyword == "MLCAD") {
+    if (tokens.size() >= 4 && tokens[2] == "BTG") {
+      index.type = IndexGroup;
+      return true;
+    }
+    return false;
+  }
+
+  if (keyword == "LDCAD" || keyword == "!LDCAD") {
+    if (tokens.size() >= 4 && tokens[2] == "GROUP_NXT" && tokens[3].startsWith("[ids=")) {
+      index.type = IndexGroup;
+      return true;
+    }
+    return false;
+  }
+
+  if (keyword == "LEOCAD" || keyword == "!LEOCAD") {
+    if (tokens.size() >= 3 && tokens[2] == "GROUP") {
+      if ((tokens.size() >= 5 && tokens[3] == "BEGIN" &&
+           tokens[4].compare("Group",Qt::CaseInsensitive) == 0) ||
+          (tokens.size() == 4 && tokens[3] == "END")) {
+        index.type = IndexGroup;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (keyword != "LPUB" && keyword != "!LPUB") {
+    return false;
+  }
+
+  QStringList argv = lpubKeywords(tokens);
+  int argc = argv.size();
+
+  if (argc < 2) {
+    return false;
+  }
+
+  const QString &branch = argv[1];
+
+  if (branch == "NOSTEP") {
+    index.type = IndexNoStep;
+  } else if (branch == "CONSOLIDATE_INSTANCE_COUNT") {
+    index.type = IndexMergeInstances;
+  } else if (branch == "INCLUDE") {
+    index.type = IndexInclude;
+  } else if (argc < 3) {
+    return false;
+  } else if (branch == "MULTI_STEP") {
+    if (argv[2] == "BEGIN") {
+      index.type = IndexStepGroupBegin;
+    } else if (argv[2] == "END") {
+      index.type = IndexStepGroupEnd;
+    } else {
+      return false;
+    }
+  } else if (branch == "CALLOUT") {
+    if (argv[2] == "BEGIN") {
+      if (argc == 3) {
+        index.calloutMode = CalloutBeginMeta::Unassembled;
+      } else if (argc == 4 && argv[3] == "ASSEMBLED") {
+        index.calloutMode = CalloutBeginMeta::Assembled;
+      } else if (argc == 4 && argv[3] == "ROTATED") {
+        index.calloutMode = CalloutBeginMeta::Rotated;
+      } else {
+        return false;
+      }
+      index.type = IndexCalloutBegin;
+    } else if (argv[2] == "END") {
+      index.type = IndexCalloutEnd;
+    } else {
+      return false;
+    }
+  } else if (branch == "INSERT") {
+    if (argc == 3 && argv[2] == "PAGE") {
+      index.type = IndexInsertPage;
+    } else if ((argc == 3 || argc == 4) && argv[2] == "COVER_PAGE") {
+      index.type = IndexInsertCoverPage;
+    } else {
+      return false;
+    }
+  } else if (branch == "PART") {
+    if (argc >= 4 && argv[2] == "BEGIN" && argv[3] == "IGN") {
+      index.type = IndexPartIgnoreBegin;
+    } else if (argv[2] == "END") {
+      index.type = IndexPartIgnoreEnd;
+    } else {
+      return false;
+    }
+  } else if (branch == "PLI") {
+    if (argc >= 4 && argv[2] == "BEGIN" && argv[3] == "IGN") {
+      index.type = IndexPliIgnoreBegin;
+    } else if (argv[2] == "END") {
+      index.type = IndexPliIgnoreEnd;
+    } else {
+      return false;
+    }
+  } else if (branch == "PAGE") {
+    if (argv[2] == "SIZE") {
+      index.type = IndexPageSize;
+    } else if (argv[2] == "ORIENTATION") {
+      index.type = IndexPageOrientation;
+    } else {
+      return false;
+    }
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/*
+ * Summarize one submodel.  This runs on worker threads so it must only
+ * touch the job it is handed - no Meta, no shared QRegExp and no gui.
+ */
+
+IndexModel PageIndex::scanModel(const IndexJob &job)
+{
+  IndexModel model;
+  model.modelName       = job.modelName;
+  model.numLines        = job.contents.size();
+  model.headerLine      = job.headerLine;
+  model.needsHeaderLine = job.needsHeaderLine;
+
+  for (int i = 0; i < job.contents.size(); i++) {
+    QString line = job.contents[i].trimmed();
+
+    if (line.isEmpty()) {
+      continue;
+    }
+
+    IndexLine index;
+    index.lineNumber = i;
+
+    if (line.indexOf("CONTINUOUS_STEP_NUMBERS") != -1) {
+      model.contStepNumbers = true;
+    }
+
+    // findPage initializes merged instances before it strips ghosts
+    if (line.indexOf("CONSOLIDATE_INSTANCE_COUNT") != -1) {
+      index.type = IndexMergeInstances;
+      model.lines.append(index);
+      continue;
+    }
+
+    if (line.startsWith("0 GHOST ")) {
+      line = line.mid(8).trimmed();
+      if (line.isEmpty()) {
+        continue;
+      }
+    }
+
+    QStringList tokens;
+
+    switch (line.at(0).toLatin1()) {
+      case '1':
+        split(line,tokens);
+        if (tokens.size() < 2) {
+          break;
+        }
+        index.type     = IndexPartLine;
+        index.colour   = tokens[1];
+        index.name     = tokens[tokens.size()-1];
+        index.mirrored = LDrawFile::mirrored(tokens);
+        model.lines.append(index);
+        break;
+      case '2':
+      case '3':
+      case '4':
+      case '5':
+        index.type = IndexGeometryLine;
+        model.lines.append(index);
+        break;
+      case '0':
+        split(line,tokens);
+        if (classifyMeta(tokens,index)) {
+          model.lines.append(index);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  return model;
+}
+
+/*
+ * Find where Gui::skipHeader would leave a model without changing it.
+ * isHeader shares its regular expressions so this stays off the workers.
+ */
+
+int PageIndex::headerLine(const QStringList &contents, bool &needsHeaderLine)
+{
+  int numLines = contents.size();
+  int lineNumber;
+
+  needsHeaderLine = false;
+
+  for (lineNumber = 0; lineNumber < numLines; lineNumber++) {
+    QString line = contents[lineNumber];
+    int p;
+    for (p = 0; p < line.size(); ++p) {
+      if (line[p] != ' ') {
+        break;
+      }
+    }
+    if (p < line.size() && line[p] >= '1' && line[p] <= '5') {
+      if (lineNumber == 0) {
+        needsHeaderLine = true;
+      } else {
+        --lineNumber;
+      }
+      break;
+    } else if ( ! isHeader(line)) {
+      if (lineNumber != 0) {
+        --lineNumber;
+        break;
+      }
+    }
+  }
+  return lineNumber;
+}
+
+int PageIndex::update(LDrawFile &ldrawFile)
+{
+  QStringList subFileOrder = ldrawFile.subFileOrder();
+
+  QHash<QString, IndexModel>::iterator it = _models.begin();
+  while (it != _models.end()) {
+    if (subFileOrder.contains(it.key(),Qt::CaseInsensitive)) {
+      ++it;
+    } else {
+      it = _models.erase(it);
+      _checkpoints.clear();
+      _structureChanged = true;
+    }
+  }
+
+  QList<IndexJob> jobs;
+
+  for (int i = 0; i < subFileOrder.size(); i++) {
+    QString modelName = subFileOrder[i].toLower();
+    bool changed = ldrawFile.changedSinceLastIndex(modelName);
+    if (changed || ! _models.contains(modelName)) {
+      IndexJob job;
+      job.modelName  = modelName;
+      job.contents   = ldrawFile.contents(modelName);
+      job.headerLine = headerLine(job.contents,job.needsHeaderLine);
+      jobs.append(job);
+    }
+  }
+
+  QList<IndexModel> models;
+  if (jobs.size() == 1) {
+    models.append(scanModel(jobs.first()));
+  } else if (jobs.size()) {
+    models = QtConcurrent::blockingMapped<QList<IndexModel> >(jobs, PageIndex::scanModel);
+  }
+
+  for (int i = 0; i < models.size(); i++) {
+    insert(models[i]);
+  }
+
+  return jobs.size();
+}
+
+IndexModel PageIndex::rescan(LDrawFile &ldrawFile, const QString &modelName)
+{
+  IndexJob job;
+  job.modelName  = modelName.toLower();
+  job.contents   = ldrawFile.contents(job.modelName);
+  job.headerLine = headerLine(job.contents,job.needsHeaderLine);
+  ldrawFile.changedSinceLastIndex(job.modelName);
+
+  IndexModel model = scanModel(job);
+  insert(model);
+  return model;
+}
+
+void PageIndex::insert(const IndexModel &model)
+{
+  QHash<QString, IndexModel>::const_iterator it = _models.constFind(model.modelName);
+  if (it == _models.constEnd() || ! it.value().sameStructure(model)) {
+    _checkpoints.clear();
+    _structureChanged = true;
+  }
+  _models.insert(model.modelName,model);
+}
+
+bool PageIndex::contStepNumbers() const
+{
+  QHash<QString, IndexModel>::const_iterator it = _models.constBegin();
+  for ( ; it != _models.constEnd(); ++it) {
+    if (it.value().contStepNumbers) {
+      return true;
+    }
+  }
+  return false;
+}
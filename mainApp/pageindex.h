@@ -0,0 +1,225 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * The page index is a tokenized summary of each submodel that keeps only
+ * the lines that decide where pages start: parts, steps, multi-steps,
+ * callouts, inserted pages, part ignore, buffer exchange, groups and page
+ * size.  Submodels are summarized independently on worker threads, and
+ * once summarized they are only summarized again after they change.
+ *
+ * When a changed submodel summarizes to the same structure as before, the
+ * edit cannot have moved a page boundary or changed an instance count, so
+ * drawPage skips LDrawFile::countInstances and findPage stops once the
+ * display page is drawn, leaving the rest of the count to the index.
+ *
+ * Gui::countPages stitches the summaries together (see Gui::indexPages in
+ * traverse.cpp) to build topOfPages and the page size table without
+ * running every meta command through Meta::parse as findPage does.
+ *
+ * Each walk also records a checkpoint for every submodel it enters: the
+ * page the submodel starts on and the page that follows it.  When findPage
+ * later reaches the same call on the same page and the display page comes
+ * after the submodel, it steps over the submodel with Gui::indexPages
+ * instead of parsing it, so drawing page N during an export no longer
+ * parses every submodel that precedes it.  The top level model and the
+ * submodels leading to the display page are still parsed for every page.
+ * The checkpoints are dropped whenever a summary changes structure.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#ifndef PAGEINDEX_H
+#define PAGEINDEX_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+class LDrawFile;
+
+enum IndexLineType {
+  IndexPartLine,          // type 1 line
+  IndexGeometryLine,      // type 2 through 5 line
+  IndexStep,              // STEP or ROTSTEP
+  IndexStepGroupBegin,
+  IndexStepGroupEnd,
+  IndexCalloutBegin,
+  IndexCalloutEnd,
+  IndexInsertCoverPage,
+  IndexInsertPage,
+  IndexPartIgnoreBegin,
+  IndexPartIgnoreEnd,
+  IndexBufferStore,
+  IndexBufferLoad,
+  IndexGroup,             // MLCad, LDCad or LeoCAD group
+  IndexNoStep,
+  IndexPageSize,          // the following are handed to Meta::parse when stitched
+  IndexPageOrientation,
+  IndexInclude,
+  IndexMergeInstances,
+  IndexPliIgnoreBegin,    // only used to tell if instance counts changed
+  IndexPliIgnoreEnd
+};
+
+class IndexLine {
+public:
+  int     type;
+  int     lineNumber;
+  int     calloutMode;     // CalloutBeginMeta::CalloutMode for callout begin
+  bool    mirrored;        // part line has a mirrored rotation matrix
+  QString colour;          // part line colour
+  QString name;            // part line type (file name)
+
+  IndexLine()
+  {
+    type        = IndexGeometryLine;
+    lineNumber  = 0;
+    calloutMode = 0;
+    mirrored    = false;
+  }
+
+  bool sameAs(const IndexLine &other) const
+  {
+    return type        == other.type        &&
+           calloutMode == other.calloutMode &&
+           mirrored    == other.mirrored    &&
+           colour      == other.colour      &&
+           name        == other.name;
+  }
+};
+
+class IndexModel {
+public:
+  QString             modelName;
+  QVector<IndexLine>  lines;
+  int                 numLines;
+  int                 headerLine;      // where skipHeader leaves the model
+  bool                needsHeaderLine; // skipHeader must insert a header line
+  bool                contStepNumbers; // mentions CONTINUOUS_STEP_NUMBERS
+
+  IndexModel()
+  {
+    numLines        = 0;
+    headerLine      = 0;
+    needsHeaderLine = false;
+    contStepNumbers = false;
+  }
+
+  /* same page boundaries and instances, line numbers aside */
+  bool sameStructure(const IndexModel &other) const
+  {
+    if (lines.size() != other.lines.size() ||
+        needsHeaderLine != other.needsHeaderLine ||
+        contStepNumbers != other.contStepNumbers) {
+      return false;
+    }
+    for (int i = 0; i < lines.size(); i++) {
+      if ( ! lines[i].sameAs(other.lines[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+class IndexJob {
+public:
+  QString     modelName;
+  QStringList contents;
+  int         headerLine;
+  bool        needsHeaderLine;
+
+  IndexJob()
+  {
+    headerLine      = 0;
+    needsHeaderLine = false;
+  }
+};
+
+class PageIndex {
+public:
+  PageIndex()
+  {
+    _structureChanged = true;
+  }
+
+  /* summarize every submodel changed since the last update */
+  int update(LDrawFile &ldrawFile);
+
+  /* summarize a single submodel now, e.g. after skipHeader changed it */
+  IndexModel rescan(LDrawFile &ldrawFile, const QString &modelName);
+
+  IndexModel model(const QString &modelName) const
+  {
+    return _models.value(modelName.toLower());
+  }
+
+  bool contains(const QString &modelName) const
+  {
+    return _models.contains(modelName.toLower());
+  }
+
+  void clear()
+  {
+    _models.clear();
+    _checkpoints.clear();
+    _structureChanged = true;
+  }
+
+  /* true if any submodel mentions continuous step numbers */
+  bool contStepNumbers() const;
+
+  /* page following the submodel called from the given line on startPage, or 0 */
+  int submodelEndPage(const QString &modelName, int lineNumber, int startPage) const
+  {
+    return _checkpoints.value(checkpointKey(modelName,lineNumber,startPage));
+  }
+
+  void setSubmodelEndPage(const QString &modelName, int lineNumber, int startPage, int endPage)
+  {
+    _checkpoints.insert(checkpointKey(modelName,lineNumber,startPage),endPage);
+  }
+
+  /* true if any summary changed structure since the last call */
+  bool structureChanged()
+  {
+    bool value = _structureChanged;
+    _structureChanged = false;
+    return value;
+  }
+
+  static IndexModel scanModel(const IndexJob &job);
+
+private:
+  static int headerLine(const QStringList &contents, bool &needsHeaderLine);
+  void insert(const IndexModel &model);
+
+  static QString checkpointKey(const QString &modelName, int lineNumber, int startPage)
+  {
+    return QString("%1|%2|%3").arg(modelName.toLower()).arg(lineNumber).arg(startPage);
+  }
+
+  QHash<QString, IndexModel> _models;
+  QHash<QString, int>        _checkpoints;     // submodel end page by call line and start page
+  bool                       _structureChanged;
+};
+
+#endif // PAGEINDEX_H
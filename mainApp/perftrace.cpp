@@ -0,0 +1,221 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * This file records and writes the performance trace described in
+ * perftrace.h.  Each event is written as a complete ("X") event:
+ *
+ *   {"name":"drawPage","cat":"page","ph":"X","ts":1200,"dur":350,
+ *    "pid":1,"tid":0,"args":{"detail":"main.ldr","number":3}}
+ *
+ * with times in microseconds, and each thread gets a thread_name
+ * metadata event.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#include <QDir>
+#include <QFileInfo>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+#include <QCoreApplication>
+
+#include "perftrace.h"
+
+bool          PerfTrace::_enabled = false;
+QString       PerfTrace::_fileName;
+QElapsedTimer PerfTrace::_clock;
+
+struct PerfEvent {
+  const char *category;
+  const char *name;
+  qint64      start;
+  qint64      duration;
+  QString     detail;
+  int         number;
+};
+
+/*
+ * The events of one thread.  Only that thread appends, so the buffer
+ * lock is only contended while the trace is being written.
+ */
+
+struct PerfBuffer {
+  QMutex             mutex;
+  int                tid;
+  QString            thread;
+  QVector<PerfEvent> events;
+};
+
+static QMutex               perfMutex;
+static QVector<PerfBuffer*> perfBuffers;   // live for the whole run
+
+static PerfBuffer *threadBuffer()
+{
+  static thread_local PerfBuffer *buffer = nullptr;
+  if ( ! buffer) {
+    buffer = new PerfBuffer;
+    bool main = QCoreApplication::instance() &&
+                QThread::currentThread() == QCoreApplication::instance()->thread();
+    QMutexLocker locker(&perfMutex);
+    buffer->tid    = perfBuffers.size();
+    buffer->thread = main ? QString("main") : QString("worker %1").arg(buffer->tid);
+    buffer->events.reserve(1024);
+    perfBuffers.append(buffer);
+  }
+  return buffer;
+}
+
+static QByteArray escaped(const QString &string)
+{
+  QByteArray out;
+  QByteArray utf8 = string.toUtf8();
+  out.reserve(utf8.size() + 2);
+  for (char c : utf8) {
+    switch (c) {
+      case '"':  out += "\\\""; break;
+      case '\\': out += "\\\\"; break;
+      case '\n': out += "\\n";  break;
+      case '\r': out += "\\r";  break;
+      case '\t': out += "\\t";  break;
+      default:
+        if (uchar(c) < 0x20) {
+          out += QString("\\u%1").arg(int(c),4,16,QChar('0')).toLatin1();
+        } else {
+          out += c;
+        }
+        break;
+    }
+  }
+  return out;
+}
+
+void PerfTrace::start(const QString &fileName)
+{
+  _fileName = fileName;
+  _clock.start();
+  _enabled  = true;
+}
+
+void PerfTrace::record(
+  const char    *category,
+  const char    *name,
+  qint64         start,
+  qint64         duration,
+  const QString &detail,
+  int            number)
+{
+  PerfBuffer *buffer = threadBuffer();
+
+  PerfEvent event;
+  event.category = category;
+  event.name     = name;
+  event.start    = start;
+  event.duration = duration;
+  event.detail   = detail;
+  event.number   = number;
+
+  QMutexLocker locker(&buffer->mutex);
+  buffer->events.append(event);
+}
+
+QMap<QString, PerfStage> PerfTrace::stages(qint64 since)
+{
+  QMap<QString, PerfStage> stages;
+
+  QMutexLocker locker(&perfMutex);
+  for (PerfBuffer *buffer : perfBuffers) {
+    QMutexLocker bufferLocker(&buffer->mutex);
+    for (const PerfEvent &event : buffer->events) {
+      if (event.start < since) {
+        continue;
+      }
+      QMap<QString, PerfStage>::iterator it = stages.find(QLatin1String(event.name));
+      if (it == stages.end()) {
+        PerfStage stage = { 0, 0, 0 };
+        it = stages.insert(QLatin1String(event.name), stage);
+      }
+      it.value().count++;
+      it.value().total  += event.duration;
+      it.value().longest = qMax(it.value().longest, event.duration);
+    }
+  }
+  return stages;
+}
+
+bool PerfTrace::write()
+{
+  if ( ! _enabled || _fileName.isEmpty()) {
+    return false;
+  }
+
+  QDir().mkpath(QFileInfo(_fileName).absolutePath());
+
+  QSaveFile file(_fileName);
+  if ( ! file.open(QIODevice::WriteOnly)) {
+    return false;
+  }
+
+  file.write("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+  QMutexLocker locker(&perfMutex);
+  bool first = true;
+  for (PerfBuffer *buffer : perfBuffers) {
+    QMutexLocker bufferLocker(&buffer->mutex);
+
+    QByteArray line = first ? QByteArray() : QByteArray(",\n");
+    line += QString("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%1,"
+                    "\"args\":{\"name\":\"%2\"}}")
+                    .arg(buffer->tid).arg(buffer->thread).toUtf8();
+    file.write(line);
+    first = false;
+
+    for (const PerfEvent &event : buffer->events) {
+      line  = ",\n{\"name\":\"";
+      line += event.name;
+      line += "\",\"cat\":\"";
+      line += event.category;
+      line += "\",\"ph\":\"X\",\"ts\":";
+      line += QByteArray::number(event.start);
+      line += ",\"dur\":";
+      line += QByteArray::number(event.duration);
+      line += ",\"pid\":1,\"tid\":";
+      line += QByteArray::number(buffer->tid);
+      if ( ! event.detail.isEmpty() || event.number >= 0) {
+        line += ",\"args\":{";
+        if ( ! event.detail.isEmpty()) {
+          line += "\"detail\":\"" + escaped(event.detail) + "\"";
+        }
+        if (event.number >= 0) {
+          line += event.detail.isEmpty() ? "" : ",";
+          line += "\"number\":" + QByteArray::number(event.number);
+        }
+        line += "}";
+      }
+      line += "}";
+      file.write(line);
+    }
+  }
+
+  file.write("\n]}\n");
+  return file.commit();
+}
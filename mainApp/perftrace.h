@@ -0,0 +1,125 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * The performance trace records how long each stage of page generation
+ * takes - findPage, drawPage, writeToTmp, Step::createCsi, Pli::partSize,
+ * each renderer's renderCsi and renderPli, addGraphicsPageItems and the
+ * export image encoding.  A PerfSpan placed at the top of a function
+ * records one complete event when the function returns, with the model,
+ * step or file it worked on as the event detail.
+ *
+ * Events are kept in a buffer per thread, so recording takes no shared
+ * lock, and when the trace is off a span costs a single flag test.  At
+ * the end of the run the events are written in the Chrome trace event
+ * format, which chrome://tracing and Perfetto open directly.
+ *
+ * The trace is turned on by the PerformanceTrace logging setting or with
+ * --performance-trace on the command line.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#ifndef PERFTRACE_H
+#define PERFTRACE_H
+
+#include <QString>
+#include <QMap>
+#include <QElapsedTimer>
+
+struct PerfStage {
+  int    count;
+  qint64 total;     // microseconds
+  qint64 longest;   // microseconds
+};
+
+class PerfTrace {
+public:
+  /* turn the trace on, writing to fileName when the run ends */
+  static void start(const QString &fileName);
+
+  /* write the events recorded so far, false if the file failed */
+  static bool write();
+
+  /* count and time of each event name begun at or after since */
+  static QMap<QString, PerfStage> stages(qint64 since = 0);
+
+  static bool enabled()
+  {
+    return _enabled;
+  }
+
+  static QString fileName()
+  {
+    return _fileName;
+  }
+
+  /* microseconds since start */
+  static qint64 now()
+  {
+    return _clock.nsecsElapsed() / 1000;
+  }
+
+  static void record(
+    const char    *category,
+    const char    *name,
+    qint64         start,
+    qint64         duration,
+    const QString &detail,
+    int            number);
+
+private:
+  static bool          _enabled;
+  static QString       _fileName;
+  static QElapsedTimer _clock;
+};
+
+class PerfSpan {
+public:
+  PerfSpan(
+    const char    *category,
+    const char    *name,
+    const QString &detail = QString(),
+    int            number = -1)
+  {
+    _start = -1;
+    if (PerfTrace::enabled()) {
+      _category = category;
+      _name     = name;
+      _detail   = detail;
+      _number   = number;
+      _start    = PerfTrace::now();
+    }
+  }
+  ~PerfSpan()
+  {
+    if (_start >= 0) {
+      PerfTrace::record(_category, _name, _start, PerfTrace::now() - _start, _detail, _number);
+    }
+  }
+
+private:
+  const char *_category;
+  const char *_name;
+  QString     _detail;
+  int         _number;
+  qint64      _start;     // microseconds, -1 when the trace is off
+};
+
+#endif // PERFTRACE_H
@@ -33,6 +33,7 @@
 #include <QDir>
 #include <QFileInfo>
 #include <QFile>
+#include <QSet>
 #include <QTextStream>
 
 #include "pli.h"
@@ -55,6 +56,7 @@
 #include "lc_category.h"
 #include "lc_library.h"
 #include "pieceinf.h"
+#include "perftrace.h"
 
 QCache<QString,QString> Pli::orientation;
 
@@ -798,6 +800,9 @@ int Pli::createSubModelIcons() // NOT USED - Moved to SubModelItem class
             emit gui->progressPermRangeSig(1, gui->fileList().size());
           }
 
+        // POV-Ray renders the icons side by side when the loop is done
+        povrayScheduler.begin();
+
         for (int i = 0; i < gui->fileList().size(); i++) {
 
             if (Preferences::modeGUI && ! gui->exporting())
@@ -813,6 +818,11 @@ int Pli::createSubModelIcons() // NOT USED - Moved to SubModelItem class
                 emit gui->messageSig(LOG_ERROR, QString("Failed to create submodel icon for key %1").arg(key));
             }
         }
+
+        if (povrayScheduler.end() != 0) {
+            emit gui->messageSig(LOG_ERROR, QString("Failed to create submodel icons"));
+            rc = -1;
+        }
         if (Preferences::modeGUI && ! gui->exporting()) {
           emit gui->progressPermSetValueSig(gui->fileList().size());
         }
@@ -874,7 +884,8 @@ int Pli::createPartImage(
         // assemble image name using nameKey - create unique file when a value that impacts the image changes
         QString imageDir = isSubModel ? Paths::submodelDir : Paths::partsDir;
         imageName = QDir::currentPath() + QDir::separator() + imageDir + QDir::separator() + nameKey + ptn[pT].typeName + ".png";
-        ldrNames  = QStringList() << QDir::currentPath() + QDir::separator() + Paths::tmpDir + QDir::separator() + "pli.ldr";
+        RenderJob job;
+        ldrNames  = QStringList() << job.scratchFile("pli.ldr");
 
         QFile part(imageName);
 
@@ -1725,6 +1736,8 @@ void Pli::getRightEdge(
 
 void Pli::sortParts(QHash<QString, PliPart *> &parts, bool setSplit)
 {
+    PerfSpan perfSpan("pli", "Pli::sortParts", QString(), parts.size());
+
     // initialize
     bool ascending = true;
     bool unsorted = true;
@@ -1865,6 +1878,8 @@ int Pli::sortPli()
 
 int Pli::partSize()
 {
+    PerfSpan perfSpan("pli", "Pli::partSize");
+
     isSubModel = false; // not sizing icon images
 
     if (renderer->useLDViewSCall()) {
@@ -1877,6 +1892,36 @@ int Pli::partSize()
       widestPart = 0;
       tallestPart = 0;
 
+      /* Queue every missing POV-Ray part image first so they render side by
+         side, the loop below then loads the images these parts left in
+         place instead of creating them again. */
+
+      QSet<QString> rendered;
+
+      if (Render::getRenderer() == RENDERER_POVRAY) {
+          povrayScheduler.begin();
+          foreach(key,parts.keys()) {
+              PliPart *part = parts[key];
+              QFileInfo info(part->type);
+              PieceInfo* pieceInfo = lcGetPiecesLibrary()->FindPiece(info.fileName().toUpper().toLatin1().constData(), nullptr, false, false);
+
+              if (pieceInfo ||
+                  gui->isUnofficialPart(part->type) ||
+                  gui->isSubmodel(part->type)) {
+
+                  QString color = part->color == "16" ? "0" : part->color;
+
+                  if (createPartImage(part->nameKey,part->type,color,nullptr,part->subType) == 0) {
+                      rendered << key;
+                  }
+              }
+          }
+          if (povrayScheduler.end() != 0) {
+              emit gui->messageSig(LOG_ERROR, QMessageBox::tr("Failed to create PLI part images"));
+              return -1;
+          }
+      }
+
       foreach(key,parts.keys()) {
           PliPart *part;
 
@@ -1898,7 +1943,14 @@ int Pli::partSize()
                   return -1;
                 }
 
-              if (createPartImage(part->nameKey,part->type,part->color,pixmap,part->subType)) {
+              if (rendered.contains(key)) {
+                  if ( ! pixmap->load(part->imageName)) {
+                      emit gui->messageSig(LOG_ERROR,QMessageBox::tr("Cannot load PLI pixmap image %1 is not a file.")
+                                           .arg(part->imageName));
+                      delete pixmap;
+                      return -1;
+                  }
+              } else if (createPartImage(part->nameKey,part->type,part->color,pixmap,part->subType)) {
                   emit gui->messageSig(LOG_ERROR, QMessageBox::tr("Failed to create PLI part for key %1")
                                        .arg(key));
                   return -1;
@@ -49,6 +49,7 @@
 #include "name.h"
 #include "resize.h"
 #include "annotations.h"
+#include "render.h"
 
 #include "QsLog.h"
 
@@ -162,6 +163,7 @@ class Pli : public Placement {
     QHash<QString, PliPart*> parts;
     QList<QString>           sortedKeys;
     Annotations              annotations;        // this is an internal list of title and custom part annotations
+    POVRayScheduler          povrayScheduler;    // POV-Ray part images rendered side by side
 
     int pageSizeP(Meta *, int which);
 
@@ -34,6 +34,8 @@
 #include "paths.h"
 #include "lpub.h"
 #include "messageboxresizable.h"
+#include "pageimagewriter.h"
+#include "perftrace.h"
 #include <TCFoundation/TCUserDefaults.h>
 #include <LDLib/LDUserDefaultsKeys.h>
 
@@ -1022,6 +1024,8 @@ void Gui::exportAsPdf()
 
 void Gui::exportAs(const QString &_suffix)
 {
+  PerfSpan perfSpan("export", "exportAs", _suffix);
+
   QString suffix = _suffix;
   QString directoryName = QDir::currentPath();
 
@@ -1105,6 +1109,9 @@ void Gui::exportAs(const QString &_suffix)
       m_progressDialog->show();
   m_progressDlgMessageLbl->setText(QString("Exporting instructions to %1 %2.").arg(suffix).arg(type));
 
+  // encode page images on worker threads while the next page is drawn
+  PageImageWriter imageWriter;
+
   if (processOption != EXPORT_PAGE_RANGE){
 
       if(processOption == EXPORT_ALL_PAGES){
@@ -1126,6 +1133,7 @@ void Gui::exportAs(const QString &_suffix)
                   m_progressDialog->hide();
               displayPageNum = savePageNumber;
               drawPage(KpageView,KpageScene,false);
+              imageWriter.finish();
               emit messageSig(LOG_STATUS,QString("Export terminated before completion."));
               return;
             }
@@ -1187,9 +1195,8 @@ void Gui::exportAs(const QString &_suffix)
               // save the image to the selected directory
               // internationalization of "_page_"?
               QString pn = QString("%1") .arg(displayPageNum);
-              image.save( QDir::toNativeSeparators(directoryName + "/" + baseName + "_page_" + pn + suffix));
-
               painter.end();
+              imageWriter.write(image, QDir::toNativeSeparators(directoryName + "/" + baseName + "_page_" + pn + suffix));
           }
       }
       m_progressDlgProgressBar->setValue(_maxPages);
@@ -1224,6 +1231,7 @@ void Gui::exportAs(const QString &_suffix)
                   m_progressDialog->hide();
               displayPageNum = savePageNumber;
               drawPage(KpageView,KpageScene,false);
+              imageWriter.finish();
               emit messageSig(LOG_STATUS,QString("Export terminated before completion."));
               return;
           }
@@ -1290,14 +1298,21 @@ void Gui::exportAs(const QString &_suffix)
               // save the image to the selected directory
               // internationalization of "_page_"?
               QString pn = QString("%1") .arg(displayPageNum);
-              image.save( QDir::toNativeSeparators(directoryName + "/" + baseName + "_page_" + pn + suffix));
-
               painter.end();
+              imageWriter.write(image, QDir::toNativeSeparators(directoryName + "/" + baseName + "_page_" + pn + suffix));
           }
       }
       m_progressDlgProgressBar->setValue(printPages.count());
     }
 
+  // wait for the last page images to be written
+  if (! imageWriter.finish()) {
+      emit messageSig(LOG_ERROR,QString("Failed to write %1 exported %2:<br>%3")
+                      .arg(imageWriter.failures().size())
+                      .arg(type)
+                      .arg(imageWriter.failures().join("<br>")));
+  }
+
   // hide progress bar
   if (Preferences::modeGUI)
       m_progressDialog->hide();
@@ -55,6 +55,8 @@
 #include "lc_qhtmldialog.h"
 #include "view.h"
 #include "lc_partselectionwidget.h"
+#include "lc_glextensions.h"
+#include "perftrace.h"
 
 #ifdef Q_OS_WIN
 #include <Windows.h>
@@ -335,6 +337,272 @@ bool Render::difference(const float &v1, const float &v2) {
     return (v1 > v2 || v1 < v2);
 }
 
+/*
+ * Render jobs
+ */
+
+static QAtomicInt renderJobId;
+static QMutex     renderLogMutex;
+
+RenderJob::RenderJob()
+{
+  _id = renderJobId.fetchAndAddOrdered(1) + 1;
+}
+
+RenderJob::~RenderJob()
+{
+  for (int i = 0; i < _scratchFiles.size(); i++) {
+    QFile::remove(_scratchFiles[i]);
+  }
+}
+
+/* csi.ldr becomes <temp dir>/csi_<job id>.ldr, csi.ldr.pov csi_<job id>.ldr.pov */
+
+QString RenderJob::scratchFile(const QString &fileName)
+{
+  int dot = fileName.indexOf('.');
+  QString name = dot < 0 ? QString("%1_%2").arg(fileName).arg(_id) :
+                           QString("%1_%2%3").arg(fileName.left(dot)).arg(_id).arg(fileName.mid(dot));
+  QString scratchFile = QDir::currentPath() + "/" + Paths::tmpDir + "/" + name;
+  if ( ! _scratchFiles.contains(scratchFile)) {
+    _scratchFiles << scratchFile;
+  }
+  return scratchFile;
+}
+
+/*
+ * Write what the process printed to stdout-<logName> and stderr-<logName>
+ * one job at a time, and hand it back for error messages.
+ */
+
+QString RenderJob::saveLogs(QProcess &process, const QString &logName)
+{
+  QByteArray standardOutput = process.readAllStandardOutput();
+  QByteArray standardError  = process.readAllStandardError();
+
+  QMutexLocker locker(&renderLogMutex);
+
+  QFile stdOutLog(QDir::currentPath() + "/stdout-" + logName);
+  if (stdOutLog.open(QIODevice::WriteOnly)) {
+    stdOutLog.write(standardOutput);
+    stdOutLog.close();
+  }
+  QFile stdErrLog(QDir::currentPath() + "/stderr-" + logName);
+  if (stdErrLog.open(QIODevice::WriteOnly)) {
+    stdErrLog.write(standardError);
+    stdErrLog.close();
+  }
+
+  QString output;
+  output.append(standardError);
+  output.append(standardOutput);
+  return output;
+}
+
+/*
+ * POV-Ray render scheduler - see render.h.  Only the gui thread queues
+ * and runs jobs, the concurrency is in the POV-Ray processes.
+ */
+
+POVRayScheduler *POVRayScheduler::current = nullptr;
+int              POVRayScheduler::maxJobs = 0;
+
+POVRayScheduler::POVRayScheduler()
+{
+  depth = 0;
+  outer = nullptr;
+}
+
+POVRayScheduler::~POVRayScheduler()
+{
+  // a batch left open drops its queue and stops taking renders
+  if (depth > 0 && current == this) {
+    current = outer;
+  }
+}
+
+void POVRayScheduler::begin()
+{
+  if (depth++ == 0) {
+    outer   = current;
+    current = this;
+  }
+}
+
+int POVRayScheduler::end()
+{
+  if (depth == 0 || --depth > 0) {
+    return 0;
+  }
+
+  if (current == this) {
+    current = outer;
+  }
+  outer = nullptr;
+
+  QList<POVRayJob> jobs = queue;
+  queue.clear();
+
+  return jobs.size() ? run(jobs) : 0;
+}
+
+int POVRayScheduler::render(POVRayJob &job)
+{
+  if (current) {
+    current->queue.append(job);
+    return 0;
+  }
+
+  QList<POVRayJob> jobs;
+  jobs.append(job);
+
+  return run(jobs);
+}
+
+qint64 POVRayScheduler::cost(int parts, int width, int height)
+{
+  return qint64(qMax(parts,1)) * qMax(width,1) * qMax(height,1);
+}
+
+int POVRayScheduler::partCount(const QString &ldrName)
+{
+  QFile ldrFile(ldrName);
+  if ( ! ldrFile.open(QIODevice::ReadOnly)) {
+    return 1;
+  }
+
+  int parts = 0;
+  while ( ! ldrFile.atEnd()) {
+    QByteArray line = ldrFile.readLine().trimmed();
+    if (line.startsWith('1')) {
+      parts++;
+    }
+  }
+  return parts;
+}
+
+int POVRayScheduler::run(QList<POVRayJob> &jobs)
+{
+  int cores   = qMax(QThread::idealThreadCount(),1);
+  int timeout = Render::rendererTimeout();
+  int rc      = 0;
+
+  qint64 totalCost = 0;
+  for (int i = 0; i < jobs.size(); i++) {
+    totalCost += jobs[i].cost;
+  }
+  for (int i = 0; i < jobs.size(); i++) {
+    jobs[i].threads = qBound(1, int(qRound64(double(cores) * jobs[i].cost / totalCost)), cores);
+  }
+
+  // largest first, smaller jobs fill the cores left over
+  QList<int> pending, running;
+  for (int i = 0; i < jobs.size(); i++) {
+    pending << i;
+  }
+  std::sort(pending.begin(),pending.end(),[&jobs](int a, int b) {
+    return jobs[a].cost > jobs[b].cost;
+  });
+
+  QStringList povEnv = QProcess::systemEnvironment();
+  povEnv.prepend("POV_IGNORE_SYSCONF_MSG=1");
+
+  QVector<QProcess *>    processes(jobs.size(),nullptr);
+  QVector<QElapsedTimer> jobTimers(jobs.size());
+  QElapsedTimer          batchTimer;
+  qint64                 threadTime  = 0;
+  int                    freeThreads = cores;
+
+  batchTimer.start();
+
+  while (pending.size() || running.size()) {
+
+    for (int p = 0; p < pending.size(); ) {
+      int i = pending[p];
+      if (running.size() && (jobs[i].threads > freeThreads ||
+                             (maxJobs > 0 && running.size() >= maxJobs))) {
+        p++;
+        continue;
+      }
+
+      QStringList povArguments = jobs[i].arguments;
+      povArguments << QString("+WT%1").arg(jobs[i].threads);
+
+      emit gui->messageSig(LOG_STATUS, QString("Executing POVRay render %1 - please wait...").arg(jobs[i].name));
+
+      QString message = QString("POVRay %1 Arguments: %2 %3").arg(jobs[i].name).arg(Preferences::povrayExe).arg(povArguments.join(" "));
+#ifdef QT_DEBUG_MODE
+      qDebug() << qPrintable(message);
+#else
+      emit gui->messageSig(LOG_INFO, message);
+#endif
+
+      QProcess *povray = new QProcess;
+      povray->setEnvironment(povEnv);
+      povray->setWorkingDirectory(jobs[i].workingDirectory); // pov win console app will not write to dir different from cwd or source file dir
+      povray->start(Preferences::povrayExe,povArguments);
+
+      processes[i] = povray;
+      jobTimers[i].start();
+      freeThreads -= jobs[i].threads;
+      running << i;
+      pending.removeAt(p);
+    }
+
+    // poll each process in turn so none of them stalls on a full pipe
+    int waitTime = qMax(10, 100 / running.size());
+
+    for (int r = 0; r < running.size(); ) {
+      int i = running[r];
+      QProcess *povray = processes[i];
+
+      bool finished = povray->state() == QProcess::NotRunning || povray->waitForFinished(waitTime);
+      bool timedOut = ! finished && timeout != -1 && jobTimers[i].elapsed() > timeout;
+      if ( ! finished && ! timedOut) {
+        r++;
+        continue;
+      }
+
+      if (timedOut) {
+        povray->kill();
+        povray->waitForFinished();
+      }
+
+      threadTime += jobTimers[i].elapsed() * jobs[i].threads;
+
+      QString str = jobs[i].job->saveLogs(*povray,"povray");
+      if (timedOut) {
+        emit gui->messageSig(LOG_ERROR,QMessageBox::tr("POVRay %1 render timed out after %2 seconds for %3\n%4")
+                             .arg(jobs[i].name).arg(timeout / 1000).arg(jobs[i].pngName).arg(str));
+        rc = -1;
+      } else if (povray->exitStatus() != QProcess::NormalExit || povray->exitCode() != 0) {
+        emit gui->messageSig(LOG_ERROR,QMessageBox::tr("POVRay %1 render failed with code %2\n%3")
+                             .arg(jobs[i].name).arg(povray->exitCode()).arg(str));
+        rc = -1;
+      } else if ( ! Render::clipImage(jobs[i].pngName)) {
+        rc = -1;
+      }
+
+      delete povray;
+      processes[i] = nullptr;
+      freeThreads += jobs[i].threads;
+      running.removeAt(r);
+    }
+  }
+
+  qint64 batchTime = qMax(batchTimer.elapsed(),qint64(1));
+  if (jobs.size() > 1) {
+    emit gui->messageSig(LOG_INFO, QString("POVRay rendered %1 images in %2 milliseconds "
+                                           "using %3 cores at %4% utilization.")
+                                           .arg(jobs.size())
+                                           .arg(batchTime)
+                                           .arg(cores)
+                                           .arg(int(100 * threadTime / (cores * batchTime))));
+  }
+
+  return rc;
+}
+
 int Render::executeLDViewProcess(QStringList &arguments, Mt module) {
 
   QString message = QString("LDView %1 %2 Arguments: %3 %4")
@@ -348,18 +616,17 @@ int Render::executeLDViewProcess(QStringList &arguments, Mt module) {
   emit gui->messageSig(LOG_INFO, message);
 #endif
 
+  RenderJob job;
+
   QProcess ldview;
   ldview.setEnvironment(QProcess::systemEnvironment());
   ldview.setWorkingDirectory(QDir::currentPath() + "/" + Paths::tmpDir);
-  ldview.setStandardErrorFile(QDir::currentPath() + "/stderr-ldview");
-  ldview.setStandardOutputFile(QDir::currentPath() + "/stdout-ldview");
 
   ldview.start(Preferences::ldviewExe,arguments);
-  if ( ! ldview.waitForFinished(rendererTimeout())) {
+  bool finished = ldview.waitForFinished(rendererTimeout());
+  QString str = job.saveLogs(ldview,"ldview");
+  if ( ! finished) {
       if (ldview.exitCode() != 0 || 1) {
-          QByteArray status = ldview.readAll();
-          QString str;
-          str.append(status);
           emit gui->messageSig(LOG_ERROR,QMessageBox::tr("LDView %1 %2 render failed with code %2 %3")
                                .arg(useLDViewSCall() ? "(SingleCall)" : "(Native)")
                                .arg(module == CSI ? "CSI" : "PLI")
@@ -407,12 +674,15 @@ int POVRay::renderCsi(
     const QString     &pngName,
     Meta              &meta)
 {
+  PerfSpan perfSpan("render", "POVRay::renderCsi", pngName);
 
   Q_UNUSED(csiKeys)
 
+  QSharedPointer<RenderJob> job(new RenderJob);
+
   /* Create the CSI DAT file */
-  QString ldrName = QDir::currentPath() + "/" + Paths::tmpDir + "/csi.ldr";
-  QString povName = ldrName + ".pov";
+  QString ldrName = job->scratchFile("csi.ldr");
+  QString povName = job->scratchFile("csi.ldr.pov");
   QStringList list;
   QString message;
 
@@ -487,8 +757,6 @@ int POVRay::renderCsi(
       QProcess    ldview;
       ldview.setEnvironment(QProcess::systemEnvironment());
       ldview.setWorkingDirectory(QDir::currentPath() + "/" + Paths::tmpDir);
-      ldview.setStandardErrorFile(QDir::currentPath() + "/stderr-ldviewpov");
-      ldview.setStandardOutputFile(QDir::currentPath() + "/stdout-ldviewpov");
 
       message = QString("LDView POV file generate CSI Arguments: %1 %2").arg(Preferences::ldviewExe).arg(arguments.join(" "));
 #ifdef QT_DEBUG_MODE
@@ -498,11 +766,10 @@ int POVRay::renderCsi(
 #endif
 
       ldview.start(Preferences::ldviewExe,arguments);
-      if ( ! ldview.waitForFinished(rendererTimeout())) {
+      bool finished = ldview.waitForFinished(rendererTimeout());
+      QString str = job->saveLogs(ldview,"ldviewpov");
+      if ( ! finished) {
           if (ldview.exitCode() != 0 || 1) {
-              QByteArray status = ldview.readAll();
-              QString str;
-              str.append(status);
               emit gui->messageSig(LOG_ERROR,QMessageBox::tr("LDView POV file generation failed with exit code %1\n%2") .arg(ldview.exitCode()) .arg(str));
               return -1;
           }
@@ -582,38 +849,15 @@ int POVRay::renderCsi(
 //  povArguments << "/EXIT";
 //#endif
 
-  emit gui->messageSig(LOG_STATUS, "Executing POVRay render CSI - please wait...");
-
-  QProcess povray;
-  QStringList povEnv = QProcess::systemEnvironment();
-  povEnv.prepend("POV_IGNORE_SYSCONF_MSG=1");
-  povray.setEnvironment(povEnv);
-  povray.setWorkingDirectory(QDir::currentPath()+ "/" + Paths::assemDir); // pov win console app will not write to dir different from cwd or source file dir
-  povray.setStandardErrorFile(QDir::currentPath() + "/stderr-povray");
-  povray.setStandardOutputFile(QDir::currentPath() + "/stdout-povray");
-
-  message = QString("POVRay CSI Arguments: %1 %2").arg(Preferences::povrayExe).arg(povArguments.join(" "));
-#ifdef QT_DEBUG_MODE
-  qDebug() << qPrintable(message);
-#else
-  emit gui->messageSig(LOG_INFO, message);
-#endif
-
-  povray.start(Preferences::povrayExe,povArguments);
-  if ( ! povray.waitForFinished(rendererTimeout())) {
-      if (povray.exitCode() != 0) {
-          QByteArray status = povray.readAll();
-          QString str;
-          str.append(status);
-          emit gui->messageSig(LOG_ERROR,QMessageBox::tr("POVRay CSI render failed with code %1\n%2").arg(povray.exitCode()) .arg(str));
-          return -1;
-        }
-    }
+  POVRayJob povJob;
+  povJob.name             = "CSI";
+  povJob.arguments        = povArguments;
+  povJob.workingDirectory = QDir::currentPath() + "/" + Paths::assemDir;
+  povJob.pngName          = pngName;
+  povJob.cost             = POVRayScheduler::cost(csiParts.size(),width,height);
+  povJob.job              = job;
 
-  if (clipImage(pngName))
-    return 0;
-  else
-    return -1;
+  return POVRayScheduler::render(povJob);
 }
 
 int POVRay::renderPli(
@@ -623,13 +867,17 @@ int POVRay::renderPli(
     int                pliType,
     int                sub)
 {
+  PerfSpan perfSpan("render", "POVRay::renderPli", pngName);
+
   // Select meta type
   PliMeta &metaType = pliType == SUBMODEL ? static_cast<PliMeta&>(meta.LPub.subModel) :
                       pliType == BOM ? meta.LPub.bom : meta.LPub.pli;
 
+  QSharedPointer<RenderJob> job(new RenderJob);
+
   QStringList list;
   QString message;
-  QString povName = ldrNames.first() +".pov";
+  QString povName = job->scratchFile("pli.ldr.pov");
 
   // Populate render attributes
   QString transform  = metaType.rotStep.value().type;
@@ -715,8 +963,6 @@ int POVRay::renderPli(
       QProcess    ldview;
       ldview.setEnvironment(QProcess::systemEnvironment());
       ldview.setWorkingDirectory(QDir::currentPath());
-      ldview.setStandardErrorFile(QDir::currentPath() + "/stderr-ldviewpov");
-      ldview.setStandardOutputFile(QDir::currentPath() + "/stdout-ldviewpov");
 
       message = QString("LDView POV file generate PLI Arguments: %1 %2").arg(Preferences::ldviewExe).arg(arguments.join(" "));
 #ifdef QT_DEBUG_MODE
@@ -726,11 +972,10 @@ int POVRay::renderPli(
 #endif
 
       ldview.start(Preferences::ldviewExe,arguments);
-      if ( ! ldview.waitForFinished()) {
+      bool finished = ldview.waitForFinished();
+      QString str = job->saveLogs(ldview,"ldviewpov");
+      if ( ! finished) {
           if (ldview.exitCode() != 0) {
-              QByteArray status = ldview.readAll();
-              QString str;
-              str.append(status);
               emit gui->messageSig(LOG_ERROR,QMessageBox::tr("LDView POV file generation failed with exit code %1\n%2") .arg(ldview.exitCode()) .arg(str));
               return -1;
           }
@@ -810,39 +1055,17 @@ int POVRay::renderPli(
 //  povArguments << "/EXIT";
 //#endif
 
-  emit gui->messageSig(LOG_STATUS, "Executing POVRay render PLI - please wait...");
-
-  QProcess povray;
-  QStringList povEnv = QProcess::systemEnvironment();
-  povEnv.prepend("POV_IGNORE_SYSCONF_MSG=1");
   QString workingDirectory = pliType == SUBMODEL ? Paths::submodelDir : Paths::partsDir;
-  povray.setEnvironment(povEnv);
-  povray.setWorkingDirectory(QDir::currentPath()+ "/" + workingDirectory); // pov win console app will not write to dir different from cwd or source file dir
-  povray.setStandardErrorFile(QDir::currentPath() + "/stderr-povray");
-  povray.setStandardOutputFile(QDir::currentPath() + "/stdout-povray");
 
-  message = QString("POVRay PLI Arguments: %1 %2").arg(Preferences::povrayExe).arg(povArguments.join(" "));
-#ifdef QT_DEBUG_MODE
-  qDebug() << qPrintable(message);
-#else
-  emit gui->messageSig(LOG_INFO, message);
-#endif
+  POVRayJob povJob;
+  povJob.name             = "PLI";
+  povJob.arguments        = povArguments;
+  povJob.workingDirectory = QDir::currentPath() + "/" + workingDirectory;
+  povJob.pngName          = pngName;
+  povJob.cost             = POVRayScheduler::cost(POVRayScheduler::partCount(ldrNames.first()),width,height);
+  povJob.job              = job;
 
-  povray.start(Preferences::povrayExe, povArguments);
-  if ( ! povray.waitForFinished(rendererTimeout())) {
-      if (povray.exitCode() != 0) {
-          QByteArray status = povray.readAll();
-          QString str;
-          str.append(status);
-          emit gui->messageSig(LOG_ERROR,QMessageBox::tr("POVRay PLI render failed with code %1\n%2") .arg(povray.exitCode()) .arg(str));
-          return -1;
-      }
-  }
-
-  if (clipImage(pngName))
-    return 0;
-  else
-    return -1;
+  return POVRayScheduler::render(povJob);
 }
 
 
@@ -866,12 +1089,14 @@ int LDGLite::renderCsi(
   const QString     &pngName,
         Meta        &meta)
 {
+  PerfSpan perfSpan("render", "LDGLite::renderCsi", pngName);
+
+  RenderJob job;
+
   /* Create the CSI DAT file */
-  QString ldrPath, ldrName, ldrFile;
+  QString ldrFile;
   int rc;
-  ldrName = "csi.ldr";
-  ldrPath = QDir::currentPath() + "/" + Paths::tmpDir;
-  ldrFile = ldrPath + "/" + ldrName;
+  ldrFile = job.scratchFile("csi.ldr");
   if ((rc = rotateParts(addLine, meta.rotStep, csiParts, ldrFile,QString(),meta.LPub.assem.cameraAngles)) < 0) {
      return rc;
   }
@@ -957,8 +1182,6 @@ int LDGLite::renderCsi(
   //emit gui->messageSig(LOG_DEBUG,qPrintable("ENV: " + env.join(" ")));
 
   ldglite.setWorkingDirectory(QDir::currentPath() + "/" + Paths::tmpDir);
-  ldglite.setStandardErrorFile(QDir::currentPath() + "/stderr-ldglite");
-  ldglite.setStandardOutputFile(QDir::currentPath() + "/stdout-ldglite");
 
   QString message = QString("LDGLite CSI Arguments: %1 %2").arg(Preferences::ldgliteExe).arg(arguments.join(" "));
 #ifdef QT_DEBUG_MODE
@@ -968,11 +1191,10 @@ int LDGLite::renderCsi(
 #endif
 
   ldglite.start(Preferences::ldgliteExe,arguments);
-  if ( ! ldglite.waitForFinished(rendererTimeout())) {
+  bool finished = ldglite.waitForFinished(rendererTimeout());
+  QString str = job.saveLogs(ldglite,"ldglite");
+  if ( ! finished) {
     if (ldglite.exitCode() != 0) {
-      QByteArray status = ldglite.readAll();
-      QString str;
-      str.append(status);
       emit gui->messageSig(LOG_ERROR,QMessageBox::tr("LDGlite failed\n%1") .arg(str));
       return -1;
     }
@@ -989,6 +1211,10 @@ int LDGLite::renderPli(
   int                pliType,
   int                sub)
 {
+  PerfSpan perfSpan("render", "LDGLite::renderPli", pngName);
+
+  RenderJob job;
+
   // Select meta type
   PliMeta &metaType = pliType == SUBMODEL ? static_cast<PliMeta&>(meta.LPub.subModel) :
                       pliType == BOM ? meta.LPub.bom : meta.LPub.pli;
@@ -1089,8 +1315,6 @@ int LDGLite::renderPli(
 
   ldglite.setEnvironment(env);
   ldglite.setWorkingDirectory(QDir::currentPath());
-  ldglite.setStandardErrorFile(QDir::currentPath() + "/stderr-ldglite");
-  ldglite.setStandardOutputFile(QDir::currentPath() + "/stdout-ldglite");
 
   QString message = QString("LDGLite PLI Arguments: %1 %2").arg(Preferences::ldgliteExe).arg(arguments.join(" "));
 #ifdef QT_DEBUG_MODE
@@ -1100,11 +1324,10 @@ int LDGLite::renderPli(
 #endif
 
   ldglite.start(Preferences::ldgliteExe,arguments);
-  if (! ldglite.waitForFinished()) {
+  bool finished = ldglite.waitForFinished();
+  QString str = job.saveLogs(ldglite,"ldglite");
+  if (! finished) {
     if (ldglite.exitCode()) {
-      QByteArray status = ldglite.readAll();
-      QString str;
-      str.append(status);
       emit gui->messageSig(LOG_ERROR,QMessageBox::tr("LDGlite failed\n%1") .arg(str));
       return -1;
     }
@@ -1156,6 +1379,8 @@ int LDView::renderCsi(
         const QString     &pngName,
         Meta              &meta)
 {
+    PerfSpan perfSpan("render", "LDView::renderCsi", pngName);
+
     /* determine camera distance */
     int cd = cameraDistance(meta,meta.LPub.assem.modelScale.value())*1700/1000;
 
@@ -1175,6 +1400,8 @@ int LDView::renderCsi(
     QString tempPath = QDir::currentPath() + "/" + Paths::tmpDir;
     QString assemPath = QDir::currentPath() + "/" + Paths::assemDir;
 
+    RenderJob job;
+
     /* Create the CSI DAT file(s) */
     QString f;
     QStringList ldrNames = QStringList(), ldrNamesIM = QStringList();
@@ -1232,7 +1459,7 @@ int LDView::renderCsi(
             csiKey = csiKeys.first();
         }
 
-        ldrNames << tempPath + "/csi.ldr";
+        ldrNames << job.scratchFile("csi.ldr");
 
         if ((rc = rotateParts(addLine, meta.rotStep, csiParts,ldrNames.first(), csiKey, meta.LPub.assem.cameraAngles)) < 0) {
             emit gui->messageSig(LOG_ERROR,QMessageBox::tr("LDView (Single Call) CSI rotate parts failed!"));
@@ -1391,6 +1618,8 @@ int LDView::renderPli(
   int                pliType,
   int                sub)
 {
+  PerfSpan perfSpan("render", "LDView::renderPli", pngName);
+
   // Select meta type
   PliMeta &metaType = pliType == SUBMODEL ? static_cast<PliMeta&>(meta.LPub.subModel) :
                       pliType == BOM ? meta.LPub.bom : meta.LPub.pli;
@@ -1576,7 +1805,9 @@ int Native::renderCsi(
   const QString     &pngName,
         Meta        &meta)
 {
-  QString ldrName     = QDir::currentPath() + "/" + Paths::tmpDir + "/csi.ldr";
+  PerfSpan perfSpan("render", "Native::renderCsi", pngName);
+
+  QString ldrName     = getCsiLdrFileName(pngName);
   float lineThickness = (float(resolution()/Preferences::highlightStepLineWidth));
 
   // Camera Angles always applied by Native renderer except if ABS rotstep
@@ -1653,7 +1884,7 @@ int Native::renderCsi(
                                     gui->exportMode == EXPORT_STL ? NativeSTLIni : EXPORT_HTML; */
               }
 
-              ldrName = QDir::currentPath() + "/" + Paths::tmpDir + "/exportcsi.ldr";
+              ldrName = QString("%1/export_%2").arg(QFileInfo(ldrName).absolutePath()).arg(QFileInfo(ldrName).fileName());
 
               // rotate parts for ldvExport - apply camera angles
               int rc;
@@ -1720,6 +1951,8 @@ int Native::renderPli(
   int               pliType,
   int               sub)
 {
+  PerfSpan perfSpan("render", "Native::renderPli", pngName);
+
   // Select meta type
   PliMeta &metaType = pliType == SUBMODEL ? static_cast<PliMeta&>(meta.LPub.subModel) :
                       pliType == BOM ? meta.LPub.bom : meta.LPub.pli;
@@ -1807,8 +2040,15 @@ bool Render::RenderNativeImage(const NativeOptions &Options)
         ActiveView->SetCameraAngles(Options.Latitude, Options.Longitude);
     }
 
+    // Without framebuffer objects, e.g. on a headless host where no GL
+    // context was made, or when asked to, draw the image in software
+    // without making any GL call
+    bool SoftwareImage = gApplication->mPreferences.mNativeSoftwareRender ||
+                         !(gSupportsFramebufferObjectARB || gSupportsFramebufferObjectEXT);
+
     // Set zoom
-    ActiveView->MakeCurrent();
+    if (!SoftwareImage)
+        ActiveView->MakeCurrent();
     lcContext* Context = ActiveView->mContext;
     Camera->Zoom(Options.CameraDistance,CurrentStep,true);
 
@@ -1821,16 +2061,15 @@ bool Render::RenderNativeImage(const NativeOptions &Options)
     const int ImageWidth  = Options.ImageWidth;
     const int ImageHeight = Options.ImageHeight;
 
-    if (!View.BeginRenderToImage(ImageWidth, ImageHeight))
+    if (!SoftwareImage && !View.BeginRenderToImage(ImageWidth, ImageHeight))
     {
-        emit gui->messageSig(LOG_ERROR,QMessageBox::tr("Could not begin RenderToImage for Native %1 image.").arg(ImageType));
-        return false;
+        View.EndRenderToImage();
+        emit gui->messageSig(LOG_NOTICE,QMessageBox::tr("Could not begin RenderToImage for Native %1 image, using the software rasterizer.").arg(ImageType));
+        SoftwareImage = true;
     }
 
     ActiveModel->SetTemporaryStep(CurrentStep);
 
-    View.OnDraw();
-
     struct NativeImage
     {
         QImage RenderedImage;
@@ -1838,7 +2077,29 @@ bool Render::RenderNativeImage(const NativeOptions &Options)
     };
 
     NativeImage Image;
-    Image.RenderedImage = View.GetRenderImage();
+
+    if (SoftwareImage)
+    {
+        Image.RenderedImage = View.RenderSoftwareImage(ImageWidth, ImageHeight);
+    }
+    else
+    {
+        View.OnDraw();
+        Image.RenderedImage = View.GetRenderImage();
+        View.EndRenderToImage();
+        Context->ClearResources();
+
+        if (gApplication->mPreferences.mConditionalLines != lcConditionalLines::OFF)
+        {
+            const lcSceneStatistics& Statistics = View.GetScene().GetStatistics();
+            emit gui->messageSig(LOG_INFO,QMessageBox::tr("Native %1 image conditional lines %2: %3 of %4 drawn, tested in %5 ms")
+                                 .arg(ImageType)
+                                 .arg(gApplication->mPreferences.mConditionalLines == lcConditionalLines::BATCHED ? "batched" : "per line")
+                                 .arg(Statistics.VisibleConditionalLines)
+                                 .arg(Statistics.ConditionalLines)
+                                 .arg(Statistics.ConditionalLineTime / 1000000.0, 0, 'f', 3));
+        }
+    }
 
     auto CalculateImageBounds = [](NativeImage& Image)
     {
@@ -1883,9 +2144,6 @@ bool Render::RenderNativeImage(const NativeOptions &Options)
         return false;
     }
 
-    View.EndRenderToImage();
-    Context->ClearResources();
-
     ActiveModel->SetTemporaryStep(CurrentStep);
 
     if (!ActiveModel->mActive)
@@ -1904,22 +2162,49 @@ bool Render::RenderNativeImage(const NativeOptions &Options)
     return true;
 }
 
+/*
+ * A step whose contents are already loaded, unmodified, in the 3DViewer
+ * only has its camera set.  The loaded project is recognised by the
+ * application's project generation, which changes whenever the viewer
+ * project is replaced.
+ */
+
+static int           loadedViewerGeneration = -1;
+static QStringList   loadedViewerContents;
+
 bool Render::LoadViewer(const ViewerOptions &Options){
 
     QString viewerCsiKey = Options.ViewerCsiKey;
 
+    QString FileName = gui->getViewerStepFilePath(viewerCsiKey);
+    QStringList CsiContent = gui->getViewerStepRotatedContents(viewerCsiKey);
+
+    Project* LoadedProject = gApplication->mProject;
+    bool loaded = LoadedProject &&
+                  gApplication->mProjectGeneration == loadedViewerGeneration &&
+                  ! LoadedProject->IsModified() &&
+                  ! CsiContent.isEmpty() &&
+                  LoadedProject->GetFileName() == FileName &&
+                  CsiContent == loadedViewerContents;
+
     // Load model
-    Project* StepProject = new Project();
-    if (LoadStepProject(StepProject, viewerCsiKey)){
-        gApplication->SetProject(StepProject);
-        gMainWindow->UpdateAllViews();
-    }
-    else
-    {
-        emit gui->messageSig(LOG_ERROR,QMessageBox::tr("Could not load 3DViewer model file %1.")
-                             .arg(viewerCsiKey));
-        delete StepProject;
-        return false;
+    if (! loaded) {
+        Project* StepProject = new Project();
+        if (LoadStepProject(StepProject, viewerCsiKey)){
+            gApplication->SetProject(StepProject);
+            gMainWindow->UpdateAllViews();
+            loadedViewerGeneration = gApplication->mProjectGeneration;
+            loadedViewerContents   = CsiContent;
+        }
+        else
+        {
+            emit gui->messageSig(LOG_ERROR,QMessageBox::tr("Could not load 3DViewer model file %1.")
+                                 .arg(viewerCsiKey));
+            delete StepProject;
+            loadedViewerGeneration = -1;
+            loadedViewerContents.clear();
+            return false;
+        }
     }
 
     gui->setViewerCsiKey(viewerCsiKey);
@@ -2250,6 +2535,19 @@ const QString Render::getPovrayRenderQuality(int quality)
     return Arguments.join(" ");
 }
 
+/*
+ * The CSI file a step writes for its image, <temp dir>/<image key>.ldr.
+ * Each step, and each render in flight, so has a file of its own.
+ */
+
+const QString Render::getCsiLdrFileName(const QString &pngName)
+{
+    return QString("%1/%2/%3.ldr")
+                   .arg(QDir::currentPath())
+                   .arg(Paths::tmpDir)
+                   .arg(QFileInfo(pngName).completeBaseName());
+}
+
 const QString Render::getPovrayRenderFileName(const QString &viewerCsiKey)
 {
     QString valueAt0 = viewerCsiKey.at(0);
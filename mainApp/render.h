@@ -31,6 +31,7 @@
 
 #include <QString>
 #include <QStringList>
+#include <QSharedPointer>
 
 class QString;
 class QStringList;
@@ -45,6 +46,86 @@ class ViewerOptions;
 class NativePov;
 class lcVector3;
 class Project;
+class QProcess;
+
+/*
+ * A single CSI or PLI render.  The job gives each scratch file it is asked
+ * for a name of its own in the temp directory, removes them when it goes
+ * out of scope, and collects its renderer's output before writing the log
+ * files, so renders in flight at the same time keep to their own files.
+ */
+
+class RenderJob
+{
+public:
+  RenderJob();
+  ~RenderJob();
+  QString scratchFile(const QString &fileName);
+  QString saveLogs(QProcess &process, const QString &logName);
+  int     id() const
+  {
+    return _id;
+  }
+
+private:
+  int         _id;
+  QStringList _scratchFiles;
+};
+
+/*
+ * A POV-Ray render waiting on the scheduler.  The render job is shared so
+ * the scene file outlives the renderPli or renderCsi call that queued it.
+ */
+
+class POVRayJob
+{
+public:
+  QString     name;              // CSI or PLI, for messages
+  QStringList arguments;
+  QString     workingDirectory;
+  QString     pngName;
+  qint64      cost;              // part count times image area
+  int         threads;           // +WT worker threads given to the job
+  QSharedPointer<RenderJob> job;
+
+  POVRayJob()
+  {
+    cost    = 1;
+    threads = 1;
+  }
+};
+
+/*
+ * A POV-Ray render batch.  Renders asked for between begin and end of a
+ * batch are queued on it and run as concurrent processes when end is
+ * called, end returns the combined result.  Each job gets a share of the
+ * cores for POV-Ray's own worker threads in proportion to its cost, jobs
+ * are started largest first while their threads fit in the cores left,
+ * and a job that outlives the renderer timeout is killed.  Outside a
+ * batch a render runs at once with every core.  The owner of the batch,
+ * e.g. a Pli, keeps the queue; only the batch open last takes renders.
+ */
+
+class POVRayScheduler
+{
+public:
+  POVRayScheduler();
+  ~POVRayScheduler();
+  void          begin();
+  int           end();
+  static int    render(POVRayJob &job);
+  static qint64 cost(int parts, int width, int height);
+  static int    partCount(const QString &ldrName);
+  static int    maxJobs;    // renders run at once at most, 0 for as many as the cores take
+
+private:
+  static int    run(QList<POVRayJob> &jobs);
+
+  QList<POVRayJob>        queue;
+  int                     depth;
+  POVRayScheduler        *outer;    // batch that was open when this one began
+  static POVRayScheduler *current;  // batch taking renders, if any
+};
 
 class Render
 {
@@ -63,6 +144,7 @@ public:
   static int             executeLDViewProcess(QStringList &, Mt);
   static QString const   fixupDirname(const QString &);
   static QString const   getPovrayRenderFileName(const QString &);
+  static QString const   getCsiLdrFileName(const QString &pngName);
   static QStringList const getSubAttributes(const QString &);
   static float           getPovrayRenderCameraDistance(const QString &cdKeys);
   static void            showLdvExportSettings(int mode);
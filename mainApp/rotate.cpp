@@ -27,6 +27,7 @@
 #include "paths.h"
 #include "render.h"
 #include "ldrawfiles.h"
+#include "perftrace.h"
 #include <LDVQt/LDVImageMatte.h>
 
 
@@ -150,6 +151,32 @@ void rotateMatrix(
   }
 }
 
+/*
+ * A type 1 to 5 line from the parts handed to rotateParts.  Its points
+ * and type 1 matrix live in flat arrays so each step is parsed once,
+ * transformed in one pass and only turned back into text at the end.
+ */
+
+class RotateLine {
+public:
+  int     index;       // line in parts
+  int     type;        // line type 1 through 5
+  int     numPoints;
+  int     point;       // first point in the points array
+  int     matrix;      // matrix in the matrices array, type 1 only
+  QString colour;
+  QString name;        // type 1 only
+
+  RotateLine()
+  {
+    index     = 0;
+    type      = 0;
+    numPoints = 0;
+    point     = 0;
+    matrix    = 0;
+  }
+};
+
 int Render::rotateParts(const QStringList &parts, QString &ldrName, const QString &rs, QString &ca)
 {
     bool ldvExport = true, good = false, ok = false;
@@ -196,6 +223,8 @@ int Render::rotateParts(
           FloatPairMeta     &ca,
           bool               ldv /* false */)
 {
+  PerfSpan perfSpan("render", "Render::rotateParts", ldrName);
+
   bool ldvFunction     = ldv || gui->m_partListCSIFile;
   bool doFadeStep      = Preferences::enableFadeSteps;
   bool doHighlightStep = Preferences::enableHighlightStep;
@@ -270,6 +299,8 @@ int Render::rotateParts(
         FloatPairMeta &ca,
         bool          applyCA /* true */)
 {
+  PerfSpan perfSpan("render", "Render::rotateParts(parts)", QString(), parts.size());
+
   bool cal = Preferences::applyCALocally;
   bool defaultRot = (cal && applyCA);
 
@@ -326,107 +357,91 @@ int Render::rotateParts(
     }
   }
 
-  // rotate all the parts
+  // parse the lines to transform once, keeping the points of every line
+  // in one array and the type 1 rotation matrices in another
+
+  QVector<RotateLine> lines;
+  QVector<double>     points;
+  QVector<double>     matrices;
+
+  lines.reserve(parts.size());
+  points.reserve(parts.size() * 3);
 
   for (int i = 0; i < parts.size(); i++) {
 
-    QString line = parts[i];
+    const QString &line = parts.at(i);
+
+    int p = 0;
+    while (p < line.size() && line.at(p) == QLatin1Char(' ')) {
+      ++p;
+    }
+    if (p == line.size() || line.at(p) < QLatin1Char('1') || line.at(p) > QLatin1Char('5')) {
+      continue;
+    }
+
     QStringList tokens;
 
     split(line,tokens);
 
-    if (tokens.size() < 2) {
+    if (tokens.size() < 2 || tokens[0].size() != 1) {
       continue;
     }
 
-    double v[4][3];
+    RotateLine rotateLine;
+    rotateLine.type = tokens[0].at(0).toLatin1() - '0';
 
-    if (tokens[0] == "1") {
-      v[0][0] = tokens[2].toFloat();
-      v[0][1] = tokens[3].toFloat();
-      v[0][2] = tokens[4].toFloat();
+    if (rotateLine.type < 1 || rotateLine.type > 5) {
+      continue;
+    }
 
-      rotatePoint(v[0],rm);
+    rotateLine.numPoints = rotateLine.type == 5 ? 4 : rotateLine.type;
+    int numTokens = 2 + rotateLine.numPoints * 3 + (rotateLine.type == 1 ? 10 : 0);
+    if (tokens.size() < numTokens) {
+      continue;
+    }
 
-      for (int d = 0; d < 3; d++) {
-        if (v[0][d] < min[d]) {
-          min[d] = v[0][d];
-        }
-        if (v[0][d] > max[d]) {
-          max[d] = v[0][d];
-        }
-      }
-    } else if (tokens[0] == "2") {
-      int c = 2;
-      for (int j = 0; j < 2; j++) {
-        v[j][0] = tokens[c].toDouble();
-        v[j][1] = tokens[c+1].toDouble();
-        v[j][2] = tokens[c+2].toDouble();
-        c += 3;
-        rotatePoint(v[j],rm);
-
-        for (int d = 0; d < 3; d++) {
-          if (v[j][d] < min[d]) {
-            min[d] = v[j][d];
-          }
-          if (v[j][d] > max[d]) {
-            max[d] = v[j][d];
-          }
-        }
+    rotateLine.index  = i;
+    rotateLine.colour = tokens[1];
+    rotateLine.point  = points.size() / 3;
+
+    if (rotateLine.type == 1) {
+      points.append(tokens[2].toFloat());
+      points.append(tokens[3].toFloat());
+      points.append(tokens[4].toFloat());
+      rotateLine.matrix = matrices.size() / 9;
+      for (int c = 5; c < 14; c++) {
+        matrices.append(tokens[c].toDouble());
       }
-    } else if (tokens[0] == "3") {
-      int c = 2;
-      for (int j = 0; j < 3; j++) {
-        v[j][0] = tokens[c].toDouble();
-        v[j][1] = tokens[c+1].toDouble();
-        v[j][2] = tokens[c+2].toDouble();
-        c += 3;
-        rotatePoint(v[j],rm);
-
-        for (int d = 0; d < 3; d++) {
-          if (v[j][d] < min[d]) {
-            min[d] = v[j][d];
-          }
-          if (v[j][d] > max[d]) {
-            max[d] = v[j][d];
-          }
-        }
+      rotateLine.name = tokens[tokens.size()-1];
+    } else {
+      for (int c = 2; c < numTokens; c++) {
+        points.append(tokens[c].toDouble());
       }
-    } else if (tokens[0] == "4") {
-      int c = 2;
-      for (int j = 0; j < 4; j++) {
-        v[j][0] = tokens[c].toDouble();
-        v[j][1] = tokens[c+1].toDouble();
-        v[j][2] = tokens[c+2].toDouble();
-        c += 3;
-        rotatePoint(v[j],rm);
-
-        for (int d = 0; d < 3; d++) {
-          if (v[j][d] < min[d]) {
-            min[d] = v[j][d];
-          }
-          if (v[j][d] > max[d]) {
-            max[d] = v[j][d];
-          }
-        }
+    }
+
+    lines.append(rotateLine);
+  }
+
+  // rotate all the points, finding the bounding box as we go
+
+  double *v = points.data();
+  int numPoints = points.size() / 3;
+
+  for (int n = 0; n < numPoints; n++, v += 3) {
+    double X = rm[0][0]*v[0] + rm[0][1]*v[1] + rm[0][2]*v[2];
+    double Y = rm[1][0]*v[0] + rm[1][1]*v[1] + rm[1][2]*v[2];
+    double Z = rm[2][0]*v[0] + rm[2][1]*v[1] + rm[2][2]*v[2];
+
+    v[0] = X;
+    v[1] = Y;
+    v[2] = Z;
+
+    for (int d = 0; d < 3; d++) {
+      if (v[d] < min[d]) {
+        min[d] = v[d];
       }
-    } else if (tokens[0] == "5") {
-      int c = 2;
-      for (int j = 0; j < 4; j++) {
-        v[j][0] = tokens[c].toDouble();
-        v[j][1] = tokens[c+1].toDouble();
-        v[j][2] = tokens[c+2].toDouble();
-        c += 3;
-        rotatePoint(v[j],rm);
-
-        for (int d = 0; d < 3; d++) {
-          if (v[j][d] < min[d]) {
-            min[d] = v[j][d];
-          }
-          if (v[j][d] > max[d]) {
-            max[d] = v[j][d];
-          }
-        }
+      if (v[d] > max[d]) {
+        max[d] = v[d];
       }
     }
   }
@@ -438,144 +453,62 @@ int Render::rotateParts(
     center[d] = (min[d] + max[d])/2;
   }
 
-  for (int i = 0; i < parts.size(); i++) {
-    QString line = parts[i];
-    QStringList tokens;
+  v = points.data();
+  for (int n = 0; n < numPoints; n++, v += 3) {
+    v[0] -= center[0];
+    v[1] -= center[1];
+    v[2] -= center[2];
+  }
 
-    split(line,tokens);
+  // rotate the type 1 matrices
 
-    if (tokens.size() < 2) {
-      continue;
-    }
+  double *m = matrices.data();
+  int numMatrices = matrices.size() / 9;
 
-    double v[4][3];
-    double pm[3][3];
-    QString t1;
-
-    if (tokens[0] == "1") {
-      int c = 2;
-      v[0][0] = tokens[c].toFloat();
-      v[0][1] = tokens[c+1].toFloat();
-      v[0][2] = tokens[c+2].toFloat();
-      c += 3;
-      for (int y = 0; y < 3; y++) {
-        for (int x = 0; x < 3; x++) {
-          pm[y][x] = tokens[c++].toDouble();
-        }
-      }
-      rotatePoint(v[0],rm);
-      v[0][0] -= center[0];
-      v[0][1] -= center[1];
-      v[0][2] -= center[2];
-      rotateMatrix(pm,rm);
-
-      t1 = QString("1 %1 "
-                   "%2 %3 %4 "
-                   "%5 %6 %7 "
-                   "%8 %9 %10 "
-                   "%11 %12 %13 "
-                   "%14")
-
-                   .arg(tokens[1])
-                   .arg( v[0][0]) .arg( v[0][1]) .arg( v[0][2])
-                   .arg(pm[0][0]) .arg(pm[0][1]) .arg(pm[0][2])
-                   .arg(pm[1][0]) .arg(pm[1][1]) .arg(pm[1][2])
-                   .arg(pm[2][0]) .arg(pm[2][1]) .arg(pm[2][2])
-                   .arg(tokens[tokens.size()-1]);
-
-      parts[i] = t1;
-    } else if (tokens[0] == "2") {
-
-      int c = 2;
-      for (int n = 0; n < 2; n++) {
-        for (int d = 0; d < 3; d++) {
-          v[n][d] = tokens[c++].toDouble();
-        }
-        rotatePoint(v[n],rm);
-        for (int d = 0; d < 3; d++) {
-          v[n][d] -= center[d];
+  for (int n = 0; n < numMatrices; n++, m += 9) {
+    double res[9];
+    for (int i = 0; i < 3; i++) {
+      for (int j = 0; j < 3; j++) {
+        res[i*3+j] = 0.0;
+        for (int k = 0; k < 3; k++) {
+          res[i*3+j] += rm[i][k] * m[k*3+j];
         }
       }
+    }
+    for (int k = 0; k < 9; k++) {
+      m[k] = res[k];
+    }
+  }
 
-      t1 = QString("2 %1 "
-                   "%2 %3 %4 "
-                   "%5 %6 %7")
-                   .arg(tokens[1])
-                   .arg( v[0][0]) .arg( v[0][1]) .arg( v[0][2])
-                   .arg( v[1][0]) .arg( v[1][1]) .arg( v[1][2]);
-      parts[i] = t1;
-    } else if (tokens[0] == "3") {
-
-      int c = 2;
-      for (int n = 0; n < 3; n++) {
-        for (int d = 0; d < 3; d++) {
-          v[n][d] = tokens[c++].toDouble();
-        }
-        rotatePoint(v[n],rm);
-        for (int d = 0; d < 3; d++) {
-          v[n][d] -= center[d];
-        }
-      }
+  // write the transformed lines back
 
-      t1 = QString("3 %1 "
-                   "%2 %3 %4  "
-                   "%5 %6 %7  "
-                   "%8 %9 %10")
-                     .arg(tokens[1])
-                     .arg( v[0][0]) .arg( v[0][1]) .arg( v[0][2])
-                     .arg( v[1][0]) .arg( v[1][1]) .arg( v[1][2])
-                     .arg( v[2][0]) .arg( v[2][1]) .arg( v[2][2]);
-      parts[i] = t1;
-    } else if (tokens[0] == "4") {
-
-      int c = 2;
-      for (int n = 0; n < 4; n++) {
-        for (int d = 0; d < 3; d++) {
-          v[n][d] = tokens[c++].toDouble();
-        }
-        rotatePoint(v[n],rm);
-        for (int d = 0; d < 3; d++) {
-          v[n][d] -= center[d];
-        }
-      }
+  for (int i = 0; i < lines.size(); i++) {
+    const RotateLine &rotateLine = lines[i];
+    const double *p = points.constData() + rotateLine.point * 3;
 
-      t1 = QString("4 %1 "
-                   "%2 %3 %4 "
-                   "%5 %6 %7 "
-                   "%8 %9 %10 "
-                   "%11 %12 %13")
-                     .arg(tokens[1])
-                     .arg( v[0][0]) .arg( v[0][1]) .arg( v[0][2])
-                     .arg( v[1][0]) .arg( v[1][1]) .arg( v[1][2])
-                     .arg( v[2][0]) .arg( v[2][1]) .arg( v[2][2])
-                     .arg( v[3][0]) .arg( v[3][1]) .arg( v[3][2]);
-      parts[i] = t1;
-    } else if (tokens[0] == "5") {
-
-      int c = 2;
-      for (int n = 0; n < 4; n++) {
-        for (int d = 0; d < 3; d++) {
-          v[n][d] = tokens[c++].toDouble();
-        }
-        rotatePoint(v[n],rm);
-        for (int d = 0; d < 3; d++) {
-          v[n][d] -= center[d];
-        }
+    QString line = QString::number(rotateLine.type) + ' ' + rotateLine.colour;
+
+    for (int n = 0; n < rotateLine.numPoints; n++) {
+      // triangles have always been written with a double space between points
+      if (rotateLine.type == 3 && n > 0) {
+        line += ' ';
+      }
+      for (int d = 0; d < 3; d++) {
+        line += ' ' + QString::number(p[n*3+d],'g',6);
       }
+    }
 
-      t1 = QString("5 %1 "
-                   "%2 %3 %4 "
-                   "%5 %6 %7 "
-                   "%8 %9 %10 "
-                   "%11 %12 %13")
-                     .arg(tokens[1])
-                     .arg( v[0][0]) .arg( v[0][1]) .arg( v[0][2])
-                     .arg( v[1][0]) .arg( v[1][1]) .arg( v[1][2])
-                     .arg( v[2][0]) .arg( v[2][1]) .arg( v[2][2])
-                     .arg( v[3][0]) .arg( v[3][1]) .arg( v[3][2]);
-      parts[i] = t1;
+    if (rotateLine.type == 1) {
+      const double *pm = matrices.constData() + rotateLine.matrix * 9;
+      for (int k = 0; k < 9; k++) {
+        line += ' ' + QString::number(pm[k],'g',6);
+      }
+      line += ' ' + rotateLine.name;
     }
+
+    parts[rotateLine.index] = line;
   }
+
   return 0;
 }
 
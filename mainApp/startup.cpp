@@ -0,0 +1,255 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * This file implements the startup trace and the startup scheduler
+ * described in startup.h.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#include <QThread>
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <stdio.h>
+
+#include "startup.h"
+#include "QsLog.h"
+
+QMutex                      StartupTrace::_mutex;
+QElapsedTimer               StartupTrace::_clock;
+QVector<StartupTrace::Span> StartupTrace::_spans;
+
+/*
+ * Spans still open on this thread, innermost last
+ */
+
+static QVector<int> &openSpans()
+{
+  static thread_local QVector<int> spans;
+  return spans;
+}
+
+static QString threadName()
+{
+  if (QCoreApplication::instance() &&
+      QThread::currentThread() == QCoreApplication::instance()->thread()) {
+    return QString("main");
+  }
+  return QString("worker %1").arg(quintptr(QThread::currentThreadId()),0,16);
+}
+
+void StartupTrace::begin(const QString &name)
+{
+  QMutexLocker locker(&_mutex);
+  if ( ! _clock.isValid()) {
+    _clock.start();
+  }
+
+  Span span;
+  span.name    = name;
+  span.thread  = threadName();
+  span.depth   = openSpans().size();
+  span.start   = _clock.nsecsElapsed();
+  span.elapsed = -1;
+
+  openSpans().append(_spans.size());
+  _spans.append(span);
+}
+
+void StartupTrace::end()
+{
+  QMutexLocker locker(&_mutex);
+  if (openSpans().isEmpty()) {
+    return;
+  }
+  Span &span = _spans[openSpans().takeLast()];
+  span.elapsed = _clock.nsecsElapsed() - span.start;
+}
+
+void StartupTrace::report(bool toStdout)
+{
+  QMutexLocker locker(&_mutex);
+
+  QStringList lines;
+  lines << QString("Startup trace (ms): start  elapsed  thread  stage");
+  for (const Span &span : _spans) {
+    lines << QString("%1 %2  %3  %4%5")
+             .arg(span.start / 1000000.0, 9, 'f', 1)
+             .arg(span.elapsed < 0 ? QString("open") : QString::number(span.elapsed / 1000000.0, 'f', 1), 8)
+             .arg(span.thread, -10)
+             .arg(QString(span.depth * 2, ' '))
+             .arg(span.name);
+  }
+
+  for (const QString &line : lines) {
+    logInfo() << line;
+    if (toStdout) {
+      fprintf(stdout, "%s\n", line.toLatin1().constData());
+    }
+  }
+  if (toStdout) {
+    fflush(stdout);
+  }
+}
+
+StartupScheduler::StartupScheduler()
+{
+  _pool.setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+}
+
+void StartupScheduler::add(
+  const QString        &name,
+  std::function<void()> task,
+  const QStringList    &after,
+  StartupMode           mode)
+{
+  QMutexLocker locker(&_mutex);
+
+  Task entry;
+  entry.task  = task;
+  entry.after = after;
+  entry.mode  = mode;
+  entry.state = Pending;
+
+  if ( ! _tasks.contains(name)) {
+    _order.append(name);
+  }
+  _tasks.insert(name,entry);
+}
+
+bool StartupScheduler::ready(const Task &task) const
+{
+  for (const QString &name : task.after) {
+    QHash<QString,Task>::const_iterator it = _tasks.constFind(name);
+    if (it != _tasks.constEnd() && it.value().state != Done) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+ * Start every pending worker whose predecessors are done.
+ * Called with the mutex held.
+ */
+
+void StartupScheduler::dispatch()
+{
+  for (const QString &name : _order) {
+    Task &entry = _tasks[name];
+    if (entry.mode != StartupWorker || entry.state != Pending || ! ready(entry)) {
+      continue;
+    }
+    entry.state = Running;
+
+    std::function<void()> task = entry.task;
+    QtConcurrent::run(&_pool, [this, name, task]() {
+      {
+        StartupSpan span(name);
+        try {
+          task();
+        } catch (...) {
+          logError() << QString("Startup task %1 failed.").arg(name);
+        }
+      }
+      QMutexLocker locker(&_mutex);
+      _tasks[name].state = Done;
+      _changed.wakeAll();
+      dispatch();
+    });
+  }
+}
+
+/*
+ * Run a task already marked running on this thread.
+ */
+
+void StartupScheduler::execute(const QString &name)
+{
+  std::function<void()> task;
+  {
+    QMutexLocker locker(&_mutex);
+    task = _tasks[name].task;
+  }
+
+  auto finish = [this, &name]() {
+    QMutexLocker locker(&_mutex);
+    _tasks[name].state = Done;
+    _changed.wakeAll();
+    dispatch();
+  };
+
+  try {
+    StartupSpan span(name);
+    task();
+  } catch (...) {
+    finish();
+    throw;
+  }
+  finish();
+}
+
+void StartupScheduler::require(const QString &name)
+{
+  QMutexLocker locker(&_mutex);
+  if ( ! _tasks.contains(name)) {
+    return;
+  }
+
+  Task &entry = _tasks[name];
+
+  // not started yet, so run it here once its predecessors are done
+  if (entry.state == Pending) {
+    entry.state = Running;
+    QStringList after = entry.after;
+    locker.unlock();
+    for (const QString &predecessor : after) {
+      require(predecessor);
+    }
+    execute(name);
+    return;
+  }
+
+  while (_tasks[name].state != Done) {
+    _changed.wait(&_mutex);
+  }
+}
+
+void StartupScheduler::run()
+{
+  QStringList order;
+  {
+    QMutexLocker locker(&_mutex);
+    dispatch();
+    order = _order;
+  }
+
+  for (const QString &name : order) {
+    bool main;
+    {
+      QMutexLocker locker(&_mutex);
+      main = _tasks[name].mode == StartupMain;
+    }
+    if (main) {
+      require(name);
+    }
+  }
+}
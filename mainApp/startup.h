@@ -0,0 +1,137 @@
+/****************************************************************************
+**
+** Copyright (C) 2019 Trevor SANDY. All rights reserved.
+**
+** This file may be used under the terms of the GNU General Public
+** License version 2.0 as published by the Free Software Foundation
+** and appearing in the file LICENSE.GPL included in the packaging of
+** this file.  Please review the following information to ensure GNU
+** General Public Licensing requirements will be met:
+** http://www.trolltech.com/products/qt/opensource.html
+**
+** This file is provided AS IS with NO WARRANTY OF ANY KIND, INCLUDING THE
+** WARRANTY OF DESIGN, MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+**
+****************************************************************************/
+
+/****************************************************************************
+ *
+ * The startup trace records a named span for each stage of
+ * Application::initialize and Application::mainApp - when it started,
+ * how long it took, which thread ran it and how deeply it was nested.
+ * The spans are written to the log once the application is ready, and to
+ * standard output as well when --startup-trace is given on the command
+ * line.
+ *
+ * The startup scheduler runs the stages as named tasks.  A task names the
+ * tasks it must follow and says where it runs:
+ *
+ *   StartupMain      on the thread that calls run, in the order added
+ *   StartupWorker    on a worker thread as soon as the tasks it follows
+ *                    are done, so it overlaps the main thread stages
+ *   StartupDeferred  only when require names it, on the calling thread
+ *
+ * require waits for a task to finish, running it first if it is deferred,
+ * so a stage that is only needed later is paid for on first use or not at
+ * all.
+ *
+ * Please see lpub.h for an overall description of how the files in LPub
+ * make up the LPub program.
+ *
+ ***************************************************************************/
+
+#ifndef STARTUP_H
+#define STARTUP_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QThreadPool>
+#include <QElapsedTimer>
+#include <functional>
+
+class StartupTrace {
+public:
+  static void begin(const QString &name);
+  static void end();
+
+  /* write the spans to the log, and to stdout if requested */
+  static void report(bool toStdout);
+
+private:
+  struct Span {
+    QString name;
+    QString thread;
+    int     depth;
+    qint64  start;    // nanoseconds since the first span began
+    qint64  elapsed;  // nanoseconds, -1 while open
+  };
+
+  static QMutex        _mutex;
+  static QElapsedTimer _clock;
+  static QVector<Span> _spans;
+};
+
+class StartupSpan {
+public:
+  StartupSpan(const QString &name)
+  {
+    StartupTrace::begin(name);
+  }
+  ~StartupSpan()
+  {
+    StartupTrace::end();
+  }
+};
+
+enum StartupMode {
+  StartupMain,
+  StartupWorker,
+  StartupDeferred
+};
+
+class StartupScheduler {
+public:
+  StartupScheduler();
+
+  void add(const QString     &name,
+           std::function<void()> task,
+           const QStringList &after = QStringList(),
+           StartupMode        mode  = StartupMain);
+
+  /* run the main thread tasks and start the workers */
+  void run();
+
+  /* wait for a task, running it here if it is deferred */
+  void require(const QString &name);
+
+  bool contains(const QString &name) const
+  {
+    return _tasks.contains(name);
+  }
+
+private:
+  enum State { Pending, Running, Done };
+
+  struct Task {
+    std::function<void()> task;
+    QStringList           after;
+    StartupMode           mode;
+    State                 state;
+  };
+
+  bool ready(const Task &task) const;
+  void dispatch();
+  void execute(const QString &name);
+
+  QMutex              _mutex;
+  QWaitCondition      _changed;
+  QThreadPool         _pool;
+  QHash<QString,Task> _tasks;
+  QStringList         _order;   // names in the order added
+};
+
+#endif // STARTUP_H
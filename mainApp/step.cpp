@@ -44,6 +44,7 @@
 #include "dependencies.h"
 #include "paths.h"
 #include "ldrawfiles.h"
+#include "perftrace.h"
 #include <LDVQt/LDVImageMatte.h>
 
 /*********************************************************************
@@ -206,6 +207,7 @@ int Step::createCsi(
       modelScale = meta.LPub.assem.modelScale.value();
   }
   QString csi_Name        = modelDisplayOnlyStep ? csiName()+"_fm" : bfxLoad ? csiName()+"_bfx" : csiName();
+  PerfSpan perfSpan("step", "Step::createCsi", csi_Name, stepNumber.number);
   bool    invalidIMStep   = ((modelDisplayOnlyStep) || (stepNumber.number == 1));
   bool    absRotstep      = meta.rotStep.value().type == "ABS";
   FloatPairMeta noCA;
@@ -226,6 +228,8 @@ int Step::createCsi(
   // Define csi file paths
   QString csiLdrFilePath = QString("%1/%2").arg(QDir::currentPath()).arg(Paths::tmpDir);
   QString csiPngFilePath = QString("%1/%2").arg(QDir::currentPath()).arg(Paths::assemDir);
+  // csi.ldr only names the viewer step, for its project and POV-Ray render
+  // file names, and is never written; the part list snapshot is written
   QString csiLdrFile = QString("%1/%2").arg(csiLdrFilePath).arg(gui->m_partListCSIFile ?
                                QFileInfo(gui->getCurFile()).baseName()+"_snapshot.ldr" : "csi.ldr");
   QString keyPart1 = QString("%1")
@@ -334,7 +338,9 @@ int Step::createCsi(
      if (renderer->useLDViewSCall() || nativeRenderer) {
 
          if (nativeRenderer) {
-            ldrName = csiLdrFile;
+            // Native::renderCsi reads <image key>.ldr, see Render::getCsiLdrFileName
+            if (gui->m_partListCSIFile)
+                ldrName = csiLdrFile;
             // update fade and highlight Preferences for rotateParts routine.
             meta.LPub.fadeStep.setPreferences();
             meta.LPub.highlightStep.setPreferences();
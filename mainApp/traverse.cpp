@@ -48,6 +48,7 @@
 #include "pointer.h"
 #include "pagepointer.h"
 #include "ranges_item.h"
+#include "perftrace.h"
 
 #include "QsLog.h"
 
@@ -389,6 +390,8 @@ int Gui::drawPage(
     bool            assembledCallout,
     bool            calledOut)
 {
+  PerfSpan perfSpan("page", "drawPage", current.modelName, stepNum);
+
   QStringList saveCsiParts;
   bool     global = true;
   QString  line, csiName;
@@ -1702,6 +1705,8 @@ int Gui::findPage(
     bool            printing,
     int             contStepNumber)
 {
+  PerfSpan perfSpan("page", "findPage", current.modelName, pageNum);
+
   bool stepGroup  = false;
   bool partIgnore = false;
   bool coverPage  = false;
@@ -1762,6 +1767,11 @@ int Gui::findPage(
       // scan through the rest of the model counting pages
       // if we've already hit the display page, then do as little as possible
 
+      // the page index counts the pages that follow
+      if (pageNum > displayPageNum) {
+          return 0;
+        }
+
       QString line = ldrawFile.readLine(current.modelName,current.lineNumber).trimmed();
 
       // initialize colsolidate instance count
@@ -1868,7 +1878,18 @@ int Gui::findPage(
 //                                        .arg(stepNumber);
                       }
 
-                      findPage(view,scene,pageNum,line,current2,pageSize,isMirrored,meta,printing,contStepNumber);
+                      // step over a submodel that ends before the display page
+                      // using the page index, unless step numbers run across
+                      // submodels as the index does not follow them
+                      int startPage = pageNum;
+                      int endPage   = pageIndex.submodelEndPage(current.modelName,current.lineNumber,startPage);
+                      if (endPage && endPage <= displayPageNum && ! pageIndex.contStepNumbers()) {
+                          Meta meta2 = meta;
+                          indexPages(pageNum,token[1],current2,pageSize,isMirrored,meta2);
+                        } else {
+                          findPage(view,scene,pageNum,line,current2,pageSize,isMirrored,meta,printing,contStepNumber);
+                        }
+                      pageIndex.setSubmodelEndPage(current.modelName,current.lineNumber,startPage,pageNum);
                       saveStepPageNum = stepPageNum;
                       meta.submodelStack.pop_back();
                       meta.rotStep = saveRotStep2;       // restore old rotstep
@@ -2343,6 +2364,289 @@ int Gui::findPage(
   return 0;
 }
 
+/*
+ * Count pages from the page index summaries.  This follows the page
+ * boundary rules of findPage, but only the page size, orientation, include
+ * and instance count metas are handed to Meta::parse.
+ */
+
+int Gui::indexPages(
+    int            &pageNum,
+    QString const  &addColour,
+    Where          &current,
+    PgSizeData     &pageSize,
+    bool            isMirrored,
+    Meta            meta)
+{
+  bool stepGroup  = false;
+  bool partIgnore = false;
+  bool coverPage  = false;
+  bool stepPage   = false;
+  bool bfxStore1  = false;
+  bool bfxStore2  = false;
+  bool callout    = false;
+  bool noStep     = false;
+  bool noStep2    = false;
+  bool pageSizeUpdate     = false;
+  bool setMergedInstances = false;
+  bool mergedInstances    = false;
+  int  calloutMode = CalloutBeginMeta::Unassembled;
+
+  QStringList bfxParts;
+  int  partsAdded = 0;
+  int  stepNumber = 1;
+
+  IndexModel model = pageIndex.model(current.modelName);
+  if (model.needsHeaderLine || ! pageIndex.contains(current.modelName)) {
+      skipHeader(current);
+      model = pageIndex.rescan(ldrawFile,current.modelName);
+    } else {
+      current.lineNumber = model.headerLine;
+    }
+
+  if (pageNum == 1) {
+      topOfPages.clear();
+      topOfPages.append(current);
+  }
+
+  ldrawFile.setRendered(current.modelName, -1, isMirrored);
+
+  // record the page size for a page we are leaving
+  auto insertPageSize = [&] ()
+  {
+    if (exporting()) {
+        pageSizes.remove(pageNum);
+        if (pageSizeUpdate) {
+            pageSizeUpdate = false;
+            pageSizes.insert(pageNum,pageSize);
+          } else {
+            pageSizes.insert(pageNum,pageSizes[DEF_SIZE]);
+          }
+      }
+  };
+
+  for (int i = 0; i < model.lines.size(); i++) {
+      const IndexLine &index = model.lines[i];
+
+      if (index.lineNumber < current.lineNumber) {
+          continue;
+        }
+      current.lineNumber = index.lineNumber;
+
+      switch (index.type) {
+        case IndexPartLine:
+          if (! partIgnore) {
+
+              if (firstStepPageNum == -1) {
+                  firstStepPageNum = pageNum;
+                }
+              lastStepPageNum = pageNum;
+
+              QString colour = index.colour == "16" && ! addColour.isEmpty() ? addColour : index.colour;
+              QString type   = index.name;
+
+              bool contains = ldrawFile.isSubmodel(type);
+
+              // if submodel or assembled/rotated callout
+              if (contains && (!callout || calloutMode != CalloutBeginMeta::Unassembled)) {
+
+                  bool rendered = ldrawFile.rendered(type,stepNumber,index.mirrored,mergedInstances);
+
+                  if (! rendered && (! bfxStore2 || ! bfxParts.contains(colour+type))) {
+
+                      isMirrored = index.mirrored;
+
+                      Where current2(type,0);
+
+                      ldrawFile.setModelStartPageNumber(current2.modelName,pageNum);
+
+                      // save Default pageSize information
+                      PgSizeData pageSize2;
+                      if (exporting()) {
+                          pageSize2       = pageSizes[DEF_SIZE];
+                          pageSizeUpdate  = false;
+                        }
+
+                      if (! mergedInstances) {
+                          ldrawFile.setRendered(current2.modelName, stepNumber, isMirrored);
+                        }
+
+                      int startPage = pageNum;
+                      indexPages(pageNum,colour,current2,pageSize,isMirrored,meta);
+                      pageIndex.setSubmodelEndPage(current.modelName,current.lineNumber,startPage,pageNum);
+
+                      if (exporting()) {
+                          pageSizes.remove(DEF_SIZE);
+                          pageSizes.insert(DEF_SIZE,pageSize2);  // restore old Default pageSize information
+                        }
+                    }
+                }
+              if (bfxStore1) {
+                  bfxParts << colour+type;
+                }
+            }
+          ++partsAdded;
+          break;
+
+        case IndexGeometryLine:
+          ++partsAdded;
+          break;
+
+        case IndexStepGroupBegin:
+          stepGroup = true;
+          break;
+
+        case IndexStepGroupEnd:
+          if (stepGroup && ! noStep2) {
+              stepGroup = false;
+              insertPageSize();
+              ++pageNum;
+              topOfPages.append(current);
+              ++stepPageNum;
+            }
+          noStep2 = false;
+          break;
+
+        case IndexStep:
+          if (partsAdded && ! noStep) {
+              stepNumber  += ! coverPage && ! stepPage;
+              stepPageNum += ! coverPage && ! stepGroup;
+              if ( ! stepGroup) {
+                  insertPageSize();
+                  ++pageNum;
+                  topOfPages.append(current);
+                }
+              partsAdded = 0;
+              coverPage = false;
+              stepPage = false;
+              bfxStore2 = bfxStore1;
+              bfxStore1 = false;
+              if ( ! bfxStore2) {
+                  bfxParts.clear();
+                }
+            }
+          noStep2 = noStep;
+          noStep = false;
+          break;
+
+        case IndexCalloutBegin:
+          callout = true;
+          calloutMode = index.calloutMode;
+          break;
+
+        case IndexCalloutEnd:
+          callout = false;
+          break;
+
+        case IndexInsertCoverPage:
+          coverPage  = true;
+          partsAdded = true;
+          break;
+
+        case IndexInsertPage:
+          stepPage   = true;
+          partsAdded = true;
+          break;
+
+        case IndexPartIgnoreBegin:
+          partIgnore = true;
+          break;
+
+        case IndexPartIgnoreEnd:
+          partIgnore = false;
+          break;
+
+        case IndexBufferStore:
+          bfxStore1 = true;
+          bfxParts.clear();
+          break;
+
+        case IndexBufferLoad:
+          partsAdded = true;
+          break;
+
+        // as in findPage, a group only adds to a step before the display page
+        case IndexGroup:
+          if (pageNum < displayPageNum) {
+              partsAdded = true;
+            }
+          break;
+
+        case IndexNoStep:
+          noStep = true;
+          break;
+
+        case IndexMergeInstances:
+          if (! setMergedInstances) {
+              QString line = ldrawFile.readLine(current.modelName,current.lineNumber).trimmed();
+              if ((setMergedInstances = (meta.parse(line,current) == OkRc))) {
+                  mergedInstances = meta.LPub.mergeInstanceCount.value();
+                }
+            }
+          break;
+
+        case IndexInclude:
+          {
+            QString line = ldrawFile.readLine(current.modelName,current.lineNumber).trimmed();
+            if (meta.parse(line,current) == IncludeRc) {
+                include(meta);
+              }
+          }
+          break;
+
+        case IndexPageSize:
+          if (exporting()) {
+              QString line = ldrawFile.readLine(current.modelName,current.lineNumber).trimmed();
+              if (meta.parse(line,current) == PageSizeRc) {
+                  pageSizeUpdate  = true;
+
+                  pageSize.sizeW  = meta.LPub.page.size.valueInches(0);
+                  pageSize.sizeH  = meta.LPub.page.size.valueInches(1);
+                  pageSize.sizeID = meta.LPub.page.size.valueSizeID();
+
+                  pageSizes.remove(DEF_SIZE);
+                  pageSizes.insert(DEF_SIZE,pageSize);
+                }
+            }
+          break;
+
+        case IndexPageOrientation:
+          if (exporting()) {
+              QString line = ldrawFile.readLine(current.modelName,current.lineNumber).trimmed();
+              if (meta.parse(line,current) == PageOrientationRc) {
+                  pageSizeUpdate      = true;
+
+                  if (pageSize.sizeW == 0.0f)
+                    pageSize.sizeW    = pageSizes[DEF_SIZE].sizeW;
+                  if (pageSize.sizeH == 0.0f)
+                    pageSize.sizeH    = pageSizes[DEF_SIZE].sizeH;
+                  if (pageSize.sizeID.isEmpty())
+                    pageSize.sizeID   = pageSizes[DEF_SIZE].sizeID;
+                  pageSize.orientation= meta.LPub.page.orientation.value();
+
+                  pageSizes.remove(DEF_SIZE);
+                  pageSizes.insert(DEF_SIZE,pageSize);
+                }
+            }
+          break;
+
+        default:
+          break;
+        }
+    } // for every indexed line
+
+  current.lineNumber = model.numLines;
+
+  // last step in submodel
+  if (partsAdded && ! noStep) {
+      insertPageSize();
+      ++pageNum;
+      topOfPages.append(current);
+      ++stepPageNum;
+    }
+  return 0;
+}
+
 int Gui::getBOMParts(
     Where        current,
     QString     &addLine,
@@ -2756,6 +3060,10 @@ void Gui::countPages()
   if (maxPages < 1) {
       writeToTmp();
       statusBarMsg("Counting");
+      QElapsedTimer timer;
+      timer.start();
+      int indexed = pageIndex.update(ldrawFile);
+      ldrawFile.unrendered();
       Where current(ldrawFile.topLevelFile(),0);
       int savedDpn     = displayPageNum;
       displayPageNum   = 1 << 31;
@@ -2766,12 +3074,16 @@ void Gui::countPages()
       QString empty;
       PgSizeData empty1;
       stepPageNum = 1;
-      findPage(KpageView,KpageScene,maxPages,/*addLine*/empty,current,/*pageSize*/empty1,
-               /*isMirrored*/false,meta,/*printing*/false,/*contStepNumber*/0);
+      indexPages(maxPages,/*addColour*/empty,current,/*pageSize*/empty1,
+                 /*isMirrored*/false,meta);
       topOfPages.append(current);
       maxPages--;
 
-      if (displayPageNum > maxPages) {
+      if (pageIndexCheck) {
+          checkPageIndex();
+        }
+
+      if (savedDpn > maxPages) {
           displayPageNum = maxPages;
         } else {
           displayPageNum = savedDpn;
@@ -2779,9 +3091,75 @@ void Gui::countPages()
       QString string = QString("%1 of %2") .arg(displayPageNum) .arg(maxPages);
       setPageLineEdit->setText(string);
       statusBarMsg("");
+      emit messageSig(LOG_DEBUG,QString("Counted %1 pages in %2 milliseconds (%3 of %4 submodels indexed).")
+                                        .arg(maxPages)
+                                        .arg(timer.elapsed())
+                                        .arg(indexed)
+                                        .arg(ldrawFile.subFileOrder().size()));
     }
 }
 
+/*
+ * Count the pages again with a full findPage walk, as countPages did
+ * before there was a page index, and compare the page count and the top
+ * of every page with the ones the index gave.  The index results are
+ * kept.  This is what the page index checks in builds/check run.
+ */
+
+bool Gui::checkPageIndex()
+{
+  QList<Where> indexTopOfPages  = topOfPages;
+  int indexMaxPages             = maxPages;
+  int indexStepPageNum          = stepPageNum;
+  int indexFirstStepPageNum     = firstStepPageNum;
+  int indexLastStepPageNum      = lastStepPageNum;
+
+  ldrawFile.unrendered();
+  Where current(ldrawFile.topLevelFile(),0);
+  firstStepPageNum = -1;
+  lastStepPageNum  = -1;
+  maxPages         = 1;
+  stepPageNum      = 1;
+  Meta meta;
+  QString empty;
+  PgSizeData empty1;
+  findPage(KpageView,KpageScene,maxPages,/*addLine*/empty,current,/*pageSize*/empty1,
+           /*isMirrored*/false,meta,/*printing*/false,/*contStepNumber*/0);
+  topOfPages.append(current);
+  maxPages--;
+
+  int page = 0;
+  for ( ; page < topOfPages.size() && page < indexTopOfPages.size(); page++) {
+      if (topOfPages[page].modelName.toLower() != indexTopOfPages[page].modelName.toLower() ||
+          topOfPages[page].lineNumber != indexTopOfPages[page].lineNumber) {
+          break;
+        }
+    }
+
+  bool passed = maxPages == indexMaxPages && topOfPages.size() == indexTopOfPages.size() &&
+                page == topOfPages.size();
+  if (passed) {
+      emit messageSig(LOG_INFO,QString("Page index check passed - %1 pages.").arg(maxPages));
+    } else {
+      Where walked  = page < topOfPages.size()      ? topOfPages[page]      : Where();
+      Where indexed = page < indexTopOfPages.size() ? indexTopOfPages[page] : Where();
+      emit messageSig(LOG_ERROR,QString("Page index check failed - the page index counted %1 pages "
+                                        "and findPage %2 pages. The top of page %3 is %4 line %5 "
+                                        "from the index and %6 line %7 from findPage.")
+                                        .arg(indexMaxPages).arg(maxPages).arg(page + 1)
+                                        .arg(indexed.modelName).arg(indexed.lineNumber)
+                                        .arg(walked.modelName).arg(walked.lineNumber));
+    }
+
+  topOfPages       = indexTopOfPages;
+  maxPages         = indexMaxPages;
+  stepPageNum      = indexStepPageNum;
+  firstStepPageNum = indexFirstStepPageNum;
+  lastStepPageNum  = indexLastStepPageNum;
+
+  return passed;
+}
+
 void Gui::drawPage(
     LGraphicsView  *view,
     LGraphicsScene *scene,
@@ -2789,9 +3167,18 @@ void Gui::drawPage(
 {
   QApplication::setOverrideCursor(Qt::WaitCursor);
 
+  QElapsedTimer pageTimer;
+  pageTimer.start();
+
+  // instance counts only change when a submodel changes structure
   ldrawFile.unrendered();
-  ldrawFile.countInstances();
+  pageIndex.update(ldrawFile);
+  bool recounted = pageIndex.structureChanged();
+  if (recounted) {
+      ldrawFile.countInstances();
+    }
   writeToTmp();
+  qint64 prepareTime = pageTimer.elapsed();
   Where       current(ldrawFile.topLevelFile(),0);
   maxPages    = 1;
   stepPageNum = 1;
@@ -2821,6 +3208,19 @@ void Gui::drawPage(
     }
 
   findPage(view,scene,maxPages,empty,current,pageSize,false,meta,printing,0);
+  qint64 findPageTime = pageTimer.elapsed() - prepareTime;
+
+  // findPage stopped after the display page so count the rest, and
+  // when exporting rebuild the page size table, from the page index
+  ldrawFile.unrendered();
+  current          = Where(ldrawFile.topLevelFile(),0);
+  maxPages         = 1;
+  stepPageNum      = 1;
+  firstStepPageNum = -1;
+  lastStepPageNum  = -1;
+  Meta       indexMeta;
+  PgSizeData indexPageSize;
+  indexPages(maxPages,empty,current,indexPageSize,false,indexMeta);
   topOfPages.append(current);
   maxPages--;
 
@@ -2828,6 +3228,17 @@ void Gui::drawPage(
   if (! exporting())
     setPageLineEdit->setText(string);
 
+  qint64 drawTime = pageTimer.elapsed();
+  emit messageSig(LOG_DEBUG,QString("Page %1 of %2 drawn in %3 milliseconds "
+                                    "(prepare %4%5, find page %6, page count %7).")
+                                    .arg(displayPageNum)
+                                    .arg(maxPages)
+                                    .arg(drawTime)
+                                    .arg(prepareTime)
+                                    .arg(recounted ? " with instance count" : "")
+                                    .arg(findPageTime)
+                                    .arg(drawTime - prepareTime - findPageTime));
+
   QApplication::restoreOverrideCursor();
 }
 
@@ -2932,6 +3343,8 @@ Where &Gui::bottomOfPage()
 void Gui::writeToTmp(const QString &fileName,
                      const QStringList &contents)
 {
+  PerfSpan perfSpan("tmp", "writeToTmp", fileName);
+
   QString fname = QDir::currentPath() + "/" + Paths::tmpDir + "/" + fileName;
   QFileInfo fileInfo(fname);
   if(!fileInfo.dir().exists()) {
@@ -3021,6 +3434,8 @@ void Gui::writeToTmp(const QString &fileName,
 
 void Gui::writeToTmp()
 {
+  PerfSpan perfSpan("tmp", "writeToTmp");
+
   if (Preferences::modeGUI && ! exporting()) {
       emit progressBarPermInitSig();
       emit progressPermRangeSig(1, ldrawFile._subFileOrder.size());
@@ -3229,9 +3644,18 @@ QStringList Gui::configureModelSubFile(const QStringList &contents, const QStrin
  * To get the previous content position, take the previous cisFile file size.
  * The csiFile entries are only parts with not formatting or meta commands so it is
  * well suited to provide the delta between steps.
+ *
+ * Everything before the previous step position was faded the same way for an
+ * earlier step, so the faded lines of each model are kept in fadeStepLines.
+ * A step's csi lines share their data with the previous step's, so the
+ * leading lines still shared are reused and only the lines added since are
+ * split and rewritten.  The cache holds at most one step per model and is
+ * dropped with the model file, the fade settings or the colour parts list.
  */
 QStringList Gui::configureModelStep(const QStringList &csiParts, const int &stepNum,  Where &current) {
 
+  PerfSpan perfSpan("step", "Gui::configureModelStep", current.modelName, csiParts.size());
+
   QStringList configuredCsiParts, stepColourList;
   bool doFadeStep  = page.meta.LPub.fadeStep.fadeStep.value();
   bool doHighlightStep = page.meta.LPub.highlightStep.highlightStep.value() && !suppressColourMeta();
@@ -3242,6 +3666,20 @@ QStringList Gui::configureModelStep(const QStringList &csiParts, const int &step
   if (csiParts.size() > 0 && (doHighlightFirstStep ? true : stepNum > 1)) {
 
       QString fadeColour  = LDrawColor::ldColorCode(page.meta.LPub.fadeStep.fadeColor.value());
+      bool doFadePrevious = (doHighlightFirstStep ? stepNum > 1 : true) && doFadeStep;
+
+      // faded lines depend on the fade colour, which files are submodels
+      // and which parts are static colour parts
+      QString fadeStepKey = QString("%1 %2 %3 %4 %5")
+                                    .arg(curFile)
+                                    .arg(fadeColour)
+                                    .arg(Preferences::fadeStepsUseColour)
+                                    .arg(ldrawFile.subFilesVersion())
+                                    .arg(LDrawColourParts::ldrawColorPartsVersion());
+      if (fadeStepKey != fadeStepLinesKey) {
+          fadeStepLines.clear();
+          fadeStepLinesKey = fadeStepKey;
+      }
 
       // retrieve the previous step position
       int prevStepPosition = ldrawFile.getPrevStepPosition(current.modelName);
@@ -3251,132 +3689,167 @@ QStringList Gui::configureModelStep(const QStringList &csiParts, const int &step
       // save the current step position
       ldrawFile.setPrevStepPosition(current.modelName,csiParts.size());
 
+      // reuse the faded lines made from lines this step still shares
+      FadeStepLines &fadedLines = fadeStepLines[current.modelName];
+      int reuse = 0;
+      int maxReuse = qMin(fadedLines.lines.size(), qMin(prevStepPosition, csiParts.size()));
+      while (reuse < maxReuse &&
+             csiParts.at(reuse).constData() == fadedLines.parts.at(reuse).constData())
+          reuse++;
+      fadedLines.lines.resize(reuse);
+      fadedLines.parts = csiParts;
+
       //qDebug() << "Model:" << current.modelName << ", Step:"  << stepNum << ", PrevStep Get Previous Step Position:" << prevStepPosition
       //         << ", CSI Size:" << csiParts.size() << ", Model Size:"  << ldrawFile.size(current.modelName);
       QStringList argv;
 
       for (int index = 0; index < csiParts.size(); index++) {
 
-          bool ldr = false, mpd = false, dat= false;
-          bool type_1_line = false;
-          bool type_1_5_line = false;
-          bool is_colour_part = false;
-          bool is_submodel_file = false;
-
           int updatePosition = index+1;
-          QString fileNameStr;
-          QString csiLine = csiParts[index];
-          split(csiLine, argv);
-
-          // determine line type
-          if (argv.size() && argv[0].size() == 1 &&
-              argv[0] >= "1" && argv[0] <= "5") {
-              type_1_5_line = true;
-              if (argv.size() == 15 && argv[0] == "1")
-                  type_1_line = true;
-          }
+          bool fadeLine      = doFadePrevious && (updatePosition <= prevStepPosition);
+          bool highlightLine = doHighlightStep && (updatePosition > prevStepPosition);
+
+          const QString &csiPart = csiParts.at(index);
+          FadeStepLine configured;
+
+          if (fadeLine && index < reuse) {
+              configured = fadedLines.lines.at(index);
+          } else {
+              bool ldr = false, mpd = false, dat= false;
+              bool type_1_line = false;
+              bool is_colour_part = false;
+              bool is_submodel_file = false;
+
+              QString fileNameStr;
+              QString csiLine = csiPart;
+              split(csiLine, argv);
+
+              // determine line type
+              if (argv.size() && argv[0].size() == 1 &&
+                  argv[0] >= "1" && argv[0] <= "5") {
+                  configured.type_1_5_line = true;
+                  if (argv.size() == 15 && argv[0] == "1")
+                      type_1_line = true;
+              }
 
-          if (type_1_line){
-              // process color parts naming
-              fileNameStr = argv[argv.size()-1].toLower();
+              if (type_1_line){
+                  // process color parts naming
+                  fileNameStr = argv[argv.size()-1].toLower();
 
-              // check if is color part
-              is_colour_part = ldrawColourParts.isLDrawColourPart(fileNameStr);
+                  // check if is color part
+                  is_colour_part = ldrawColourParts.isLDrawColourPart(fileNameStr);
 
-              //if (is_colour_part)
-              //    emit messageSig(LOG_NOTICE, "Static color part - " + fileNameStr);
-          }
+                  //if (is_colour_part)
+                  //    emit messageSig(LOG_NOTICE, "Static color part - " + fileNameStr);
+              }
 
-          // check if is submodel
-          if (ldrawFile.isSubmodel(fileNameStr)) {
-                 is_submodel_file = true;
-                 QString extension = QFileInfo(fileNameStr).suffix().toLower();
-                 ldr = extension == "ldr";
-                 mpd = extension == "mpd";
-                 dat = extension == "dat";
-          }
+              // check if is submodel
+              if (ldrawFile.isSubmodel(fileNameStr)) {
+                     is_submodel_file = true;
+                     QString extension = QFileInfo(fileNameStr).suffix().toLower();
+                     ldr = extension == "ldr";
+                     mpd = extension == "mpd";
+                     dat = extension == "dat";
+              }
 
-          // write fade step entries
-          if ((doHighlightFirstStep ? stepNum > 1 : true) && doFadeStep && (updatePosition <= prevStepPosition)) {
-              if (type_1_5_line) {
-                  // Insert opening fade meta
-                  if (!FadeMetaAdded && Preferences::enableFadeSteps){
-                     configuredCsiParts.insert(index,QString("0 !FADE %1").arg(Preferences::fadeStepsOpacity));
-                     FadeMetaAdded = true;
-                  }
-                  if (argv[1] != LDRAW_EDGE_MATERIAL_COLOUR &&
-                      argv[1] != LDRAW_MAIN_MATERIAL_COLOUR) {
-                      // generate fade color entry
-                      QString colourCode = Preferences::fadeStepsUseColour ? fadeColour : argv[1];
-                      if (!colourEntryExist(stepColourList,argv[1], FADE_PART))
-                        stepColourList << createColourEntry(colourCode, FADE_PART);
-                      // set fade color code
-                      argv[1] = QString("%1%2").arg(LPUB3D_COLOUR_FADE_PREFIX).arg(colourCode);
-                  }
-                  if (type_1_line) {
-                        if (is_colour_part)
-                               fileNameStr = QDir::toNativeSeparators(fileNameStr.replace(".dat", QString("%1.dat").arg(FADE_SFX)));
-                        // process subfiles naming
-                        if (is_submodel_file) {
-                               if (ldr) {
-                                 fileNameStr = fileNameStr.replace(".ldr", QString("%1.ldr").arg(FADE_SFX));
-                               } else if (mpd) {
-                                 fileNameStr = fileNameStr.replace(".mpd", QString("%1.mpd").arg(FADE_SFX));
-                               } else if (dat) {
-                                 fileNameStr = fileNameStr.replace(".dat", QString("%1.dat").arg(FADE_SFX));
-                               }
-                        }
-                        // assign fade part name
-                        argv[argv.size()-1] = fileNameStr;
-                  }
+              if (configured.type_1_5_line &&
+                  argv[1] != LDRAW_EDGE_MATERIAL_COLOUR &&
+                  argv[1] != LDRAW_MAIN_MATERIAL_COLOUR) {
+                  configured.colourCode = argv[1];
               }
-          }
-          // write highlight entries
-          if (doHighlightStep && (updatePosition > prevStepPosition)) {
-              if (type_1_5_line) {
-                  // Insert opening silhouette meta
-                  if (!SilhouetteMetaAdded && Preferences::enableHighlightStep){
-                     configuredCsiParts.append(QString("0 !SILHOUETTE %1 %2")
-                                                       .arg(Preferences::highlightStepLineWidth)
-                                                       .arg(Preferences::highlightStepColour));
-                     SilhouetteMetaAdded = true;
-                  }
-                  if (argv[1] != LDRAW_EDGE_MATERIAL_COLOUR &&
-                      argv[1] != LDRAW_MAIN_MATERIAL_COLOUR) {
-                      // generate fade color entry
-                      QString colourCode = argv[1];
-                      if (!colourEntryExist(stepColourList,argv[1], HIGHLIGHT_PART))
-                        stepColourList << createColourEntry(colourCode, HIGHLIGHT_PART);
-                      // set fade color code
-                      argv[1] = QString("%1%2").arg(LPUB3D_COLOUR_HIGHLIGHT_PREFIX).arg(colourCode);
+
+              // write fade step entries
+              if (fadeLine) {
+                  if (configured.type_1_5_line) {
+                      if (configured.colourCode.size()) {
+                          // set fade color code
+                          QString colourCode = Preferences::fadeStepsUseColour ? fadeColour : argv[1];
+                          argv[1] = QString("%1%2").arg(LPUB3D_COLOUR_FADE_PREFIX).arg(colourCode);
+                      }
+                      if (type_1_line) {
+                            if (is_colour_part)
+                                   fileNameStr = QDir::toNativeSeparators(fileNameStr.replace(".dat", QString("%1.dat").arg(FADE_SFX)));
+                            // process subfiles naming
+                            if (is_submodel_file) {
+                                   if (ldr) {
+                                     fileNameStr = fileNameStr.replace(".ldr", QString("%1.ldr").arg(FADE_SFX));
+                                   } else if (mpd) {
+                                     fileNameStr = fileNameStr.replace(".mpd", QString("%1.mpd").arg(FADE_SFX));
+                                   } else if (dat) {
+                                     fileNameStr = fileNameStr.replace(".dat", QString("%1.dat").arg(FADE_SFX));
+                                   }
+                            }
+                            // assign fade part name
+                            argv[argv.size()-1] = fileNameStr;
+                      }
                   }
-                  if (type_1_line) {
-                        if (is_colour_part)
-                               fileNameStr = QDir::toNativeSeparators(fileNameStr.replace(".dat", QString("%1.dat").arg(HIGHLIGHT_SFX)));
-                        // process subfiles naming
-                        if (is_submodel_file) {
-                               if (ldr) {
-                                 fileNameStr = fileNameStr.replace(".ldr", QString("%1.ldr").arg(HIGHLIGHT_SFX));
-                               } else if (mpd) {
-                                 fileNameStr = fileNameStr.replace(".mpd", QString("%1.mpd").arg(HIGHLIGHT_SFX));
-                               } else if (dat) {
-                                 fileNameStr = fileNameStr.replace(".dat", QString("%1.dat").arg(HIGHLIGHT_SFX));
-                               }
-                        }
-                        // assign fade part name
-                        argv[argv.size()-1] = fileNameStr;
+              }
+              // write highlight entries
+              if (highlightLine) {
+                  if (configured.type_1_5_line) {
+                      if (configured.colourCode.size()) {
+                          // set highlight color code
+                          argv[1] = QString("%1%2").arg(LPUB3D_COLOUR_HIGHLIGHT_PREFIX).arg(argv[1]);
+                      }
+                      if (type_1_line) {
+                            if (is_colour_part)
+                                   fileNameStr = QDir::toNativeSeparators(fileNameStr.replace(".dat", QString("%1.dat").arg(HIGHLIGHT_SFX)));
+                            // process subfiles naming
+                            if (is_submodel_file) {
+                                   if (ldr) {
+                                     fileNameStr = fileNameStr.replace(".ldr", QString("%1.ldr").arg(HIGHLIGHT_SFX));
+                                   } else if (mpd) {
+                                     fileNameStr = fileNameStr.replace(".mpd", QString("%1.mpd").arg(HIGHLIGHT_SFX));
+                                   } else if (dat) {
+                                     fileNameStr = fileNameStr.replace(".dat", QString("%1.dat").arg(HIGHLIGHT_SFX));
+                                   }
+                            }
+                            // assign fade part name
+                            argv[argv.size()-1] = fileNameStr;
+                      }
                   }
               }
+
+              if (isGhost(csiLine))
+                  argv.prepend(GHOST_META);
+
+              configured.line = argv.join(" ");
+
+              if (fadeLine)
+                  fadedLines.lines.append(configured);
           }
 
-          if (isGhost(csiLine))
-              argv.prepend(GHOST_META);
+          if (fadeLine && configured.type_1_5_line) {
+              // Insert opening fade meta
+              if (!FadeMetaAdded && Preferences::enableFadeSteps){
+                 configuredCsiParts.insert(index,QString("0 !FADE %1").arg(Preferences::fadeStepsOpacity));
+                 FadeMetaAdded = true;
+              }
+              // generate fade color entry
+              if (configured.colourCode.size()) {
+                  QString colourCode = Preferences::fadeStepsUseColour ? fadeColour : configured.colourCode;
+                  if (!colourEntryExist(stepColourList,configured.colourCode, FADE_PART))
+                    stepColourList << createColourEntry(colourCode, FADE_PART);
+              }
+          }
 
-          // previous step parts
-          csiLine = argv.join(" ");
+          if (highlightLine && configured.type_1_5_line) {
+              // Insert opening silhouette meta
+              if (!SilhouetteMetaAdded && Preferences::enableHighlightStep){
+                 configuredCsiParts.append(QString("0 !SILHOUETTE %1 %2")
+                                                   .arg(Preferences::highlightStepLineWidth)
+                                                   .arg(Preferences::highlightStepColour));
+                 SilhouetteMetaAdded = true;
+              }
+              // generate highlight color entry
+              if (configured.colourCode.size()) {
+                  if (!colourEntryExist(stepColourList,configured.colourCode, HIGHLIGHT_PART))
+                    stepColourList << createColourEntry(configured.colourCode, HIGHLIGHT_PART);
+              }
+          }
 
           // current step parts
-          configuredCsiParts  << csiLine;
+          configuredCsiParts  << configured.line;
 
           // Insert closing fade meta
           if (updatePosition == prevStepPosition) {